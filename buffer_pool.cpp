@@ -0,0 +1,93 @@
+#include "buffer_pool.h"
+
+#include <cstring>
+
+#include "itkSimpleFastMutexLock.h"
+#include "itkMutexLockHolder.h"
+
+#include "volume_allocator.h"
+
+namespace {
+
+itk::SimpleFastMutexLock pool_lock;
+
+typedef itk::MutexLockHolder< itk::SimpleFastMutexLock > PoolLockHolder;
+
+} // anonymous namespace
+
+bool               BufferPool::enabled = false;
+BufferPool::Buffers BufferPool::buffers;
+size_t             BufferPool::hits = 0;
+size_t             BufferPool::misses = 0;
+
+void BufferPool::set_enabled(const bool enabled)
+{
+	BufferPool::enabled = enabled;
+
+	if(!enabled)
+		clear();
+}
+
+bool BufferPool::is_enabled()
+{
+	return enabled;
+}
+
+void * BufferPool::acquire(const size_t bytes, const std::string &type, const bool zero)
+{
+	{
+		PoolLockHolder holder(pool_lock);
+
+		Buffers::iterator it = buffers.find(Key(bytes, type));
+		if(it != buffers.end() && !it->second.empty())
+		{
+			void *buffer = it->second.back();
+			it->second.pop_back();
+			++hits;
+
+			if(zero)
+				std::memset(buffer, 0, bytes);
+
+			return buffer;
+		}
+
+		++misses;
+	}
+
+	// Fresh buffers are always zero-filled (first touch).
+	return VolumeAllocator::allocate(bytes);
+}
+
+void BufferPool::release(void *buffer, const size_t bytes, const std::string &type)
+{
+	if(enabled)
+	{
+		PoolLockHolder holder(pool_lock);
+		buffers[Key(bytes, type)].push_back(buffer);
+	} else {
+		VolumeAllocator::release(buffer);
+	}
+}
+
+void BufferPool::clear()
+{
+	PoolLockHolder holder(pool_lock);
+
+	for(Buffers::iterator it = buffers.begin(); it != buffers.end(); ++it)
+	{
+		for(std::vector< void * >::iterator b = it->second.begin(); b != it->second.end(); ++b)
+			VolumeAllocator::release(*b);
+	}
+
+	buffers.clear();
+}
+
+size_t BufferPool::get_hits()
+{
+	return hits;
+}
+
+size_t BufferPool::get_misses()
+{
+	return misses;
+}
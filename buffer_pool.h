@@ -0,0 +1,57 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Keeps the pixel buffers of the released images so that the following
+ * images of the same size and pixel type reuse them instead of allocating
+ * (and page faulting) new ones. Buffers come from the VolumeAllocator.
+ */
+class BufferPool
+{
+public:
+	/**
+	 * Enable or disable the pool. Disabling it frees the retained buffers.
+	 */
+	static void set_enabled(const bool enabled);
+
+	static bool is_enabled();
+
+	/**
+	 * Get a buffer of the given size and pixel type.
+	 * @param[in] bytes The size of the buffer.
+	 * @param[in] type The name of the pixel type.
+	 * @param[in] zero Whether a reused buffer must be zero-filled.
+	 * @return The buffer, to be given back with release().
+	 */
+	static void * acquire(const size_t bytes, const std::string &type, const bool zero);
+
+	/**
+	 * Give back a buffer obtained from acquire(). It is kept for reuse if
+	 * the pool is enabled, freed otherwise.
+	 */
+	static void release(void *buffer, const size_t bytes, const std::string &type);
+
+	/**
+	 * Free all the retained buffers.
+	 */
+	static void clear();
+
+	static size_t get_hits();
+	static size_t get_misses();
+
+private:
+	typedef std::pair< size_t, std::string > Key;
+	typedef std::map< Key, std::vector< void * > > Buffers;
+
+	static bool    enabled;
+	static Buffers buffers;
+	static size_t  hits, misses;
+};
+
+#endif /* BUFFER_POOL_H */
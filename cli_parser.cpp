@@ -1,5 +1,6 @@
 #include "cli_parser.h"
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -38,6 +39,25 @@ void validate(boost::any& v, const std::vector<std::string>& values, Double*, in
 	}
 }
 
+/**
+ * Parse a comma separated list of numbers.
+ * @return false if one of them is not a number.
+ */
+static bool parse_doubles(const std::string &s, std::vector< double > &values)
+{
+	std::stringstream ss(s);
+	std::string item;
+	while(std::getline(ss, item, ','))
+	{
+		double value;
+		if(!ParseUtils::ParseDouble(value, item.c_str()))
+			return false;
+		values.push_back(value);
+	}
+
+	return true;
+}
+
 template< typename TElemType >
 std::ostream &operator<<(std::ostream &s, const std::vector< TElemType >& v)
 {
@@ -71,23 +91,128 @@ CliParser::ParseResult CliParser::parse_argv(int argc, char ** argv)
 		("help,h",
 			"Produce help message.")
 		("input-image,i",
-			po::value< std::string >(&(this->input_image))->required(),
-			"Input image.")
+			po::value< std::vector< std::string > >(&(this->input_images)),
+			"Input image, or - for a MetaImage stream on the standard input (raw pixels with --size). Can be repeated to process a batch of images. Without input image, noise volumes are generated from --size or --reference.")
 		("output-image,o",
-			po::value< std::string >(&(this->output_image))->required(),
-			"Output image.")
+			po::value< std::vector< std::string > >(&(this->output_images)),
+			"Output image, or - for a MetaImage stream on the standard output (raw pixels for a raw input). Must be repeated as many times as --input-image.")
+		("noise-output",
+			po::value< std::vector< std::string > >(&(this->noise_outputs)),
+			"Noise field of the output image, as a float image: the noise applied to each pixel before clamping, or the mask of the altered pixels for sparse and impulse noise. Must be repeated as many times as --output-image.")
 		("noise-type,n",
-			po::value< std::string >(&(this->noise_type))->required(),
-			"Noise type (gaussian, sparse-gaussian, uniform, sparse-uniform, impulse, mult-gaussian, sparse-mult-gaussian).")
+			po::value< std::string >(&(this->noise_type)),
+			"Noise type (gaussian, sparse-gaussian, uniform, sparse-uniform, impulse, mult-gaussian, sparse-mult-gaussian, poisson, rician, camera, speckle, sparse-speckle, correlated-gaussian, kspace, simplex).")
 		("stddev,s",
 			po::value< StrictlyPositiveDouble >(&(this->stddev))->default_value(32),
-			"Standard deviation of the generated noise (for gaussian noise).")
+			"Standard deviation of the generated noise (for gaussian, rician, correlated-gaussian and kspace noise).")
 		("amplitude,a",
 			po::value< StrictlyPositiveDouble >(&(this->amplitude))->default_value(32),
-			"Amplitude of the generated noise (for uniform noise).")
+			"Amplitude of the generated noise (for uniform and simplex noise).")
 		("probability,p",
 			po::value< StrictlyPositiveDouble >(&(this->probability))->default_value(0.01),
 			"Probability of the generated noise.")
+		("scale",
+			po::value< StrictlyPositiveDouble >(&(this->scale))->default_value(1),
+			"Photon count of an intensity of 1 (for poisson noise).")
+		("gain",
+			po::value< StrictlyPositiveDouble >(&(this->gain))->default_value(1),
+			"Intensity of one electron (for camera noise).")
+		("read-noise",
+			po::value< Double >(&(this->read_noise))->default_value(0),
+			"Standard deviation of the read noise, in electrons (for camera noise).")
+		("dark-offset",
+			po::value< Double >(&(this->dark_offset))->default_value(0),
+			"Intensity of a pixel without any electron (for camera noise).")
+		("looks",
+			po::value< StrictlyPositiveDouble >(&(this->looks))->default_value(1),
+			"Number of looks: the speckle variance is 1 / looks (for speckle noise).")
+		("correlation-sigma",
+			po::value< StrictlyPositiveDouble >(&(this->correlation_sigma))->default_value(1),
+			"Standard deviation in mm of the gaussian smoothing the noise (for correlated-gaussian noise).")
+		("acceleration",
+			po::value< unsigned int >(&(this->acceleration))->default_value(1),
+			"Undersampling factor of the phase encoding lines outside of the center (for kspace noise).")
+		("center-fraction",
+			po::value< Double >(&(this->center_fraction))->default_value(0.08),
+			"Fraction of the phase encoding lines always acquired at the center of k-space (for kspace noise).")
+		("frequency",
+			po::value< StrictlyPositiveDouble >(&(this->frequency))->default_value(0.05),
+			"Cycles per mm of the first octave (for simplex noise).")
+		("octaves",
+			po::value< unsigned int >(&(this->octaves))->default_value(4),
+			"Number of octaves summed (for simplex noise).")
+		("persistence",
+			po::value< StrictlyPositiveDouble >(&(this->persistence))->default_value(0.5),
+			"Amplitude ratio of an octave to the previous one (for simplex noise).")
+		("lacunarity",
+			po::value< StrictlyPositiveDouble >(&(this->lacunarity))->default_value(2),
+			"Frequency ratio of an octave to the previous one (for simplex noise).")
+		("size",
+			po::value< std::string >(&(this->size_string)),
+			"Size of the generated noise volumes, without input image, or of the raw image of the standard input (x,y,z).")
+		("spacing",
+			po::value< std::string >(&(this->spacing_string))->default_value("1,1,1"),
+			"Spacing of the generated noise volumes, without input image, or of the raw image of the standard input (x,y,z).")
+		("origin",
+			po::value< std::string >(&(this->origin_string))->default_value("0,0,0"),
+			"Origin of the generated noise volumes, without input image, or of the raw image of the standard input (x,y,z).")
+		("reference",
+			po::value< std::string >(&(this->reference_image)),
+			"Generate the noise volumes with the geometry of this image, without input image. Only its header is read.")
+		("background",
+			po::value< Double >(&(this->background))->default_value(0),
+			"Intensity to which the noise is applied in the generated noise volumes.")
+		("stream-divisions",
+			po::value< unsigned int >(&(this->stream_divisions))->default_value(1),
+			"Number of pieces in which the generated noise volumes are written, to bound the memory used (for formats supporting streaming).")
+		("slab-slices",
+			po::value< unsigned int >(&(this->slab_slices))->default_value(16),
+			"Number of slices in which an image piped from the standard input to the standard output is received, processed and sent.")
+		("huge-pages",
+			po::bool_switch(&(this->huge_pages)),
+			"Back the image buffers with transparent huge pages.")
+		("parallel-first-touch",
+			po::bool_switch(&(this->parallel_first_touch)),
+			"Initialize the image buffers with the threads that will process them (NUMA locality).")
+		("buffer-pool",
+			po::bool_switch(&(this->buffer_pool)),
+			"Reuse the image buffers across the images of a batch.")
+		("mask,m",
+			po::value< std::string >(&(this->mask_image)),
+			"Only add noise to the non-zero voxels of this image.")
+		("roi",
+			po::value< std::string >(&(this->roi_string)),
+			"Only add noise inside this region (x,y,z,size_x,size_y,size_z).")
+		("slice-range",
+			po::value< std::string >(&(this->slice_range_string)),
+			"Only process the slices from begin to end (excluded) of the input images (begin:end), keeping their indices, to split a volume between processes. The noise is the one of the whole volume.")
+		("resume",
+			po::bool_switch(&(this->resume)),
+			"Skip the slices of the series outputs recorded as written by a previous run of the same job in their journal (<serie>.journal), and only process the following ones.")
+		("kernel",
+			po::value< std::string >(&(this->kernel))->default_value("auto"),
+			"Instruction set of the integer noise kernels (auto, avx512, avx2, sse2, scalar).")
+		("rng-engine",
+			po::value< std::string >(&(this->rng_engine))->default_value("xoshiro256pp"),
+			"Random number engine (xoshiro256pp, pcg64, philox4x32, mt19937_64).")
+		("seed",
+			po::value< uint64_t >(&(this->seed))->default_value(0),
+			"Seed of the random number engine.")
+		("stats-json",
+			po::value< std::string >(&(this->stats_json)),
+			"JSON file in which to write the MSE, PSNR, SNR, saturated and corrupted pixel counts of each output image, computed while generating the noise.")
+		("estimate-noise",
+			po::bool_switch(&(this->estimate_noise)),
+			"Estimate the noise of the input images instead of adding noise, and print the --stddev and --probability giving a similar noise.")
+		("benchmark-engines",
+			po::bool_switch(&(this->benchmark_engines)),
+			"Time the noise generation with every random number engine before processing each image.")
+		("precision",
+			po::value< std::string >(&(this->precision))->default_value("double"),
+			"Floating point type of the noise computations (double, float).")
+		("color-noise",
+			po::value< std::string >(&(this->color_noise))->default_value("independent"),
+			"Noise of the color input images: drawn for each channel (independent), or drawn once on the luminance and added to the three channels (luminance).")
 		;
 
 	po::variables_map vm;
@@ -108,17 +233,161 @@ CliParser::ParseResult CliParser::parse_argv(int argc, char ** argv)
 		throw CliException(err.what());
 	}
 
+	if(this->estimate_noise) {
+		if(this->input_images.empty())
+			throw CliException("the noise estimation needs an input image");
+
+		if(!this->output_images.empty() || !this->noise_outputs.empty() || !this->stats_json.empty())
+			throw CliException("the noise estimation does not write any image");
+	} else {
+		if(this->noise_type.empty())
+			throw CliException("the option '--noise-type' is required but missing");
+
+		if(this->output_images.empty())
+			throw CliException("the option '--output-image' is required but missing");
+	}
+
+	if(this->input_images.empty()) {
+		if(this->size_string.empty() == this->reference_image.empty())
+			throw CliException("without input image, either --size or --reference is required");
+
+		if(!this->mask_image.empty() || !this->roi_string.empty())
+			throw CliException("the mask and the region of interest need an input image");
+
+		if(this->benchmark_engines)
+			throw CliException("benchmarking the engines needs an input image");
+
+		if(!this->noise_outputs.empty())
+			throw CliException("the noise field needs an input image");
+
+		if(!this->stats_json.empty())
+			throw CliException("the statistics need an input image");
+
+		if(!this->slice_range_string.empty() || this->resume)
+			throw CliException("the slice range and resuming need an input image");
+	} else {
+		if(!this->estimate_noise && this->input_images.size() != this->output_images.size())
+			throw CliException("the number of input and output images differ");
+
+		const size_t stdin_job = std::find(this->input_images.begin(), this->input_images.end(), "-") - this->input_images.begin();
+		const bool stdin_input = stdin_job < this->input_images.size();
+
+		if(std::count(this->input_images.begin(), this->input_images.end(), "-") > 1
+		   || std::count(this->output_images.begin(), this->output_images.end(), "-") > 1)
+			throw CliException("the standard input and output can only be used once");
+
+		if(std::find(this->noise_outputs.begin(), this->noise_outputs.end(), "-") != this->noise_outputs.end())
+			throw CliException("the noise field cannot be written on the standard output");
+
+		if(!this->reference_image.empty() || (!this->size_string.empty() && !stdin_input))
+			throw CliException("--size and --reference cannot be used with input images, but for a raw standard input");
+
+		if(stdin_input && (!this->mask_image.empty() || this->benchmark_engines || !this->slice_range_string.empty() || this->resume))
+			throw CliException("the mask, the benchmark, the slice range and resuming need an input file");
+
+		if(this->resume && (this->estimate_noise || !this->mask_image.empty()))
+			throw CliException("resuming cannot be used with the noise estimation or a mask");
+
+		if(stdin_input && !this->estimate_noise && this->output_images[stdin_job] == "-" && !this->noise_outputs.empty())
+			throw CliException("the noise field cannot be written for an image piped from the standard input to the standard output");
+
+		if(!this->noise_outputs.empty() && this->noise_outputs.size() != this->output_images.size())
+			throw CliException("the number of noise outputs and output images differ");
+	}
+
+	if(this->slab_slices < 1)
+		throw CliException("there must be at least one slice per slab");
+
+	if(this->stream_divisions < 1)
+		throw CliException("there must be at least one stream division");
+
+	if(this->precision != "double" && this->precision != "float")
+		throw CliException("invalid precision: " + this->precision);
+
+	if(this->color_noise != "independent" && this->color_noise != "luminance")
+		throw CliException("invalid color noise: " + this->color_noise);
+
+	if(this->read_noise < 0)
+		throw CliException("the read noise must be positive");
+
+	if(this->acceleration < 1)
+		throw CliException("the acceleration must be at least 1");
+
+	if(this->center_fraction < 0 || this->center_fraction > 1)
+		throw CliException("the center fraction must be between 0 and 1");
+
+	if(this->octaves < 1)
+		throw CliException("there must be at least one octave");
+
+	if(!this->roi_string.empty())
+	{
+		std::stringstream ss(this->roi_string);
+		std::string item;
+		while(std::getline(ss, item, ','))
+		{
+			int value;
+			if(!ParseUtils::ParseInt(value, item.c_str()))
+				throw CliException("invalid region of interest: " + this->roi_string);
+			this->roi.push_back(value);
+		}
+
+		if(this->roi.size() != 6 || this->roi[3] < 0 || this->roi[4] < 0 || this->roi[5] < 0)
+			throw CliException("invalid region of interest: " + this->roi_string);
+	}
+
+	if(!this->slice_range_string.empty())
+	{
+		const size_t colon = this->slice_range_string.find(':');
+		int begin, end;
+		if(std::string::npos == colon
+		   || !ParseUtils::ParseInt(begin, this->slice_range_string.substr(0, colon).c_str(), 10)
+		   || !ParseUtils::ParseInt(end, this->slice_range_string.substr(colon + 1).c_str(), 10)
+		   || begin < 0 || end <= begin)
+			throw CliException("invalid slice range: " + this->slice_range_string);
+
+		this->slice_range.push_back(begin);
+		this->slice_range.push_back(end);
+	}
+
+	if(!this->size_string.empty())
+	{
+		std::stringstream ss(this->size_string);
+		std::string item;
+		while(std::getline(ss, item, ','))
+		{
+			int value;
+			if(!ParseUtils::ParseInt(value, item.c_str()))
+				throw CliException("invalid size: " + this->size_string);
+			this->size.push_back(value);
+		}
+
+		if(this->size.size() != 3 || this->size[0] < 1 || this->size[1] < 1 || this->size[2] < 1)
+			throw CliException("invalid size: " + this->size_string);
+	}
+
+	if(!parse_doubles(this->spacing_string, this->spacing) || this->spacing.size() != 3
+	   || this->spacing[0] <= 0 || this->spacing[1] <= 0 || this->spacing[2] <= 0)
+		throw CliException("invalid spacing: " + this->spacing_string);
+
+	if(!parse_doubles(this->origin_string, this->origin) || this->origin.size() != 3)
+		throw CliException("invalid origin: " + this->origin_string);
+
 	return CONTINUE;
 }
 
-const std::string CliParser::get_input_image() const
+const std::vector< std::string > CliParser::get_input_images() const
 {
-	return this->input_image;
+	return this->input_images;
 }
 
-const std::string CliParser::get_output_image() const
+const std::vector< std::string > CliParser::get_output_images() const
 {
-	return this->output_image;
+	return this->output_images;
+}
+
+const std::vector< std::string > CliParser::get_noise_outputs() const
+{
+	return this->noise_outputs;
 }
 
 const std::string CliParser::get_noise_type() const
@@ -137,3 +406,139 @@ const double CliParser::get_amplitude() const {
 const double CliParser::get_probability() const {
 	return this->probability;
 }
+
+const double CliParser::get_scale() const {
+	return this->scale;
+}
+
+const double CliParser::get_gain() const {
+	return this->gain;
+}
+
+const double CliParser::get_read_noise() const {
+	return this->read_noise;
+}
+
+const double CliParser::get_dark_offset() const {
+	return this->dark_offset;
+}
+
+const double CliParser::get_looks() const {
+	return this->looks;
+}
+
+const double CliParser::get_correlation_sigma() const {
+	return this->correlation_sigma;
+}
+
+const unsigned int CliParser::get_acceleration() const {
+	return this->acceleration;
+}
+
+const double CliParser::get_center_fraction() const {
+	return this->center_fraction;
+}
+
+const double CliParser::get_frequency() const {
+	return this->frequency;
+}
+
+const unsigned int CliParser::get_octaves() const {
+	return this->octaves;
+}
+
+const double CliParser::get_persistence() const {
+	return this->persistence;
+}
+
+const double CliParser::get_lacunarity() const {
+	return this->lacunarity;
+}
+
+const std::vector< int > CliParser::get_size() const {
+	return this->size;
+}
+
+const std::vector< double > CliParser::get_spacing() const {
+	return this->spacing;
+}
+
+const std::vector< double > CliParser::get_origin() const {
+	return this->origin;
+}
+
+const std::string CliParser::get_reference_image() const {
+	return this->reference_image;
+}
+
+const double CliParser::get_background() const {
+	return this->background;
+}
+
+const unsigned int CliParser::get_stream_divisions() const {
+	return this->stream_divisions;
+}
+
+const unsigned int CliParser::get_slab_slices() const {
+	return this->slab_slices;
+}
+
+const bool CliParser::get_huge_pages() const {
+	return this->huge_pages;
+}
+
+const bool CliParser::get_parallel_first_touch() const {
+	return this->parallel_first_touch;
+}
+
+const bool CliParser::get_buffer_pool() const {
+	return this->buffer_pool;
+}
+
+const std::string CliParser::get_mask_image() const {
+	return this->mask_image;
+}
+
+const std::vector< int > CliParser::get_roi() const {
+	return this->roi;
+}
+
+const std::vector< int > CliParser::get_slice_range() const {
+	return this->slice_range;
+}
+
+const bool CliParser::get_resume() const {
+	return this->resume;
+}
+
+const std::string CliParser::get_kernel() const {
+	return this->kernel;
+}
+
+const std::string CliParser::get_rng_engine() const {
+	return this->rng_engine;
+}
+
+const uint64_t CliParser::get_seed() const {
+	return this->seed;
+}
+
+const std::string CliParser::get_stats_json() const {
+	return this->stats_json;
+}
+
+const bool CliParser::get_estimate_noise() const {
+	return this->estimate_noise;
+}
+
+const bool CliParser::get_benchmark_engines() const {
+	return this->benchmark_engines;
+}
+
+const std::string CliParser::get_precision() const {
+	return this->precision;
+}
+
+const std::string CliParser::get_color_noise() const {
+	return this->color_noise;
+}
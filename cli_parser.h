@@ -4,6 +4,7 @@
 #include <boost/program_options.hpp>
 #include <vector>
 #include <iostream>
+#include <stdint.h>
 #include <stdexcept>
 
 #include <boost/regex.hpp>
@@ -53,19 +54,94 @@ public:
 	CliParser();
 	ParseResult parse_argv(int argc, char ** argv);
 
-	const std::string get_input_image() const;
-	const std::string get_output_image() const;
+	const std::vector< std::string > get_input_images() const;
+	const std::vector< std::string > get_output_images() const;
+	const std::vector< std::string > get_noise_outputs() const;
 	const std::string get_noise_type() const;
 	const double      get_stddev() const;
 	const double      get_amplitude() const;
 	const double      get_probability() const;
+	const double      get_scale() const;
+	const double      get_gain() const;
+	const double      get_read_noise() const;
+	const double      get_dark_offset() const;
+	const double      get_looks() const;
+	const double      get_correlation_sigma() const;
+	const unsigned int get_acceleration() const;
+	const double      get_center_fraction() const;
+	const double      get_frequency() const;
+	const unsigned int get_octaves() const;
+	const double      get_persistence() const;
+	const double      get_lacunarity() const;
+	const std::vector< int > get_size() const;
+	const std::vector< double > get_spacing() const;
+	const std::vector< double > get_origin() const;
+	const std::string get_reference_image() const;
+	const double      get_background() const;
+	const unsigned int get_stream_divisions() const;
+	const unsigned int get_slab_slices() const;
+	const bool        get_huge_pages() const;
+	const bool        get_parallel_first_touch() const;
+	const bool        get_buffer_pool() const;
+	const std::string get_mask_image() const;
+	const std::vector< int > get_roi() const;
+	const std::vector< int > get_slice_range() const;
+	const bool        get_resume() const;
+	const std::string get_kernel() const;
+	const std::string get_rng_engine() const;
+	const uint64_t    get_seed() const;
+	const std::string get_stats_json() const;
+	const bool        get_estimate_noise() const;
+	const bool        get_benchmark_engines() const;
+	const std::string get_precision() const;
+	const std::string get_color_noise() const;
 
 private:
-	std::string            input_image, output_image;
+	std::vector< std::string > input_images, output_images;
+	std::vector< std::string > noise_outputs;
 	std::string            noise_type;
 	StrictlyPositiveDouble stddev;
 	StrictlyPositiveDouble amplitude;
 	StrictlyPositiveDouble probability;
+	StrictlyPositiveDouble scale;
+	StrictlyPositiveDouble gain;
+	Double                 read_noise;
+	Double                 dark_offset;
+	StrictlyPositiveDouble looks;
+	StrictlyPositiveDouble correlation_sigma;
+	unsigned int           acceleration;
+	Double                 center_fraction;
+	StrictlyPositiveDouble frequency;
+	unsigned int           octaves;
+	StrictlyPositiveDouble persistence;
+	StrictlyPositiveDouble lacunarity;
+	std::string            size_string;
+	std::vector< int >     size;
+	std::string            spacing_string;
+	std::vector< double >  spacing;
+	std::string            origin_string;
+	std::vector< double >  origin;
+	std::string            reference_image;
+	Double                 background;
+	unsigned int           stream_divisions;
+	unsigned int           slab_slices;
+	bool                   huge_pages;
+	bool                   parallel_first_touch;
+	bool                   buffer_pool;
+	std::string            mask_image;
+	std::string            roi_string;
+	std::vector< int >     roi;
+	std::string            slice_range_string;
+	std::vector< int >     slice_range;
+	bool                   resume;
+	std::string            kernel;
+	std::string            rng_engine;
+	uint64_t               seed;
+	std::string            stats_json;
+	bool                   estimate_noise;
+	bool                   benchmark_engines;
+	std::string            precision;
+	std::string            color_noise;
 };
 
 #endif /* _CLI_OPTIONS_H */
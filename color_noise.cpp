@@ -0,0 +1,131 @@
+#include "color_noise.h"
+
+#include "itkNumericTraits.h"
+
+const unsigned int ColorNoise::COMPONENTS;
+
+ImageType::Pointer ColorNoise::components(const ColorImageType::Pointer image)
+{
+	ImageType::Pointer view = create_components_geometry(image);
+
+	const size_t pixels = image->GetBufferedRegion().GetNumberOfPixels();
+
+	ImageType::PixelContainer::Pointer container = ImageType::PixelContainer::New();
+	container->SetImportPointer(reinterpret_cast< ImageType::PixelType * >(image->GetBufferPointer()), pixels * COMPONENTS, false);
+	view->SetPixelContainer(container);
+
+	return view;
+}
+
+ColorImageType::Pointer ColorNoise::from_components(const ImageType::Pointer components, const ColorImageType::Pointer reference)
+{
+	ColorImageType::Pointer view = ColorImageType::New();
+	view->CopyInformation(reference);
+	view->SetRegions(reference->GetLargestPossibleRegion());
+
+	const size_t pixels = reference->GetLargestPossibleRegion().GetNumberOfPixels();
+
+	ColorImageType::PixelContainer::Pointer container = ColorImageType::PixelContainer::New();
+	container->SetImportPointer(reinterpret_cast< ColorImageType::PixelType * >(components->GetBufferPointer()), pixels, false);
+	view->SetPixelContainer(container);
+
+	return view;
+}
+
+ImageType::Pointer ColorNoise::expand_mask(const ImageType::Pointer mask)
+{
+	ImageType::Pointer expanded = create_components_geometry(mask);
+	expanded->Allocate();
+
+	const size_t pixels = mask->GetBufferedRegion().GetNumberOfPixels();
+	const ImageType::PixelType *in = mask->GetBufferPointer();
+	ImageType::PixelType *out = expanded->GetBufferPointer();
+
+	for(size_t p = 0; p < pixels; ++p)
+		for(unsigned int c = 0; c < COMPONENTS; ++c)
+			out[p * COMPONENTS + c] = in[p];
+
+	return expanded;
+}
+
+ImageType::Pointer ColorNoise::luminance(const ColorImageType::Pointer image)
+{
+	ImageType::Pointer luminance = ImageType::New();
+	luminance->CopyInformation(image);
+	luminance->SetRegions(image->GetBufferedRegion());
+	luminance->Allocate();
+
+	const size_t pixels = image->GetBufferedRegion().GetNumberOfPixels();
+	const ImageType::PixelType *in = reinterpret_cast< const ImageType::PixelType * >(image->GetBufferPointer());
+	ImageType::PixelType *out = luminance->GetBufferPointer();
+
+	// 0.299, 0.587 and 0.114 in 8 bits fixed point, summing to 256.
+	for(size_t p = 0; p < pixels; ++p, in += COMPONENTS)
+		out[p] = static_cast< ImageType::PixelType >((77 * in[0] + 150 * in[1] + 29 * in[2] + 128) >> 8);
+
+	return luminance;
+}
+
+ColorImageType::Pointer ColorNoise::apply_luminance(const ColorImageType::Pointer image, const ImageType::Pointer luminance,
+                                                    const ImageType::Pointer noisy, itk::NoiseStatistics *statistics)
+{
+	const int minimum = itk::NumericTraits< ImageType::PixelType >::min();
+	const int maximum = itk::NumericTraits< ImageType::PixelType >::max();
+
+	ColorImageType::Pointer output = ColorImageType::New();
+	output->CopyInformation(image);
+	output->SetRegions(image->GetBufferedRegion());
+	output->Allocate();
+
+	const size_t pixels = image->GetBufferedRegion().GetNumberOfPixels();
+	const ImageType::PixelType *in = reinterpret_cast< const ImageType::PixelType * >(image->GetBufferPointer());
+	const ImageType::PixelType *before = luminance->GetBufferPointer();
+	const ImageType::PixelType *after = noisy->GetBufferPointer();
+	ImageType::PixelType *out = reinterpret_cast< ImageType::PixelType * >(output->GetBufferPointer());
+
+	if(NULL != statistics)
+		*statistics = itk::NoiseStatistics();
+
+	for(size_t p = 0; p < pixels; ++p)
+	{
+		const int change = static_cast< int >(after[p]) - static_cast< int >(before[p]);
+		for(unsigned int c = 0; c < COMPONENTS; ++c) {
+			const size_t i = p * COMPONENTS + c;
+			const int value = static_cast< int >(in[i]) + change;
+			out[i] = static_cast< ImageType::PixelType >(value < minimum ? minimum : (value > maximum ? maximum : value));
+
+			if(NULL != statistics) {
+				// As NoiseClamp() does, the values out of the bounds before the clamp are saturated.
+				const double a = in[i];
+				const double b = out[i];
+				statistics->m_SquaredError += (b - a) * (b - a);
+				statistics->m_SignalEnergy += a * a;
+				statistics->m_AtMinimum += value < minimum;
+				statistics->m_AtMaximum += value > maximum;
+			}
+		}
+	}
+
+	if(NULL != statistics)
+		statistics->m_Pixels = pixels * COMPONENTS;
+
+	return output;
+}
+
+ImageType::Pointer ColorNoise::create_components_geometry(const itk::ImageBase< __ImageDimension > *image)
+{
+	ImageType::RegionType region = image->GetBufferedRegion();
+	region.SetIndex(0, region.GetIndex(0) * COMPONENTS);
+	region.SetSize(0, region.GetSize(0) * COMPONENTS);
+
+	ImageType::SpacingType spacing = image->GetSpacing();
+	spacing[0] /= COMPONENTS;
+
+	ImageType::Pointer components = ImageType::New();
+	components->SetRegions(region);
+	components->SetSpacing(spacing);
+	components->SetOrigin(image->GetOrigin());
+	components->SetDirection(image->GetDirection());
+
+	return components;
+}
@@ -0,0 +1,81 @@
+#ifndef COLOR_NOISE_H
+#define COLOR_NOISE_H
+
+#include "common.h"
+
+#include "itkNoiseStatistics.h"
+
+/**
+ * Applies the scalar noise filters to color images, without splitting them
+ * into one image per channel.
+ *
+ * The independent noise processes the interleaved components as a scalar
+ * image whose first axis is three times longer, sharing the buffer of the
+ * color image: the runs of the noise filters then cover the three channels
+ * of a line in one loop, and each component is seeded by its own index.
+ *
+ * The luminance noise is drawn once per pixel on the luminance of the image,
+ * and the change of the luminance is added to the three channels, as the
+ * noise of a sensor before demosaicing.
+ */
+class ColorNoise
+{
+public:
+	/**
+	 * Number of components of the color pixels.
+	 */
+	static const unsigned int COMPONENTS = 3;
+
+	/**
+	 * View the components of a color image as a scalar image, whose first axis
+	 * interleaves the channels. The view shares the buffer of the image, which
+	 * must outlive it, and has the spacing along the first axis divided by the
+	 * number of components, so that it covers the same physical space.
+	 * @param[in] image The color image.
+	 */
+	static ImageType::Pointer components(const ColorImageType::Pointer image);
+
+	/**
+	 * View a scalar image of interleaved components as a color image, the
+	 * inverse of components().
+	 * @param[in] components The image of the components, which must outlive
+	 * the view.
+	 * @param[in] reference The color image whose geometry is given to the view.
+	 */
+	static ColorImageType::Pointer from_components(const ImageType::Pointer components, const ColorImageType::Pointer reference);
+
+	/**
+	 * Repeat each pixel of a mask for each component, so that it has the
+	 * geometry of the components() of the color image it masks.
+	 * @param[in] mask The mask, with the geometry of the color image.
+	 */
+	static ImageType::Pointer expand_mask(const ImageType::Pointer mask);
+
+	/**
+	 * Compute the luminance of a color image (ITU-R BT.601 weights).
+	 * @param[in] image The color image.
+	 */
+	static ImageType::Pointer luminance(const ColorImageType::Pointer image);
+
+	/**
+	 * Add to each channel of a color image the change of its luminance.
+	 * @param[in] image The color image.
+	 * @param[in] luminance The luminance() of the image.
+	 * @param[in] noisy The luminance with noise.
+	 * @param[out] statistics When not NULL, receives the statistics of the
+	 * components of the noisy color image, except their corrupted count,
+	 * which only the noise of the luminance knows.
+	 * @return The noisy color image.
+	 */
+	static ColorImageType::Pointer apply_luminance(const ColorImageType::Pointer image, const ImageType::Pointer luminance,
+	                                               const ImageType::Pointer noisy, itk::NoiseStatistics *statistics);
+
+private:
+	/**
+	 * Create a scalar image with the geometry of the components of a color
+	 * image, without pixels.
+	 */
+	static ImageType::Pointer create_components_geometry(const itk::ImageBase< __ImageDimension > *image);
+};
+
+#endif /* COLOR_NOISE_H */
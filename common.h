@@ -2,9 +2,12 @@
 #define COMMON_H
 
 #include "itkImage.h"
+#include "itkRGBPixel.h"
 
 #define __ImageDimension 3
 
 typedef itk::Image< unsigned char, __ImageDimension > ImageType;
+typedef itk::Image< float, __ImageDimension > NoiseImageType;
+typedef itk::Image< itk::RGBPixel< ImageType::PixelType >, __ImageDimension > ColorImageType;
 
 #endif /* COMMON_H */
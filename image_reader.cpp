@@ -1,40 +1,130 @@
 #include "image_reader.h"
+#include "image_stream.h"
+#include "series_index.h"
 
 #include "itkImageFileReader.h"
 #include "itkImageSeriesReader.h"
+#include "itkImageIOFactory.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
 
+#include <iostream>
 #include <ostream>
 
 #include <boost/filesystem.hpp>
-#include <boost/regex.hpp>
 
 #include "log4cxx/logger.h"
 
-typedef itk::ImageFileReader< ImageType > ITKImageReader;
-typedef itk::ImageSeriesReader< ImageType > ITKImageSeriesReader;
+ImageType::Pointer ImageReader::read(const std::string filename, const std::vector< int > &sliceRange)
+{
+	log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("main"));
+
+	if(sliceRange.empty())
+		LOG4CXX_INFO(logger, "Reading image \"" << filename << "\"");
+	else
+		LOG4CXX_INFO(logger, "Reading slices " << sliceRange[0] << " to " << sliceRange[1] - 1 << " of image \"" << filename << "\"");
+
+	if(ImageStream::is_stream(filename))
+		return readStream(false);
+
+	return load< ImageType >(filename, false, sliceRange);
+}
+
+ColorImageType::Pointer ImageReader::read_color(const std::string filename, const std::vector< int > &sliceRange)
+{
+	log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("main"));
+
+	if(sliceRange.empty())
+		LOG4CXX_INFO(logger, "Reading color image \"" << filename << "\"");
+	else
+		LOG4CXX_INFO(logger, "Reading slices " << sliceRange[0] << " to " << sliceRange[1] - 1 << " of color image \"" << filename << "\"");
+
+	if(ImageStream::is_stream(filename))
+		throw ImageReadingException("the standard input only carries scalar images");
+
+	return load< ColorImageType >(filename, false, sliceRange);
+}
 
-ImageType::Pointer ImageReader::read(const std::string filename)
+ImageType::Pointer ImageReader::read_information(const std::string filename)
 {
 	log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("main"));
 
-	LOG4CXX_INFO(logger, "Reading image \"" << filename << "\"");
+	LOG4CXX_INFO(logger, "Reading the geometry of image \"" << filename << "\"");
+
+	if(ImageStream::is_stream(filename))
+		return readStream(true);
+
+	return load< ImageType >(filename, true, std::vector< int >());
+}
+
+bool ImageReader::is_color(const std::string filename)
+{
+	if(ImageStream::is_stream(filename))
+		return false;
+
+	std::string file = filename;
+
+	try
+	{
+		// The images of a serie are assumed to have the same pixel type as the
+		// first one.
+		if(boost::filesystem::is_directory(filename)) {
+			ImageType::Pointer geometry;
+			const std::vector< SeriesIndex::Entry > entries = SeriesIndex::load(filename, geometry);
+			if(entries.empty())
+				return false;
+
+			file = (boost::filesystem::path(filename) / entries.front().name).string();
+		}
+	}
+	catch(boost::filesystem::filesystem_error &ex) {
+		std::stringstream err;
+		err << filename << " cannot be read (" << ex.what() << ")" << std::endl;
+
+		throw ImageReadingException(err.str());
+	}
+
+	itk::ImageIOBase::Pointer io = itk::ImageIOFactory::CreateImageIO(file.c_str(), itk::ImageIOFactory::ReadMode);
+	if(io.IsNull())
+		throw ImageReadingException("ITK has no reader for the image \"" + file + "\"");
+
+	try {
+		io->SetFileName(file);
+		io->ReadImageInformation();
+	}
+	catch( itk::ExceptionObject &ex )
+	{
+		std::stringstream err;
+		err << "ITK is unable to read the image \"" << file << "\" (" << ex.what() << ")";
+
+		throw ImageReadingException(err.str());
+	}
+
+	// RGBA images are read as RGB.
+	return io->GetNumberOfComponents() >= 3;
+}
+
+template< typename TImage >
+typename TImage::Pointer ImageReader::load(const std::string filename, const bool informationOnly, const std::vector< int > &sliceRange)
+{
+	log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("main"));
 
 	try
 	{
 		boost::filesystem::path path(filename);
 
 		if(boost::filesystem::exists(path)) {
-			ImageType::Pointer img;
+			typename TImage::Pointer img;
 
 			if(boost::filesystem::is_directory(path))
 			{
 				LOG4CXX_DEBUG(logger, path << " is a folder");
 
-				img = readImageSerie(filename);
+				img = readImageSerie< TImage >(filename, informationOnly, sliceRange);
 			} else {
 				LOG4CXX_DEBUG(logger, path << " is a file");
 
-				img = readImage(filename);
+				img = readImage< TImage >(filename, informationOnly, sliceRange);
 			}
 
 			LOG4CXX_INFO(logger, "Image " << path << " loaded");
@@ -55,14 +145,58 @@ ImageType::Pointer ImageReader::read(const std::string filename)
 	}
 }
 
-ImageType::Pointer ImageReader::readImage(const std::string filename)
+ImageType::Pointer ImageReader::readStream(const bool informationOnly)
 {
+	if(informationOnly)
+		throw ImageReadingException("the geometry of the standard input cannot be read without its pixels");
+
+	try {
+		return ImageStream::read(std::cin);
+	}
+	catch( ImageStreamException &ex )
+	{
+		std::stringstream err;
+		err << "Unable to read the standard input (" << ex.what() << ")";
+
+		throw ImageReadingException(err.str());
+	}
+}
+
+template< typename TImage >
+typename TImage::Pointer ImageReader::readImage(const std::string filename, const bool informationOnly, const std::vector< int > &sliceRange)
+{
+	typedef itk::ImageFileReader< TImage > ITKImageReader;
+
 	typename ITKImageReader::Pointer reader = ITKImageReader::New();
 
 	reader->SetFileName(filename);
 
+	typename TImage::RegionType region;
+
 	try {
-		reader->Update();
+		if(informationOnly) {
+			reader->UpdateOutputInformation();
+		} else if(sliceRange.empty()) {
+			reader->Update();
+		} else {
+			// Only the requested slices are decoded by the formats supporting
+			// streaming; the other ones give the whole image.
+			reader->UpdateOutputInformation();
+
+			region = reader->GetOutput()->GetLargestPossibleRegion();
+			if(static_cast< itk::SizeValueType >(sliceRange[1]) > region.GetSize(2)) {
+				std::stringstream err;
+				err << "the slice range exceeds the " << region.GetSize(2) << " slices of the image \"" << filename << "\"";
+
+				throw ImageReadingException(err.str());
+			}
+
+			region.SetIndex(2, region.GetIndex(2) + sliceRange[0]);
+			region.SetSize(2, sliceRange[1] - sliceRange[0]);
+
+			reader->GetOutput()->SetRequestedRegion(region);
+			reader->GetOutput()->Update();
+		}
 	}
 	catch( itk::ExceptionObject &ex )
 	{
@@ -72,32 +206,34 @@ ImageType::Pointer ImageReader::readImage(const std::string filename)
 		throw ImageReadingException(err.str());
 	}
 
+	if(!informationOnly && !sliceRange.empty())
+		return cropSlices< TImage >(reader->GetOutput(), region);
+
 	return reader->GetOutput();
 }
 
-ImageType::Pointer ImageReader::readImageSerie(const std::string filename)
+template< typename TImage >
+typename TImage::Pointer ImageReader::readImageSerie(const std::string filename, const bool informationOnly, const std::vector< int > &sliceRange)
 {
+	typedef itk::ImageSeriesReader< TImage > ITKImageSeriesReader;
+
 	typename ITKImageSeriesReader::Pointer reader = ITKImageSeriesReader::New();
 
 	typename ITKImageSeriesReader::FileNamesContainer filenames;
 
 	log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("main"));
 
+	std::vector< SeriesIndex::Entry > entries;
+	ImageType::Pointer geometry;
+
 	try
 	{
-		boost::filesystem::path path(filename);
-		boost::filesystem::directory_iterator end_iter;
-		boost::regex pattern(".*\\.((?:png)|(?:bmp)|(?:jpe?g))", boost::regex::icase);
+		entries = SeriesIndex::load(filename, geometry);
 
-		for( boost::filesystem::directory_iterator dir_iter(path) ; dir_iter != end_iter ; ++dir_iter)
-		{
-			boost::smatch match;
-			if( !boost::regex_match( dir_iter->path().filename().string(), match, pattern ) ) continue;
-
-			LOG4CXX_DEBUG(logger, "Reading \"" << boost::filesystem::absolute(dir_iter->path()).string() << "\"");
-
-			filenames.push_back(boost::filesystem::absolute(dir_iter->path()).string());
-		}
+		const boost::filesystem::path directory = boost::filesystem::absolute(filename);
+		filenames.reserve(entries.size());
+		for(size_t e = 0; e < entries.size(); ++e)
+			filenames.push_back((directory / entries[e].name).string());
 	}
 	catch(boost::filesystem::filesystem_error &ex) {
 		std::stringstream err;
@@ -106,12 +242,33 @@ ImageType::Pointer ImageReader::readImageSerie(const std::string filename)
 		throw ImageReadingException(err.str());
 	}
 
-	std::sort(filenames.begin(), filenames.end());
+	LOG4CXX_DEBUG(logger, "The serie located in \"" << filename << "\" has " << filenames.size() << " images");
+
+	if(informationOnly && geometry.IsNotNull()) {
+		typename TImage::Pointer image = TImage::New();
+		image->CopyInformation(geometry);
+		image->SetRegions(geometry->GetLargestPossibleRegion());
+		return image;
+	}
+
+	if(!informationOnly && !sliceRange.empty()) {
+		if(static_cast< size_t >(sliceRange[1]) > filenames.size()) {
+			std::stringstream err;
+			err << "the slice range exceeds the " << filenames.size() << " images of the serie located in \"" << filename << "\"";
+
+			throw ImageReadingException(err.str());
+		}
+
+		filenames = typename ITKImageSeriesReader::FileNamesContainer(filenames.begin() + sliceRange[0], filenames.begin() + sliceRange[1]);
+	}
 
 	reader->SetFileNames(filenames);
 
 	try {
-		reader->Update();
+		if(informationOnly)
+			reader->UpdateOutputInformation();
+		else
+			reader->Update();
 	}
 	catch( itk::ExceptionObject &ex )
 	{
@@ -121,6 +278,44 @@ ImageType::Pointer ImageReader::readImageSerie(const std::string filename)
 		throw ImageReadingException(err.str());
 	}
 
-	return reader->GetOutput();
+	typename TImage::Pointer image = reader->GetOutput();
+
+	if(geometry.IsNull() && sliceRange.empty())
+		SeriesIndex::store_geometry(filename, entries, image);
+
+	// The files of a serie have no position: the slices keep the origin of the
+	// whole image, and are moved to their index in it.
+	if(!informationOnly && !sliceRange.empty()) {
+		image->DisconnectPipeline();
+
+		typename TImage::RegionType region = image->GetLargestPossibleRegion();
+		region.SetIndex(2, sliceRange[0]);
+		image->SetRegions(region);
+	}
+
+	return image;
+}
+
+template< typename TImage >
+typename TImage::Pointer ImageReader::cropSlices(const typename TImage::Pointer image, const typename TImage::RegionType &region)
+{
+	image->DisconnectPipeline();
+
+	if(image->GetBufferedRegion() == region) {
+		image->SetLargestPossibleRegion(region);
+		return image;
+	}
+
+	typename TImage::Pointer slices = TImage::New();
+	slices->CopyInformation(image);
+	slices->SetRegions(region);
+	slices->Allocate();
+
+	itk::ImageRegionConstIterator< TImage > in(image, region);
+	itk::ImageRegionIterator< TImage > out(slices, region);
+	for( ; !in.IsAtEnd(); ++in, ++out)
+		out.Set(in.Get());
+
+	return slices;
 }
 
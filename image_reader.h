@@ -2,6 +2,7 @@
 #define IMAGE_READER_H
 
 #include <stdexcept>
+#include <vector>
 
 #include "common.h"
 
@@ -16,23 +17,79 @@ class ImageReader
 {
 public:
   /**
-   * Load an image either as a single file or as a serie of files.
+   * Load an image either as a single file, as a serie of files or as a
+   * MetaImage stream on the standard input.
+   * @param[in] filename The file to load of the folder containing the files
+   * (must exists), or "-" for the standard input.
+   * @param[in] sliceRange When not empty, the first slice and the slice after
+   * the last one to load. The image keeps the indices of the slices in the
+   * whole image, and only them are decoded when the format allows it.
+   */
+  static ImageType::Pointer read(const std::string filename, const std::vector< int > &sliceRange = std::vector< int >());
+
+  /**
+   * Load the geometry of an image (size, spacing, origin and direction)
+   * without its pixels, either from a single file or from a serie of files.
+   * @param[in] filename The file to load of the folder containing the files. Must exists.
+   */
+  static ImageType::Pointer read_information(const std::string filename);
+
+  /**
+   * Load a color image either as a single file or as a serie of files.
    * @param[in] filename The file to load of the folder containing the files. Must exists.
+   * @param[in] sliceRange The slices to load, all of them when empty.
+   */
+  static ColorImageType::Pointer read_color(const std::string filename, const std::vector< int > &sliceRange = std::vector< int >());
+
+  /**
+   * Whether an image has color pixels, read from the header of the file or of
+   * the first file of a serie. The standard input is never in color.
+   * @param[in] filename The file of the folder containing the files. Must exists.
    */
-  static ImageType::Pointer read(const std::string filename);
+  static bool is_color(const std::string filename);
 
 private:
+  /**
+   * Load an image or its geometry either as a single file or as a serie of files.
+   * @param[in] filename The file to load of the folder containing the files. Must exists.
+   * @param[in] informationOnly Only load the geometry of the image.
+   * @param[in] sliceRange The slices to load, all of them when empty.
+   */
+  template< typename TImage >
+  static typename TImage::Pointer load(const std::string filename, const bool informationOnly, const std::vector< int > &sliceRange);
+
+  /**
+   * Load an image as a MetaImage stream on the standard input.
+   * @param[in] informationOnly Only load the geometry of the image, which
+   * is not supported since the pixels would be lost.
+   */
+  static ImageType::Pointer readStream(const bool informationOnly);
+
   /**
    * Load an image as a single file.
    * @param[in] filename The file to load. Must exists.
+   * @param[in] informationOnly Only load the geometry of the image.
+   * @param[in] sliceRange The slices to load, all of them when empty.
    */
-  static ImageType::Pointer readImage(const std::string filename);
+  template< typename TImage >
+  static typename TImage::Pointer readImage(const std::string filename, const bool informationOnly, const std::vector< int > &sliceRange);
 
   /**
    * Load an image as a serie of files.
    * @param[in] filename The folder containing the files. Must be a directory.
+   * @param[in] informationOnly Only load the geometry of the image.
+   * @param[in] sliceRange The files to load, all of them when empty.
+   */
+  template< typename TImage >
+  static typename TImage::Pointer readImageSerie(const std::string filename, const bool informationOnly, const std::vector< int > &sliceRange);
+
+  /**
+   * Restrict an image to some slices, keeping their indices.
+   * @param[in] image The image, whose buffered region contains region.
+   * @param[in] region The slices to keep.
    */
-  static ImageType::Pointer readImageSerie(const std::string filename);
+  template< typename TImage >
+  static typename TImage::Pointer cropSlices(const typename TImage::Pointer image, const typename TImage::RegionType &region);
 
 };
 
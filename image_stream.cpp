@@ -0,0 +1,315 @@
+#include "image_stream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#include "log4cxx/logger.h"
+
+namespace {
+
+/**
+ * MetaImage name of a pixel type.
+ */
+template< typename TPixel > struct MetaElementType;
+template<> struct MetaElementType< unsigned char > { static const char *name() { return "MET_UCHAR"; } };
+template<> struct MetaElementType< char > { static const char *name() { return "MET_CHAR"; } };
+template<> struct MetaElementType< unsigned short > { static const char *name() { return "MET_USHORT"; } };
+template<> struct MetaElementType< short > { static const char *name() { return "MET_SHORT"; } };
+template<> struct MetaElementType< unsigned int > { static const char *name() { return "MET_UINT"; } };
+template<> struct MetaElementType< int > { static const char *name() { return "MET_INT"; } };
+template<> struct MetaElementType< float > { static const char *name() { return "MET_FLOAT"; } };
+template<> struct MetaElementType< double > { static const char *name() { return "MET_DOUBLE"; } };
+
+const char * const element_type = MetaElementType< ImageType::PixelType >::name();
+
+const unsigned int last_axis = __ImageDimension - 1;
+
+bool is_big_endian()
+{
+	const uint16_t one = 1;
+	return 0 == *reinterpret_cast< const unsigned char * >(&one);
+}
+
+std::string trim(const std::string &s)
+{
+	const size_t begin = s.find_first_not_of(" \t\r\n");
+	if(std::string::npos == begin)
+		return "";
+
+	return s.substr(begin, s.find_last_not_of(" \t\r\n") - begin + 1);
+}
+
+/**
+ * Parse a space separated list of numbers.
+ * @return false if one of them is not a number.
+ */
+bool parse_values(const std::string &s, std::vector< double > &values)
+{
+	std::istringstream ss(s);
+	double value;
+	while(ss >> value)
+		values.push_back(value);
+
+	return ss.eof();
+}
+
+/**
+ * Whether the numbers of a list are all integers of at least 1, as the
+ * dimension and the sizes of an image.
+ */
+bool are_positive_integers(const std::vector< double > &values)
+{
+	for(size_t i = 0; i < values.size(); ++i)
+		if(!(values[i] >= 1) || values[i] != std::floor(values[i])
+		   || values[i] > static_cast< double >(std::numeric_limits< itk::SizeValueType >::max()))
+			return false;
+
+	return true;
+}
+
+bool parse_bool(const std::string &s)
+{
+	return s == "True" || s == "true" || s == "1";
+}
+
+}
+
+bool ImageStream::is_stream(const std::string filename)
+{
+	return filename == "-";
+}
+
+ImageType::Pointer ImageStream::read_header(std::istream &stream, bool &swap)
+{
+	log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("main"));
+
+	unsigned int dimension = 0;
+	std::vector< double > size, spacing, origin, matrix;
+	std::string type, dataFile;
+	bool msb = false;
+	bool compressed = false;
+	std::string channels = "1";
+
+	std::string line;
+	while(dataFile.empty() && std::getline(stream, line))
+	{
+		const size_t equal = line.find('=');
+		if(std::string::npos == equal)
+			throw ImageStreamException("invalid MetaImage header line: " + line);
+
+		const std::string key = trim(line.substr(0, equal));
+		const std::string value = trim(line.substr(equal + 1));
+
+		LOG4CXX_DEBUG(logger, "MetaImage header: " << key << " = " << value);
+
+		bool valid = true;
+		if(key == "NDims") {
+			std::vector< double > values;
+			valid = parse_values(value, values) && values.size() == 1 && are_positive_integers(values) && values[0] <= __ImageDimension;
+			if(valid)
+				dimension = static_cast< unsigned int >(values[0]);
+		} else if(key == "DimSize") {
+			valid = parse_values(value, size) && are_positive_integers(size);
+		} else if(key == "ElementSpacing" || key == "ElementSize") {
+			spacing.clear();
+			valid = parse_values(value, spacing);
+		} else if(key == "Offset" || key == "Position" || key == "Origin") {
+			valid = parse_values(value, origin);
+		} else if(key == "TransformMatrix" || key == "Rotation" || key == "Orientation") {
+			valid = parse_values(value, matrix);
+		} else if(key == "ElementType") {
+			type = value;
+		} else if(key == "BinaryDataByteOrderMSB" || key == "ElementByteOrderMSB") {
+			msb = parse_bool(value);
+		} else if(key == "CompressedData") {
+			compressed = parse_bool(value);
+		} else if(key == "ElementNumberOfChannels") {
+			channels = value;
+		} else if(key == "ElementDataFile") {
+			dataFile = value;
+		}
+
+		if(!valid)
+			throw ImageStreamException("invalid MetaImage header line: " + line);
+	}
+
+	if(dataFile.empty())
+		throw ImageStreamException("the stream ended before the end of the MetaImage header");
+
+	if(dataFile != "LOCAL")
+		throw ImageStreamException("the pixels must follow the MetaImage header (ElementDataFile = LOCAL)");
+
+	if(0 == dimension || size.size() != dimension)
+		throw ImageStreamException("the MetaImage header has no valid dimension and size");
+
+	if(type != element_type)
+		throw ImageStreamException("the pixels must be of type " + std::string(element_type) + ", not " + type);
+
+	if(compressed || channels != "1")
+		throw ImageStreamException("only uncompressed scalar MetaImage streams are supported");
+
+	if((!spacing.empty() && spacing.size() != dimension) || (!origin.empty() && origin.size() != dimension)
+	   || (!matrix.empty() && matrix.size() != dimension * dimension))
+		throw ImageStreamException("the MetaImage header has an invalid geometry");
+
+	ImageType::SizeType imageSize;
+	ImageType::SpacingType imageSpacing;
+	ImageType::PointType imageOrigin;
+	ImageType::DirectionType imageDirection;
+	imageDirection.SetIdentity();
+	for(unsigned int d = 0; d < __ImageDimension; ++d) {
+		imageSize[d] = d < dimension ? static_cast< itk::SizeValueType >(size[d]) : 1;
+		imageSpacing[d] = d < dimension && !spacing.empty() ? spacing[d] : 1.0;
+		imageOrigin[d] = d < dimension && !origin.empty() ? origin[d] : 0.0;
+	}
+
+	// The columns of the direction, i.e. the axes, follow each other.
+	for(unsigned int c = 0; c < dimension && !matrix.empty(); ++c)
+		for(unsigned int r = 0; r < dimension; ++r)
+			imageDirection[r][c] = matrix[c * dimension + r];
+
+	ImageType::RegionType region;
+	region.SetSize(imageSize);
+
+	ImageType::Pointer geometry = ImageType::New();
+	geometry->SetRegions(region);
+	geometry->SetSpacing(imageSpacing);
+	geometry->SetOrigin(imageOrigin);
+	geometry->SetDirection(imageDirection);
+
+	swap = sizeof(ImageType::PixelType) > 1 && msb != is_big_endian();
+
+	return geometry;
+}
+
+void ImageStream::write_header(std::ostream &stream, const ImageType::Pointer geometry)
+{
+	const ImageType::SizeType size = geometry->GetLargestPossibleRegion().GetSize();
+	const ImageType::SpacingType spacing = geometry->GetSpacing();
+	// The origin of the stream is the one of its first pixel, for the slices
+	// of a larger image.
+	ImageType::PointType origin;
+	geometry->TransformIndexToPhysicalPoint(geometry->GetLargestPossibleRegion().GetIndex(), origin);
+	const ImageType::DirectionType direction = geometry->GetDirection();
+
+	std::ostringstream header;
+	header << std::setprecision(12);
+	header << "ObjectType = Image" << std::endl
+	       << "NDims = " << __ImageDimension << std::endl
+	       << "BinaryData = True" << std::endl
+	       << "BinaryDataByteOrderMSB = " << (is_big_endian() ? "True" : "False") << std::endl
+	       << "CompressedData = False" << std::endl;
+
+	header << "TransformMatrix =";
+	for(unsigned int c = 0; c < __ImageDimension; ++c)
+		for(unsigned int r = 0; r < __ImageDimension; ++r)
+			header << " " << direction[r][c];
+	header << std::endl;
+
+	header << "Offset =";
+	for(unsigned int d = 0; d < __ImageDimension; ++d)
+		header << " " << origin[d];
+	header << std::endl;
+
+	header << "ElementSpacing =";
+	for(unsigned int d = 0; d < __ImageDimension; ++d)
+		header << " " << spacing[d];
+	header << std::endl;
+
+	header << "DimSize =";
+	for(unsigned int d = 0; d < __ImageDimension; ++d)
+		header << " " << size[d];
+	header << std::endl;
+
+	header << "ElementType = " << element_type << std::endl
+	       << "ElementDataFile = LOCAL" << std::endl;
+
+	const std::string s = header.str();
+	stream.write(s.data(), s.size());
+	if(!stream)
+		throw ImageStreamException("cannot write the MetaImage header");
+}
+
+ImageType::Pointer ImageStream::create_slab(const ImageType::Pointer geometry, const unsigned int first, const unsigned int count)
+{
+	ImageType::RegionType region = geometry->GetLargestPossibleRegion();
+	region.SetIndex(last_axis, region.GetIndex(last_axis) + first);
+	region.SetSize(last_axis, count);
+
+	ImageType::Pointer slab = ImageType::New();
+	slab->SetRegions(region);
+	slab->SetSpacing(geometry->GetSpacing());
+	slab->SetOrigin(geometry->GetOrigin());
+	slab->SetDirection(geometry->GetDirection());
+	slab->Allocate();
+
+	return slab;
+}
+
+void ImageStream::read_slab(std::istream &stream, ImageType::Pointer slab, const bool swap)
+{
+	const size_t pixels = slab->GetBufferedRegion().GetNumberOfPixels();
+	const std::streamsize bytes = pixels * sizeof(ImageType::PixelType);
+
+	char *buffer = reinterpret_cast< char * >(slab->GetBufferPointer());
+	stream.read(buffer, bytes);
+	if(stream.gcount() != bytes)
+		throw ImageStreamException("the stream ended before the end of the image");
+
+	if(swap) {
+		for(size_t p = 0; p < pixels; ++p)
+			std::reverse(buffer + p * sizeof(ImageType::PixelType), buffer + (p + 1) * sizeof(ImageType::PixelType));
+	}
+}
+
+void ImageStream::write_slab(std::ostream &stream, const ImageType::Pointer image, const ImageType::RegionType &region)
+{
+	const ImageType::PixelType *pixels = image->GetBufferPointer() + image->ComputeOffset(region.GetIndex());
+	const std::streamsize bytes = region.GetNumberOfPixels() * sizeof(ImageType::PixelType);
+
+	stream.write(reinterpret_cast< const char * >(pixels), bytes);
+	if(!stream)
+		throw ImageStreamException("cannot write the pixels on the stream");
+}
+
+ImageType::Pointer ImageStream::read(std::istream &stream)
+{
+	bool swap;
+	ImageType::Pointer geometry = read_header(stream, swap);
+
+	ImageType::Pointer image = create_slab(geometry, 0, geometry->GetLargestPossibleRegion().GetSize(last_axis));
+	read_slab(stream, image, swap);
+
+	return image;
+}
+
+void ImageStream::write(std::ostream &stream, const ImageType::Pointer image, const unsigned int streamDivisions)
+{
+	image->UpdateOutputInformation();
+	write_header(stream, image);
+
+	const ImageType::RegionType largest = image->GetLargestPossibleRegion();
+	const itk::SizeValueType slices = largest.GetSize(last_axis);
+
+	for(unsigned int piece = 0; piece < streamDivisions; ++piece) {
+		const itk::SizeValueType first = slices * piece / streamDivisions;
+		const itk::SizeValueType end = slices * (piece + 1) / streamDivisions;
+		if(first == end)
+			continue;
+
+		ImageType::RegionType region = largest;
+		region.SetIndex(last_axis, largest.GetIndex(last_axis) + first);
+		region.SetSize(last_axis, end - first);
+
+		image->SetRequestedRegion(region);
+		image->Update();
+
+		write_slab(stream, image, region);
+	}
+
+	stream.flush();
+}
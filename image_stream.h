@@ -0,0 +1,94 @@
+#ifndef IMAGE_STREAM_H
+#define IMAGE_STREAM_H
+
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include "common.h"
+
+class ImageStreamException : public std::runtime_error
+{
+public:
+	ImageStreamException ( const std::string &err ) : std::runtime_error (err) {}
+};
+
+
+/**
+ * Images piped through the standard input and output, "-" being used as their
+ * file name. A stream is a MetaImage header ending with
+ * "ElementDataFile = LOCAL" followed by the pixels, or only the pixels when
+ * the geometry is known by other means (raw stream).
+ *
+ * The pixels are transferred in slabs of slices along the last axis, so that
+ * an image can be processed while it is received, without holding it whole.
+ */
+class ImageStream
+{
+public:
+	/**
+	 * Whether a file name designates the standard input or output.
+	 */
+	static bool is_stream(const std::string filename);
+
+	/**
+	 * Read a MetaImage header.
+	 * @param[in] stream The stream, left at the first pixel.
+	 * @param[out] swap Whether the bytes of the pixels are in the other order
+	 * than the one of this machine.
+	 * @return An image with the geometry of the header, without pixels.
+	 */
+	static ImageType::Pointer read_header(std::istream &stream, bool &swap);
+
+	/**
+	 * Write a MetaImage header.
+	 * @param[in] stream The stream.
+	 * @param[in] geometry The image whose geometry is written.
+	 */
+	static void write_header(std::ostream &stream, const ImageType::Pointer geometry);
+
+	/**
+	 * Create an image holding some slices of an image.
+	 * @param[in] geometry The whole image, whose geometry is copied.
+	 * @param[in] first The first slice, from the start of the image.
+	 * @param[in] count The number of slices.
+	 * @return An allocated image whose region is the slices, with the origin of
+	 * the whole image, so that its indices are the ones of the whole image.
+	 */
+	static ImageType::Pointer create_slab(const ImageType::Pointer geometry, const unsigned int first, const unsigned int count);
+
+	/**
+	 * Read the pixels of a slab.
+	 * @param[in] stream The stream.
+	 * @param[in] slab The image whose buffer is filled.
+	 * @param[in] swap Whether the bytes of the pixels are in the other order.
+	 */
+	static void read_slab(std::istream &stream, ImageType::Pointer slab, const bool swap = false);
+
+	/**
+	 * Write the pixels of a region spanning whole slices.
+	 * @param[in] stream The stream.
+	 * @param[in] image The image, whose buffered region contains region.
+	 * @param[in] region The slices to write.
+	 */
+	static void write_slab(std::ostream &stream, const ImageType::Pointer image, const ImageType::RegionType &region);
+
+	/**
+	 * Read a whole MetaImage stream.
+	 * @param[in] stream The stream.
+	 */
+	static ImageType::Pointer read(std::istream &stream);
+
+	/**
+	 * Write a MetaImage stream, pulling the image from its pipeline piece by
+	 * piece.
+	 * @param[in] stream The stream.
+	 * @param[in] image The image to write.
+	 * @param[in] streamDivisions The number of pieces in which the image is
+	 * requested and written.
+	 */
+	static void write(std::ostream &stream, const ImageType::Pointer image, const unsigned int streamDivisions = 1);
+};
+
+#endif /* IMAGE_STREAM_H */
@@ -1,9 +1,12 @@
 #include "image_writer.h"
+#include "image_stream.h"
+#include "series_journal.h"
 
 #include <itkImageFileWriter.h>
-#include <itkImageSeriesWriter.h>
+#include <itkExtractImageFilter.h>
 #include <itkNumericSeriesFileNames.h>
 
+#include <iostream>
 #include <ostream>
 
 #include <boost/filesystem.hpp>
@@ -11,21 +14,62 @@
 
 #include "log4cxx/logger.h"
 
-typedef itk::ImageFileWriter< ImageType> ITKImageWriter;
-typedef itk::ImageSeriesWriter< ImageType, itk::Image< unsigned char, 2 > > ITKImageSeriesWriter;
+void ImageWriter::write(const ImageType::Pointer image, const std::string filename, const unsigned int streamDivisions,
+                        const std::string journal)
+{
+	if(ImageStream::is_stream(filename)) {
+		log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("main"));
+		LOG4CXX_DEBUG(logger, "Writing image on the standard output");
 
-void ImageWriter::write(const ImageType::Pointer image, const std::string filename)
+		try {
+			ImageStream::write(std::cout, image, streamDivisions);
+		}
+		catch( ImageStreamException &ex )
+		{
+			throw ImageWritingException(ex.what());
+		}
+		catch( itk::ExceptionObject &ex )
+		{
+			throw ImageWritingException(ex.what());
+		}
+		return;
+	}
+
+	writeAny< ImageType >(image, filename, streamDivisions, journal);
+}
+
+void ImageWriter::write(const NoiseImageType::Pointer image, const std::string filename, const std::string journal)
+{
+	writeAny< NoiseImageType >(image, filename, 1, journal);
+}
+
+void ImageWriter::write(const ColorImageType::Pointer image, const std::string filename, const std::string journal)
+{
+	if(ImageStream::is_stream(filename))
+		throw ImageWritingException("the standard output only carries scalar images");
+
+	writeAny< ColorImageType >(image, filename, 1, journal);
+}
+
+bool ImageWriter::is_serie(const std::string filename)
+{
+	return std::string::npos != filename.find('%');
+}
+
+template< typename TImage >
+void ImageWriter::writeAny(const typename TImage::Pointer image, const std::string filename, const unsigned int streamDivisions,
+                           const std::string journal)
 {
 	log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("main"));
 
 	try
 	{
-		if(std::string::npos == filename.find('%')) {
+		if(!is_serie(filename)) {
 			LOG4CXX_DEBUG(logger, "Writing image in \"" << filename << "\" as a single file");
-			writeImage(image, filename);
+			writeImage< TImage >(image, filename, streamDivisions);
 		} else {
 			LOG4CXX_DEBUG(logger, "Writing image in \"" << filename << "\" as a serie");
-			writeImageSerie(image, filename);
+			writeImageSerie< TImage >(image, filename, journal);
 		}
 	} catch(boost::filesystem::filesystem_error &ex) {
 		std::stringstream err;
@@ -34,12 +78,16 @@ void ImageWriter::write(const ImageType::Pointer image, const std::string filena
 	}
 }
 
-void ImageWriter::writeImage(const ImageType::Pointer image, const std::string filename)
+template< typename TImage >
+void ImageWriter::writeImage(const typename TImage::Pointer image, const std::string filename, const unsigned int streamDivisions)
 {
+	typedef itk::ImageFileWriter< TImage > ITKImageWriter;
+
 	typename ITKImageWriter::Pointer writer = ITKImageWriter::New();
 
 	writer->SetInput(image);
 	writer->SetFileName(filename);
+	writer->SetNumberOfStreamDivisions(streamDivisions);
 
 	try {
 		writer->Update();
@@ -50,25 +98,56 @@ void ImageWriter::writeImage(const ImageType::Pointer image, const std::string f
 	}
 }
 
-void ImageWriter::writeImageSerie(const ImageType::Pointer image, const std::string filename)
+template< typename TImage >
+void ImageWriter::writeImageSerie(const typename TImage::Pointer image, const std::string filename, const std::string journal)
 {
-	typename ITKImageSeriesWriter::Pointer writer = ITKImageSeriesWriter::New();
+	typedef itk::Image< typename TImage::PixelType, 2 > SliceType;
+	typedef itk::ExtractImageFilter< TImage, SliceType > ITKSliceExtractor;
+	typedef itk::ImageFileWriter< SliceType > ITKSliceWriter;
 
 	try
 	{
-		ImageType::SizeType imageSize = image->GetLargestPossibleRegion().GetSize();
+		// The files are numbered with the indices of the slices, which do not
+		// start at 0 for the slices of a larger image.
+		const typename TImage::RegionType region = image->GetLargestPossibleRegion();
 
 		itk::NumericSeriesFileNames::Pointer outputNames = itk::NumericSeriesFileNames::New();
 		outputNames->SetSeriesFormat(filename);
-		outputNames->SetStartIndex(0);
-		outputNames->SetEndIndex(imageSize[2] - 1);
+		outputNames->SetStartIndex(region.GetIndex(2));
+		outputNames->SetEndIndex(region.GetIndex(2) + region.GetSize(2) - 1);
 
-		writer->SetInput(image);
-		writer->SetFileNames(outputNames->GetFileNames());
-		writer->Update();
+		const std::vector< std::string > &filenames = outputNames->GetFileNames();
+
+		// The slices are written one by one, and each one is recorded in the
+		// journal once its file is complete.
+		for(size_t slice = 0; slice < filenames.size(); ++slice) {
+			typename TImage::RegionType sliceRegion = region;
+			sliceRegion.SetIndex(2, region.GetIndex(2) + slice);
+			sliceRegion.SetSize(2, 0);
+
+			typename ITKSliceExtractor::Pointer extractor = ITKSliceExtractor::New();
+			extractor->SetInput(image);
+			extractor->SetExtractionRegion(sliceRegion);
+			extractor->SetDirectionCollapseToSubmatrix();
+
+			typename ITKSliceWriter::Pointer writer = ITKSliceWriter::New();
+			writer->SetInput(extractor->GetOutput());
+			writer->SetFileName(filenames[slice]);
+			writer->Update();
+
+			if(!journal.empty())
+				SeriesJournal::append(journal, region.GetIndex(2) + slice, filenames[slice]);
+		}
 	}
 	catch(boost::filesystem::filesystem_error &ex) {
 		throw ImageWritingException(ex.what());
 	}
+	catch( itk::ExceptionObject &ex )
+	{
+		throw ImageWritingException(ex.what());
+	}
+	catch( SeriesJournalException &ex )
+	{
+		throw ImageWritingException(ex.what());
+	}
 }
-
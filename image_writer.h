@@ -16,26 +16,72 @@ class ImageWriter
 {
 public:
 	/**
-	 * Write an image either as a single file or as a serie of files.
+	 * Write an image either as a single file, as a serie of files or as a
+	 * MetaImage stream on the standard output.
 	 * @param[in] image The image to write.
+	 * @param[in] filename The file or folder in which to write the image, or
+	 * "-" for the standard output.
+	 * @param[in] streamDivisions The number of pieces in which a single file or
+	 * the standard output is requested from the pipeline and written, when its
+	 * format supports it.
+	 * @param[in] journal When not empty, the SeriesJournal in which the slices
+	 * of a serie are recorded as they are written.
+	 */
+	static void write(const ImageType::Pointer image, const std::string filename, const unsigned int streamDivisions = 1,
+	                  const std::string journal = std::string());
+
+	/**
+	 * Write a noise field either as a single file or as a serie of files.
+	 * @param[in] image The noise field to write.
+	 * @param[in] filename The file or folder in which to write the noise field.
+	 * @param[in] journal When not empty, the SeriesJournal of a serie.
+	 */
+	static void write(const NoiseImageType::Pointer image, const std::string filename, const std::string journal = std::string());
+
+	/**
+	 * Write a color image either as a single file or as a serie of files.
+	 * @param[in] image The color image to write.
 	 * @param[in] filename The file or folder in which to write the image.
+	 * @param[in] journal When not empty, the SeriesJournal of a serie.
+	 */
+	static void write(const ColorImageType::Pointer image, const std::string filename, const std::string journal = std::string());
+
+	/**
+	 * Whether a file name is the one of a serie of files, i.e. has a placeholder
+	 * for the index of the slices.
 	 */
-	static void write(const ImageType::Pointer image, const std::string filename);
+	static bool is_serie(const std::string filename);
 
 private:
+	/**
+	 * Write an image of any pixel type either as a single file or as a serie of files.
+	 * @param[in] image The image to write.
+	 * @param[in] filename The file or folder in which to write the image.
+	 * @param[in] streamDivisions The number of pieces in which a single file is written.
+	 * @param[in] journal The journal of a serie, none when empty.
+	 */
+	template< typename TImage >
+	static void writeAny(const typename TImage::Pointer image, const std::string filename, const unsigned int streamDivisions,
+	                     const std::string journal);
+
 	/**
 	 * Write an image as a single file.
 	 * @param[in] image The image to write.
 	 * @param[in] filename The file in which to write the image.
+	 * @param[in] streamDivisions The number of pieces in which to write the image.
 	 */
-	static void writeImage(const ImageType::Pointer image, const std::string filename);
+	template< typename TImage >
+	static void writeImage(const typename TImage::Pointer image, const std::string filename, const unsigned int streamDivisions);
 
 	/**
 	 * Write an image as a serie of files.
 	 * @param[in] image The image to write.
 	 * @param[in] filename The folder or file with placeholder in which to write the image.
+	 * @param[in] journal The journal in which each written slice is recorded,
+	 * none when empty.
 	 */
-	static void writeImageSerie(const ImageType::Pointer image, const std::string filename);
+	template< typename TImage >
+	static void writeImageSerie(const typename TImage::Pointer image, const std::string filename, const std::string journal);
 
 };
 
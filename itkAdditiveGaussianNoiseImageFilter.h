@@ -1,9 +1,8 @@
 #ifndef __itkAdditiveGaussianNoiseImageFilter
 #define __itkAdditiveGaussianNoiseImageFilter
 
-#include <itkUnaryFunctorImageFilter.h>
+#include "itkNoiseImageFilter.h"
 #include <itkConceptChecking.h>
-#include <vnl/vnl_sample.h>
 
 namespace itk
 {
@@ -13,10 +12,12 @@ namespace Functor
  * \brief Adds additive gaussian noise to a pixel.
  * \ingroup ITKImageIntensity
  */
-template< class TInput, class TOutput >
+template< class TInput, class TOutput, class TRealType = double >
 class AdditiveGaussianNoise
 {
 public:
+  typedef TRealType RealType;
+
   AdditiveGaussianNoise()
     {
     m_Mean = 0.0;
@@ -34,14 +35,14 @@ public:
     { return m_StandardDeviation; }
 
   void SetMean(const double mean)
-    { m_Mean = mean; }
+    { m_Mean = static_cast< RealType >( mean ); }
 
   void SetStandardDeviation(const double standardDeviation)
     {
     if(standardDeviation <= 0.0)
       itkGenericExceptionMacro("standard deviation must be strictly positive");
 
-    m_StandardDeviation = standardDeviation;
+    m_StandardDeviation = static_cast< RealType >( standardDeviation );
     }
 
   TOutput GetOutputMinimum() const
@@ -72,35 +73,77 @@ public:
     return !( *this != other );
     }
 
-  inline TOutput operator()(const TInput & A) const
+  /** Flags of the variant of Evaluate() matching the parameters. */
+  unsigned int GetVariant() const
+    {
+    unsigned int variant = 0;
+    if ( !NoiseClampIsNeeded< TOutput, RealType >(m_OutputMinimum, m_OutputMaximum) )
+      {
+      variant |= NoiseVariantNoClamp;
+      }
+    if ( m_Mean == 0 )
+      {
+      variant |= NoiseVariantZeroMean;
+      }
+    return variant;
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine) const
+    {
+    float noise;
+    return Evaluate< VVariant >(A, engine, noise);
+    }
+
+  /** Noisy value of a pixel, and the gaussian noise added to it. */
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine, float & noise) const
+    {
+    RealType n = m_StandardDeviation * NormalVariate< RealType >(engine);
+    if ( !( VVariant & NoiseVariantZeroMean ) )
+      {
+      n += m_Mean;
+      }
+
+    noise = static_cast< float >( n );
+    const RealType v = static_cast< RealType >( A ) + n;
+    return NoiseClamp< VVariant >(v, m_OutputMinimum, m_OutputMaximum);
+    }
+
+  template< class TEngine >
+  inline TOutput operator()(const TInput & A, TEngine & engine) const
     {
-    double v = A + vnl_sample_normal(m_Mean, m_StandardDeviation);
-    return static_cast<TOutput>(v < m_OutputMinimum ? m_OutputMinimum : (v > m_OutputMaximum ? m_OutputMaximum : v));
+    return Evaluate< 0 >(A, engine);
     }
 
 private:
   TOutput m_OutputMinimum;
   TOutput m_OutputMaximum;
-  double m_Mean;
-  double m_StandardDeviation;
+  RealType m_Mean;
+  RealType m_StandardDeviation;
 };
 } // End namespace Functor
 
-template< class TInputImage, class TOutputImage >
+template< class TInputImage, class TOutputImage, class TEngine = Xoshiro256PlusPlusEngine,
+          class TRealType = double >
 class ITK_EXPORT AdditiveGaussianNoiseImageFilter:
   public
-  UnaryFunctorImageFilter< TInputImage, TOutputImage,
-                           Functor::AdditiveGaussianNoise<
-                             typename TInputImage::PixelType,
-                             typename TOutputImage::PixelType > >
+  NoiseImageFilter< TInputImage, TOutputImage,
+                    Functor::AdditiveGaussianNoise<
+                      typename TInputImage::PixelType,
+                      typename TOutputImage::PixelType,
+                      TRealType >,
+                    TEngine >
 {
 public:
   /** Standard class typedefs. */
   typedef AdditiveGaussianNoiseImageFilter Self;
-  typedef UnaryFunctorImageFilter<
+  typedef NoiseImageFilter<
     TInputImage, TOutputImage,
     Functor::AdditiveGaussianNoise< typename TInputImage::PixelType,
-                                    typename TOutputImage::PixelType > >  Superclass;
+                                    typename TOutputImage::PixelType,
+                                    TRealType >,
+    TEngine >  Superclass;
 
   typedef SmartPointer< Self >       Pointer;
   typedef SmartPointer< const Self > ConstPointer;
@@ -111,7 +154,7 @@ public:
   itkNewMacro(Self);
 
   /** Macro that provides the GetNameOfClass() method */
-  itkTypeMacro(AdditiveGaussianNoiseImageFilter, UnaryFunctorImageFilter);
+  itkTypeMacro(AdditiveGaussianNoiseImageFilter, NoiseImageFilter);
 
   OutputPixelType GetOutputMinimum() const
     {
@@ -0,0 +1,390 @@
+#ifndef __itkAdditiveSimplexNoiseImageFilter
+#define __itkAdditiveSimplexNoiseImageFilter
+
+#include "itkNoiseImageFilter.h"
+#include "itkSimplexNoiseImageSource.h"
+#include <itkConceptChecking.h>
+
+#include <algorithm>
+
+namespace itk
+{
+namespace Functor
+{
+/** \class AdditiveSimplexNoise
+ * \brief Adds Amplitude times a fractal simplex noise texture to a pixel.
+ * The texture depends on the position of the pixel, which
+ * AdditiveSimplexNoiseImageFilter gives to Apply(). Used alone through
+ * Evaluate(), the functor adds the texture of a random point.
+ * \ingroup ITKImageIntensity
+ */
+template< class TInput, class TOutput, class TRealType = double >
+class AdditiveSimplexNoise
+{
+public:
+  typedef TRealType RealType;
+
+  AdditiveSimplexNoise()
+    {
+    m_Amplitude = 1.0;
+    m_OutputMinimum = itk::NumericTraits< TOutput >::NonpositiveMin();
+    m_OutputMaximum = itk::NumericTraits< TOutput >::max();
+    }
+
+  ~AdditiveSimplexNoise() {}
+
+  double GetAmplitude() const
+    { return m_Amplitude; }
+
+  void SetAmplitude(const double amplitude)
+    {
+    if(amplitude <= 0.0)
+      itkGenericExceptionMacro("amplitude must be strictly positive");
+
+    m_Amplitude = static_cast< RealType >( amplitude );
+    }
+
+  SimplexNoiseTexture & GetTexture()
+    { return m_Texture; }
+
+  const SimplexNoiseTexture & GetTexture() const
+    { return m_Texture; }
+
+  TOutput GetOutputMinimum() const
+    { return m_OutputMinimum; }
+
+  TOutput GetOutputMaximum() const
+    { return m_OutputMaximum; }
+
+  void SetOutputBounds( const TOutput min, const TOutput max)
+    {
+    if(max <= min)
+      itkGenericExceptionMacro("invalid bounds: [" << min << "; " << max << "]");
+
+    m_OutputMinimum = min;
+    m_OutputMaximum = max;
+    }
+
+  bool operator!=(const AdditiveSimplexNoise &other) const
+    {
+    return m_Amplitude != other.m_Amplitude
+      || m_Texture != other.m_Texture
+      || m_OutputMaximum != other.m_OutputMaximum
+      || m_OutputMinimum != other.m_OutputMinimum;
+    }
+
+  bool operator==(const AdditiveSimplexNoise & other) const
+    {
+    return !( *this != other );
+    }
+
+  /** Flags of the variant of Evaluate() matching the parameters. */
+  unsigned int GetVariant() const
+    {
+    unsigned int variant = 0;
+    if ( !NoiseClampIsNeeded< TOutput, RealType >(m_OutputMinimum, m_OutputMaximum) )
+      {
+      variant |= NoiseVariantNoClamp;
+      }
+    return variant;
+    }
+
+  /** Noisy value of a pixel, given the texture at its position. */
+  template< unsigned int VVariant >
+  inline TOutput Apply(const TInput & A, const float texture) const
+    {
+    float noise;
+    return Apply< VVariant >(A, texture, noise);
+    }
+
+  /** Noisy value of a pixel, and the texture added to it. */
+  template< unsigned int VVariant >
+  inline TOutput Apply(const TInput & A, const float texture, float & noise) const
+    {
+    const RealType n = m_Amplitude * static_cast< RealType >( texture );
+    noise = static_cast< float >( n );
+    const RealType v = static_cast< RealType >( A ) + n;
+    return NoiseClamp< VVariant >(v, m_OutputMinimum, m_OutputMaximum);
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine) const
+    {
+    float noise;
+    return Evaluate< VVariant >(A, engine, noise);
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine, float & noise) const
+    {
+    const double point[3] = { 1024.0 * UniformVariate< double >(engine),
+                              1024.0 * UniformVariate< double >(engine),
+                              1024.0 * UniformVariate< double >(engine) };
+    float texture;
+    m_Texture.EvaluateRow(&texture, 1, 0, point, 0.0);
+    return Apply< VVariant >(A, texture, noise);
+    }
+
+  template< class TEngine >
+  inline TOutput operator()(const TInput & A, TEngine & engine) const
+    {
+    return Evaluate< 0 >(A, engine);
+    }
+
+private:
+  TOutput m_OutputMinimum;
+  TOutput m_OutputMaximum;
+  RealType m_Amplitude;
+  SimplexNoiseTexture m_Texture;
+};
+} // End namespace Functor
+
+/** \class AdditiveSimplexNoiseImageFilter
+ * \brief Adds a fractal simplex noise texture to the pixels (see
+ * SimplexNoiseTexture), to give a structured background to an image.
+ * The texture is evaluated by blocks of pixels of a run with the SIMD
+ * kernel, at the physical position of the pixels in the image axes. The
+ * seed of the filter is the seed of the texture.
+ * \ingroup ITKImageIntensity
+ */
+template< class TInputImage, class TOutputImage, class TEngine = Xoshiro256PlusPlusEngine,
+          class TRealType = double >
+class ITK_EXPORT AdditiveSimplexNoiseImageFilter:
+  public
+  NoiseImageFilter< TInputImage, TOutputImage,
+                    Functor::AdditiveSimplexNoise<
+                      typename TInputImage::PixelType,
+                      typename TOutputImage::PixelType,
+                      TRealType >,
+                    TEngine >
+{
+public:
+  /** Standard class typedefs. */
+  typedef AdditiveSimplexNoiseImageFilter Self;
+  typedef NoiseImageFilter<
+    TInputImage, TOutputImage,
+    Functor::AdditiveSimplexNoise< typename TInputImage::PixelType,
+                                   typename TOutputImage::PixelType,
+                                   TRealType >,
+    TEngine >  Superclass;
+
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  typedef typename Superclass::InputImagePixelType  InputImagePixelType;
+  typedef typename Superclass::OutputImagePixelType OutputImagePixelType;
+  typedef typename Superclass::IndexType            IndexType;
+  typedef typename Superclass::NoisePixelType       NoisePixelType;
+  typedef typename TOutputImage::PixelType          OutputPixelType;
+  typedef TRealType                                 RealType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int, TOutputImage::ImageDimension);
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Macro that provides the GetNameOfClass() method */
+  itkTypeMacro(AdditiveSimplexNoiseImageFilter, NoiseImageFilter);
+
+  OutputPixelType GetOutputMinimum() const
+    {
+    return this->GetFunctor().GetOutputMinimum();
+    }
+
+  OutputPixelType GetOutputMaximum() const
+    {
+    return this->GetFunctor().GetOutputMaximum();
+    }
+
+  double GetAmplitude() const
+    { return this->GetFunctor().GetAmplitude(); }
+
+  double GetFrequency() const
+    { return this->GetFunctor().GetTexture().GetFrequency(); }
+
+  unsigned int GetOctaves() const
+    { return this->GetFunctor().GetTexture().GetOctaves(); }
+
+  double GetPersistence() const
+    { return this->GetFunctor().GetTexture().GetPersistence(); }
+
+  double GetLacunarity() const
+    { return this->GetFunctor().GetTexture().GetLacunarity(); }
+
+  void SetOutputBounds(const OutputPixelType min, const OutputPixelType max)
+    {
+    if ( min == this->GetFunctor().GetOutputMinimum() && max == this->GetFunctor().GetOutputMaximum())
+      {
+      return;
+      }
+
+    this->GetFunctor().SetOutputBounds(min, max);
+    this->Modified();
+    }
+
+  void SetAmplitude(const double amplitude)
+    {
+    if ( amplitude == this->GetFunctor().GetAmplitude() )
+      {
+      return;
+      }
+
+    this->GetFunctor().SetAmplitude(amplitude);
+    this->Modified();
+    }
+
+  /** Cycles per physical unit of the first octave. */
+  void SetFrequency(const double frequency)
+    {
+    if ( frequency == this->GetFrequency() )
+      {
+      return;
+      }
+
+    this->GetFunctor().GetTexture().SetFrequency(frequency);
+    this->Modified();
+    }
+
+  void SetOctaves(const unsigned int octaves)
+    {
+    if ( octaves == this->GetOctaves() )
+      {
+      return;
+      }
+
+    this->GetFunctor().GetTexture().SetOctaves(octaves);
+    this->Modified();
+    }
+
+  /** Amplitude ratio of an octave to the previous one. */
+  void SetPersistence(const double persistence)
+    {
+    if ( persistence == this->GetPersistence() )
+      {
+      return;
+      }
+
+    this->GetFunctor().GetTexture().SetPersistence(persistence);
+    this->Modified();
+    }
+
+  /** Frequency ratio of an octave to the previous one. */
+  void SetLacunarity(const double lacunarity)
+    {
+    if ( lacunarity == this->GetLacunarity() )
+      {
+      return;
+      }
+
+    this->GetFunctor().GetTexture().SetLacunarity(lacunarity);
+    this->Modified();
+    }
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+    {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "Amplitude: " << static_cast<typename NumericTraits<double>::PrintType>(GetAmplitude()) << std::endl;
+    os << indent << "Frequency: " << GetFrequency() << std::endl;
+    os << indent << "Octaves: " << GetOctaves() << std::endl;
+    os << indent << "Persistence: " << GetPersistence() << std::endl;
+    os << indent << "Lacunarity: " << GetLacunarity() << std::endl;
+    os << indent << "OutputMinimum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMinimum()) << std::endl;
+    os << indent << "OutputMaximum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMaximum()) << std::endl;
+    }
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  itkConceptMacro( InputConvertibleToDoubleCheck,
+    ( Concept::Convertible< typename TInputImage::PixelType, double > ) );
+  itkConceptMacro( DoubleConvertibleToOutputCheck,
+    ( Concept::Convertible< double, OutputPixelType > ) );
+#endif
+
+protected:
+  AdditiveSimplexNoiseImageFilter() {}
+  virtual ~AdditiveSimplexNoiseImageFilter() {}
+
+  void BeforeThreadedGenerateData()
+    {
+    if ( ImageDimension > 3 )
+      {
+      itkExceptionMacro("images of more than 3 dimensions are not supported");
+      }
+
+    this->GetFunctor().GetTexture().SetSeed( this->GetSeed() );
+    Superclass::BeforeThreadedGenerateData();
+    }
+
+  void ProcessRun(const InputImagePixelType *in,
+                  OutputImagePixelType *out,
+                  NoisePixelType *noise,
+                  SizeValueType length,
+                  const IndexType & start) const
+    {
+    if ( this->GetFunctorVariant() & Functor::NoiseVariantNoClamp )
+      {
+      this->ProcessRunVariant< Functor::NoiseVariantNoClamp >(in, out, noise, length, start);
+      }
+    else if ( this->GetFunctorVariant() & Functor::NoiseVariantStatistics )
+      {
+      this->ProcessRunVariant< Functor::NoiseVariantStatistics >(in, out, noise, length, start);
+      }
+    else
+      {
+      this->ProcessRunVariant< 0 >(in, out, noise, length, start);
+      }
+    }
+
+private:
+  AdditiveSimplexNoiseImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+
+  template< unsigned int VVariant >
+  void ProcessRunVariant(const InputImagePixelType *in,
+                         OutputImagePixelType *out,
+                         NoisePixelType *noise,
+                         SizeValueType length,
+                         const IndexType & start) const
+    {
+    const typename Superclass::FunctorType & functor = this->GetFunctor();
+    const TOutputImage *outputPtr = this->GetOutput();
+    const typename TOutputImage::PointType & origin = outputPtr->GetOrigin();
+    const typename TOutputImage::SpacingType & spacing = outputPtr->GetSpacing();
+
+    double point[3] = { origin[0], 0.0, 0.0 };
+    for ( unsigned int d = 1; d < ImageDimension && d < 3; ++d )
+      {
+      point[d] = origin[d] + start[d] * spacing[d];
+      }
+
+    // Pixels whose texture is evaluated at once.
+    const SizeValueType blockSize = 256;
+
+    float texture[blockSize];
+
+    for ( SizeValueType offset = 0; offset < length; offset += blockSize )
+      {
+      const SizeValueType count = std::min(blockSize, length - offset);
+
+      functor.GetTexture().EvaluateRow( texture, count, static_cast< SizeValueType >( start[0] ) + offset,
+                                        point, spacing[0] );
+
+      if ( noise )
+        {
+        for ( SizeValueType i = 0; i < count; ++i )
+          {
+          out[offset + i] = functor.template Apply< VVariant >(in[offset + i], texture[i], noise[offset + i]);
+          }
+        continue;
+        }
+
+      for ( SizeValueType i = 0; i < count; ++i )
+        {
+        out[offset + i] = functor.template Apply< VVariant >(in[offset + i], texture[i]);
+        }
+      }
+    }
+};
+
+} // End namespace itk
+
+#endif /* __itkAdditiveSimplexNoiseImageFilter */
@@ -1,9 +1,12 @@
 #ifndef __itkAdditiveUniformNoiseImageFilter
 #define __itkAdditiveUniformNoiseImageFilter
 
-#include <itkUnaryFunctorImageFilter.h>
+#include "itkNoiseImageFilter.h"
 #include <itkConceptChecking.h>
-#include <vnl/vnl_sample.h>
+
+#include <cmath>
+
+#include "noise_kernels.h"
 
 namespace itk
 {
@@ -13,10 +16,12 @@ namespace Functor
  * \brief Adds additive uniform noise to a pixel.
  * \ingroup ITKImageIntensity
  */
-template< class TInput, class TOutput >
+template< class TInput, class TOutput, class TRealType = double >
 class AdditiveUniformNoise
 {
 public:
+  typedef TRealType RealType;
+
   AdditiveUniformNoise()
     {
     m_Mean = 0.0;
@@ -35,7 +40,7 @@ public:
 
   void SetMean(const double mean)
     {
-    m_Mean = mean;
+    m_Mean = static_cast< RealType >( mean );
     ComputeNoiseRange();
     }
 
@@ -44,7 +49,7 @@ public:
     if(amplitude < 0.0)
       itkGenericExceptionMacro("amplitude must be positive");
 
-    m_Amplitude = amplitude;
+    m_Amplitude = static_cast< RealType >( amplitude );
     ComputeNoiseRange();
     }
 
@@ -76,10 +81,38 @@ public:
     return !( *this != other );
     }
 
-  inline TOutput operator()(const TInput & A) const
+  /** Flags of the variant of Evaluate() matching the parameters. */
+  unsigned int GetVariant() const
     {
-    const double v = A + vnl_sample_uniform(m_NoiseMin, m_NoiseMax);
-    return static_cast<TOutput>(v < m_OutputMinimum ? m_OutputMinimum : (v > m_OutputMaximum ? m_OutputMaximum : v));
+    unsigned int variant = 0;
+    if ( !NoiseClampIsNeeded< TOutput, RealType >(m_OutputMinimum, m_OutputMaximum) )
+      {
+      variant |= NoiseVariantNoClamp;
+      }
+    return variant;
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine) const
+    {
+    float noise;
+    return Evaluate< VVariant >(A, engine, noise);
+    }
+
+  /** Noisy value of a pixel, and the uniform noise added to it, before
+   * clamping. */
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine, float & noise) const
+    {
+    const RealType v = static_cast< RealType >( A ) + ( m_NoiseMin + ( m_NoiseMax - m_NoiseMin ) * UniformVariate< RealType >(engine) );
+    noise = static_cast< float >( v - static_cast< RealType >( A ) );
+    return NoiseClamp< VVariant >(v, m_OutputMinimum, m_OutputMaximum);
+    }
+
+  template< class TEngine >
+  inline TOutput operator()(const TInput & A, TEngine & engine) const
+    {
+    return Evaluate< 0 >(A, engine);
     }
 
 private:
@@ -92,40 +125,50 @@ private:
 private:
   TOutput m_OutputMinimum;
   TOutput m_OutputMaximum;
-  double m_Mean;
-  double m_Amplitude;
+  RealType m_Mean;
+  RealType m_Amplitude;
 
-  double m_NoiseMin;
-  double m_NoiseMax;
+  RealType m_NoiseMin;
+  RealType m_NoiseMax;
 };
 } // End namespace Functor
 
-template< class TInputImage, class TOutputImage >
+template< class TInputImage, class TOutputImage, class TEngine = Xoshiro256PlusPlusEngine,
+          class TRealType = double >
 class ITK_EXPORT AdditiveUniformNoiseImageFilter:
   public
-  UnaryFunctorImageFilter< TInputImage, TOutputImage,
-                           Functor::AdditiveUniformNoise<
-                             typename TInputImage::PixelType,
-                             typename TOutputImage::PixelType > >
+  NoiseImageFilter< TInputImage, TOutputImage,
+                    Functor::AdditiveUniformNoise<
+                      typename TInputImage::PixelType,
+                      typename TOutputImage::PixelType,
+                      TRealType >,
+                    TEngine >
 {
 public:
   /** Standard class typedefs. */
   typedef AdditiveUniformNoiseImageFilter Self;
-  typedef UnaryFunctorImageFilter<
+  typedef NoiseImageFilter<
     TInputImage, TOutputImage,
     Functor::AdditiveUniformNoise< typename TInputImage::PixelType,
-                                    typename TOutputImage::PixelType > >  Superclass;
+                                    typename TOutputImage::PixelType,
+                                    TRealType >,
+    TEngine >  Superclass;
 
   typedef SmartPointer< Self >       Pointer;
   typedef SmartPointer< const Self > ConstPointer;
 
   typedef typename TOutputImage::PixelType OutputPixelType;
 
+  typedef typename Superclass::InputImagePixelType  InputImagePixelType;
+  typedef typename Superclass::OutputImagePixelType OutputImagePixelType;
+  typedef typename Superclass::IndexType            IndexType;
+  typedef typename Superclass::NoisePixelType       NoisePixelType;
+
   /** Method for creation through the object factory. */
   itkNewMacro(Self);
 
   /** Macro that provides the GetNameOfClass() method */
-  itkTypeMacro(AdditiveUniformNoiseImageFilter, UnaryFunctorImageFilter);
+  itkTypeMacro(AdditiveUniformNoiseImageFilter, NoiseImageFilter);
 
   OutputPixelType GetOutputMinimum() const
     {
@@ -196,9 +239,70 @@ protected:
   AdditiveUniformNoiseImageFilter() {}
   virtual ~AdditiveUniformNoiseImageFilter() {}
 
+  /** unsigned char runs use the integer kernel when possible, which also
+   * writes the noise field. */
+  virtual void ProcessRun(const InputImagePixelType *in,
+                          OutputImagePixelType *out,
+                          NoisePixelType *noise,
+                          SizeValueType length,
+                          const IndexType & start) const
+    {
+    if ( !this->ProcessIntegerRun( in, out, noise, length, start, static_cast< TEngine * >( ITK_NULLPTR ) ) )
+      {
+      Superclass::ProcessRun(in, out, noise, length, start);
+      }
+    }
+
 private:
   AdditiveUniformNoiseImageFilter(const Self &); //purposely not implemented
   void operator=(const Self &);     //purposely not implemented
+
+  template< class TIn, class TOut, class TRunEngine >
+  bool ProcessIntegerRun(const TIn *, TOut *, NoisePixelType *, SizeValueType, const IndexType &, TRunEngine *) const
+    {
+    return false;
+    }
+
+  /** unsigned char images use the integer kernel when the noise range
+   * bounds are integers, which gives the same distribution. The noise
+   * field then holds the integer offset added to each pixel.
+   * Only used with the engine of the kernels. */
+  bool ProcessIntegerRun(const unsigned char *in, unsigned char *out, NoisePixelType *noise,
+                         SizeValueType length, const IndexType & start,
+                         NoiseKernels::EngineType *) const
+    {
+    const double noiseMin = this->GetMean() - this->GetAmplitude();
+    const double range = 2.0 * this->GetAmplitude();
+
+    if ( noiseMin != std::floor(noiseMin) || range != std::floor(range)
+         || range < 1.0 || range > NoiseKernels::MAX_UNIFORM_RANGE
+         || std::fabs(noiseMin) > NoiseKernels::MAX_UNIFORM_RANGE )
+      {
+      return false;
+      }
+
+    NoiseKernels::EngineType engine;
+    this->SeedRunEngine(engine, start);
+
+    NoiseKernels::additive_uniform_u8(in, out, noise, length,
+                                      static_cast< int >( noiseMin ), static_cast< unsigned int >( range ),
+                                      this->GetOutputMinimum(), this->GetOutputMaximum(),
+                                      engine);
+
+    // The kernel clamps in + offset, so the saturation is counted from the
+    // noise field, which GenerateLines() provides with the statistics.
+    if ( noise && ( this->GetFunctorVariant() & Functor::NoiseVariantStatistics ) )
+      {
+      Functor::NoiseCounts & counts = Functor::NoiseCountsOfThread();
+      for ( SizeValueType i = 0; i < length; ++i )
+        {
+        const int v = static_cast< int >( in[i] ) + static_cast< int >( noise[i] );
+        counts.m_BelowMinimum += v < static_cast< int >( this->GetOutputMinimum() );
+        counts.m_AboveMaximum += v > static_cast< int >( this->GetOutputMaximum() );
+        }
+      }
+    return true;
+    }
 };
 
 } // End namespace itk
@@ -0,0 +1,435 @@
+#ifndef __itkCameraNoiseImageFilter
+#define __itkCameraNoiseImageFilter
+
+#include "itkPoissonNoiseImageFilter.h"
+#include <itkConceptChecking.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+namespace Functor
+{
+/** \class CameraNoise
+ * \brief Replaces a pixel by the reading of a camera sensor.
+ * The pixel value divided by the gain is the mean electron count. The
+ * output is gain * (shot + read) + dark offset, where the shot count is a
+ * Poisson realization and the read noise is gaussian (in electrons),
+ * rounded to the nearest integer when quantization is on (the default).
+ *
+ * The shot counts are drawn by a PoissonIntensitySampler, whose tables are
+ * computed by Initialize().
+ * \ingroup ITKImageIntensity
+ */
+template< class TInput, class TOutput, class TRealType = double >
+class CameraNoise
+{
+public:
+  typedef TRealType RealType;
+
+  CameraNoise()
+    {
+    m_Gain = 1.0;
+    m_ReadNoise = 0.0;
+    m_DarkOffset = 0.0;
+    m_Quantization = true;
+    m_OutputMinimum = itk::NumericTraits< TOutput >::NonpositiveMin();
+    m_OutputMaximum = itk::NumericTraits< TOutput >::max();
+    }
+
+  ~CameraNoise() {}
+
+  double GetGain() const
+    { return m_Gain; }
+
+  double GetReadNoise() const
+    { return m_ReadNoise; }
+
+  double GetDarkOffset() const
+    { return m_DarkOffset; }
+
+  bool GetQuantization() const
+    { return m_Quantization; }
+
+  void SetGain(const double gain)
+    {
+    if(gain <= 0.0)
+      itkGenericExceptionMacro("gain must be strictly positive");
+
+    m_Gain = static_cast< RealType >( gain );
+    m_Sampler.SetScale(1.0 / gain);
+    }
+
+  void SetReadNoise(const double readNoise)
+    {
+    if(readNoise < 0.0)
+      itkGenericExceptionMacro("read noise must be positive");
+
+    m_ReadNoise = static_cast< RealType >( readNoise );
+    }
+
+  void SetDarkOffset(const double darkOffset)
+    { m_DarkOffset = static_cast< RealType >( darkOffset ); }
+
+  void SetQuantization(const bool quantization)
+    { m_Quantization = quantization; }
+
+  TOutput GetOutputMinimum() const
+    { return m_OutputMinimum; }
+
+  TOutput GetOutputMaximum() const
+    { return m_OutputMaximum; }
+
+  void SetOutputBounds( const TOutput min, const TOutput max)
+    {
+    if(max <= min)
+      itkGenericExceptionMacro("invalid bounds: [" << min << "; " << max << "]");
+
+    m_OutputMinimum = min;
+    m_OutputMaximum = max;
+    }
+
+  bool operator!=(const CameraNoise &other) const
+    {
+    return m_Gain != other.m_Gain
+      || m_ReadNoise != other.m_ReadNoise
+      || m_DarkOffset != other.m_DarkOffset
+      || m_Quantization != other.m_Quantization
+      || m_OutputMaximum != other.m_OutputMaximum
+      || m_OutputMinimum != other.m_OutputMinimum;
+    }
+
+  bool operator==(const CameraNoise & other) const
+    {
+    return !( *this != other );
+    }
+
+  /** Precompute the shot noise samplers of the intensities. Must be called
+   * after the parameters are set. */
+  void Initialize()
+    { m_Sampler.Initialize(); }
+
+  /** Flags of the variant of Evaluate() matching the parameters. */
+  unsigned int GetVariant() const
+    {
+    unsigned int variant = 0;
+    if ( !NoiseClampIsNeeded< TOutput, RealType >(m_OutputMinimum, m_OutputMaximum) )
+      {
+      variant |= NoiseVariantNoClamp;
+      }
+    return variant;
+    }
+
+  /** Shot noise: electron count of a pixel. */
+  template< class TEngine >
+  inline RealType SampleElectrons(const TInput & A, TEngine & engine) const
+    {
+    return static_cast< RealType >( m_Sampler.Sample(A, engine) );
+    }
+
+  /** Reading of an electron count, given a standard normal variate for the
+   * read noise. */
+  template< unsigned int VVariant >
+  inline TOutput Convert(const RealType electrons, const RealType z) const
+    {
+    return NoiseClamp< VVariant >(this->Reading(electrons, z), m_OutputMinimum, m_OutputMaximum);
+    }
+
+  /** Reading of the electron count of A, and its difference to A before
+   * clamping. */
+  template< unsigned int VVariant >
+  inline TOutput Convert(const TInput & A, const RealType electrons, const RealType z, float & noise) const
+    {
+    const RealType v = this->Reading(electrons, z);
+    noise = static_cast< float >( v - static_cast< RealType >( A ) );
+    return NoiseClamp< VVariant >(v, m_OutputMinimum, m_OutputMaximum);
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine) const
+    {
+    const RealType electrons = this->SampleElectrons(A, engine);
+    return Convert< VVariant >( electrons, NormalVariate< RealType >(engine) );
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine, float & noise) const
+    {
+    const RealType electrons = this->SampleElectrons(A, engine);
+    return Convert< VVariant >( A, electrons, NormalVariate< RealType >(engine), noise );
+    }
+
+  template< class TEngine >
+  inline TOutput operator()(const TInput & A, TEngine & engine) const
+    {
+    return Evaluate< 0 >(A, engine);
+    }
+
+private:
+  /** Unclamped reading of an electron count. */
+  inline RealType Reading(const RealType electrons, const RealType z) const
+    {
+    RealType v = m_Gain * ( electrons + m_ReadNoise * z ) + m_DarkOffset;
+    if ( m_Quantization )
+      {
+      v = std::floor( v + RealType(0.5) );
+      }
+    return v;
+    }
+
+  TOutput m_OutputMinimum;
+  TOutput m_OutputMaximum;
+  RealType m_Gain;
+  RealType m_ReadNoise;
+  RealType m_DarkOffset;
+  bool m_Quantization;
+
+  PoissonIntensitySampler< TInput > m_Sampler;
+};
+} // End namespace Functor
+
+/** \class CameraNoiseImageFilter
+ * \brief Simulates the noise of a camera sensor in a single pass.
+ * Gain, shot noise, read noise, dark offset and quantization are fused in
+ * one kernel. The runs are processed by blocks: the shot counts are drawn
+ * first, then the read noise two values per polar-method draw, and the
+ * readings are computed in a loop without branches or random draws.
+ * \ingroup ITKImageIntensity
+ */
+template< class TInputImage, class TOutputImage, class TEngine = Xoshiro256PlusPlusEngine,
+          class TRealType = double >
+class ITK_EXPORT CameraNoiseImageFilter:
+  public
+  NoiseImageFilter< TInputImage, TOutputImage,
+                    Functor::CameraNoise<
+                      typename TInputImage::PixelType,
+                      typename TOutputImage::PixelType,
+                      TRealType >,
+                    TEngine >
+{
+public:
+  /** Standard class typedefs. */
+  typedef CameraNoiseImageFilter Self;
+  typedef NoiseImageFilter<
+    TInputImage, TOutputImage,
+    Functor::CameraNoise< typename TInputImage::PixelType,
+                          typename TOutputImage::PixelType,
+                          TRealType >,
+    TEngine >  Superclass;
+
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  typedef typename Superclass::InputImagePixelType  InputImagePixelType;
+  typedef typename Superclass::OutputImagePixelType OutputImagePixelType;
+  typedef typename Superclass::IndexType            IndexType;
+  typedef typename Superclass::NoisePixelType       NoisePixelType;
+  typedef typename Superclass::EngineType           EngineType;
+  typedef typename TOutputImage::PixelType          OutputPixelType;
+  typedef TRealType                                 RealType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Macro that provides the GetNameOfClass() method */
+  itkTypeMacro(CameraNoiseImageFilter, NoiseImageFilter);
+
+  OutputPixelType GetOutputMinimum() const
+    {
+    return this->GetFunctor().GetOutputMinimum();
+    }
+
+  OutputPixelType GetOutputMaximum() const
+    {
+    return this->GetFunctor().GetOutputMaximum();
+    }
+
+  double GetGain() const
+    { return this->GetFunctor().GetGain(); }
+
+  double GetReadNoise() const
+    { return this->GetFunctor().GetReadNoise(); }
+
+  double GetDarkOffset() const
+    { return this->GetFunctor().GetDarkOffset(); }
+
+  bool GetQuantization() const
+    { return this->GetFunctor().GetQuantization(); }
+
+  void SetOutputBounds(const OutputPixelType min, const OutputPixelType max)
+    {
+    if ( min == this->GetFunctor().GetOutputMinimum() && max == this->GetFunctor().GetOutputMaximum())
+      {
+      return;
+      }
+
+    this->GetFunctor().SetOutputBounds(min, max);
+    this->Modified();
+    }
+
+  /** Output intensity of one electron. */
+  void SetGain(const double gain)
+    {
+    if ( gain == this->GetFunctor().GetGain() )
+      {
+      return;
+      }
+
+    this->GetFunctor().SetGain(gain);
+    this->Modified();
+    }
+
+  /** Standard deviation of the read noise, in electrons. */
+  void SetReadNoise(const double readNoise)
+    {
+    if ( readNoise == this->GetFunctor().GetReadNoise() )
+      {
+      return;
+      }
+
+    this->GetFunctor().SetReadNoise(readNoise);
+    this->Modified();
+    }
+
+  /** Output intensity of a pixel without any electron. */
+  void SetDarkOffset(const double darkOffset)
+    {
+    if ( darkOffset == this->GetFunctor().GetDarkOffset() )
+      {
+      return;
+      }
+
+    this->GetFunctor().SetDarkOffset(darkOffset);
+    this->Modified();
+    }
+
+  void SetQuantization(const bool quantization)
+    {
+    if ( quantization == this->GetFunctor().GetQuantization() )
+      {
+      return;
+      }
+
+    this->GetFunctor().SetQuantization(quantization);
+    this->Modified();
+    }
+
+  itkBooleanMacro(Quantization);
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+    {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "Gain: " << static_cast<typename NumericTraits<double>::PrintType>(GetGain()) << std::endl;
+    os << indent << "ReadNoise: " << static_cast<typename NumericTraits<double>::PrintType>(GetReadNoise()) << std::endl;
+    os << indent << "DarkOffset: " << static_cast<typename NumericTraits<double>::PrintType>(GetDarkOffset()) << std::endl;
+    os << indent << "Quantization: " << GetQuantization() << std::endl;
+    os << indent << "OutputMinimum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMinimum()) << std::endl;
+    os << indent << "OutputMaximum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMaximum()) << std::endl;
+    }
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  itkConceptMacro( InputConvertibleToDoubleCheck,
+    ( Concept::Convertible< typename TInputImage::PixelType, double > ) );
+  itkConceptMacro( DoubleConvertibleToOutputCheck,
+    ( Concept::Convertible< double, OutputPixelType > ) );
+#endif
+
+protected:
+  CameraNoiseImageFilter() {}
+  virtual ~CameraNoiseImageFilter() {}
+
+  /** Precompute the shot noise samplers before the threads start. */
+  void BeforeThreadedGenerateData()
+    {
+    this->GetFunctor().Initialize();
+    Superclass::BeforeThreadedGenerateData();
+    }
+
+  void ProcessRun(const InputImagePixelType *in,
+                  OutputImagePixelType *out,
+                  NoisePixelType *noise,
+                  SizeValueType length,
+                  const IndexType & start) const
+    {
+    if ( this->GetFunctorVariant() & Functor::NoiseVariantNoClamp )
+      {
+      this->ProcessRunVariant< Functor::NoiseVariantNoClamp >(in, out, noise, length, start);
+      }
+    else if ( this->GetFunctorVariant() & Functor::NoiseVariantStatistics )
+      {
+      this->ProcessRunVariant< Functor::NoiseVariantStatistics >(in, out, noise, length, start);
+      }
+    else
+      {
+      this->ProcessRunVariant< 0 >(in, out, noise, length, start);
+      }
+    }
+
+private:
+  CameraNoiseImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+
+  template< unsigned int VVariant >
+  void ProcessRunVariant(const InputImagePixelType *in,
+                         OutputImagePixelType *out,
+                         NoisePixelType *noise,
+                         SizeValueType length,
+                         const IndexType & start) const
+    {
+    const typename Superclass::FunctorType & functor = this->GetFunctor();
+    const bool readNoise = functor.GetReadNoise() > 0.0;
+
+    EngineType engine;
+    this->SeedRunEngine(engine, start);
+
+    // Pixels whose random numbers are drawn at once. Even, so that the
+    // pairs of normal variates fit.
+    const SizeValueType blockSize = 64;
+
+    RealType electrons[blockSize];
+    RealType z[blockSize];
+    if ( !readNoise )
+      {
+      std::fill(z, z + blockSize, RealType(0));
+      }
+
+    for ( SizeValueType offset = 0; offset < length; offset += blockSize )
+      {
+      const SizeValueType count = std::min(blockSize, length - offset);
+      const InputImagePixelType *blockIn = in + offset;
+      OutputImagePixelType *blockOut = out + offset;
+
+      for ( SizeValueType i = 0; i < count; ++i )
+        {
+        electrons[i] = functor.SampleElectrons(blockIn[i], engine);
+        }
+
+      if ( readNoise )
+        {
+        for ( SizeValueType i = 0; i < count; i += 2 )
+          {
+          NormalVariatePair(engine, z[i], z[i + 1]);
+          }
+        }
+
+      if ( noise )
+        {
+        for ( SizeValueType i = 0; i < count; ++i )
+          {
+          blockOut[i] = functor.template Convert< VVariant >(blockIn[i], electrons[i], z[i], noise[offset + i]);
+          }
+        continue;
+        }
+
+      for ( SizeValueType i = 0; i < count; ++i )
+        {
+        blockOut[i] = functor.template Convert< VVariant >(electrons[i], z[i]);
+        }
+      }
+    }
+};
+
+} // End namespace itk
+
+#endif /* __itkCameraNoiseImageFilter */
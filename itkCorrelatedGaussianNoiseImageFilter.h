@@ -0,0 +1,797 @@
+#ifndef __itkCorrelatedGaussianNoiseImageFilter
+#define __itkCorrelatedGaussianNoiseImageFilter
+
+#include "itkNoiseImageFilter.h"
+#include <itkConceptChecking.h>
+#include <itkMultiThreader.h>
+
+#include <cmath>
+#include <vector>
+
+namespace itk
+{
+/** \class CausalRecursiveGaussian
+ * \brief Causal part of the recursive gaussian of Young & van Vliet.
+ * Filtering white noise with the causal part only gives noise whose
+ * autocorrelation is the impulse response of the whole (causal and
+ * anti-causal) filter: approximately a gaussian of standard deviation
+ * sigma. Being causal, the filter can be applied while streaming.
+ *
+ * The recursion starts from a state drawn from its stationary
+ * distribution (see MixInitialState()), so the noise has the same
+ * statistics at the borders as inside, without any warm-up.
+ */
+class CausalRecursiveGaussian
+{
+public:
+  CausalRecursiveGaussian()
+    { this->SetSigma(0.0); }
+
+  /** Standard deviation of the autocorrelation, in samples. The filter is
+   * the identity below 0.5. */
+  void SetSigma(const double sigma)
+    {
+    m_Identity = sigma < 0.5;
+    if ( m_Identity )
+      {
+      m_B = 1.0;
+      m_A[0] = m_A[1] = m_A[2] = 0.0;
+      m_Variance = 1.0;
+      return;
+      }
+
+    const double q = sigma >= 2.5 ? 0.98711 * sigma - 0.96330
+                                  : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+    const double q2 = q * q;
+    const double q3 = q2 * q;
+    const double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+
+    m_A[0] = ( 2.44413 * q + 2.85619 * q2 + 1.26661 * q3 ) / b0;
+    m_A[1] = -( 1.4281 * q2 + 1.26661 * q3 ) / b0;
+    m_A[2] = 0.422205 * q3 / b0;
+    m_B = 1.0 - ( m_A[0] + m_A[1] + m_A[2] );
+
+    // Autocovariance of the response to unit white noise, from the
+    // impulse response.
+    double gamma[3] = { 0.0, 0.0, 0.0 };
+    double h[3] = { 0.0, 0.0, 0.0 };
+    for ( unsigned int n = 0; n < 3 || std::fabs(h[0]) + std::fabs(h[1]) + std::fabs(h[2]) > 1e-15; ++n )
+      {
+      const double hn = ( n == 0 ? m_B : 0.0 ) + m_A[0] * h[0] + m_A[1] * h[1] + m_A[2] * h[2];
+      gamma[0] += hn * hn;
+      gamma[1] += hn * h[0];
+      gamma[2] += hn * h[1];
+      h[2] = h[1];
+      h[1] = h[0];
+      h[0] = hn;
+      }
+    m_Variance = gamma[0];
+
+    // Cholesky factor of the covariance of (y[-1], y[-2], y[-3]).
+    m_L[0] = std::sqrt(gamma[0]);
+    m_L[1] = gamma[1] / m_L[0];
+    m_L[2] = std::sqrt(gamma[0] - m_L[1] * m_L[1]);
+    m_L[3] = gamma[2] / m_L[0];
+    m_L[4] = ( gamma[1] - m_L[3] * m_L[1] ) / m_L[2];
+    m_L[5] = std::sqrt(gamma[0] - m_L[3] * m_L[3] - m_L[4] * m_L[4]);
+    }
+
+  bool IsIdentity() const
+    { return m_Identity; }
+
+  /** Variance of the response to unit white noise. */
+  double GetVariance() const
+    { return m_Variance; }
+
+  /** Turn, in place, three independent unit variance inputs into the
+   * stationary state (y[-1], y[-2], y[-3]). */
+  template< class T >
+  void MixInitialState(T *y1, T *y2, T *y3, const SizeValueType count) const
+    {
+    const T l0 = static_cast< T >( m_L[0] );
+    const T l1 = static_cast< T >( m_L[1] );
+    const T l2 = static_cast< T >( m_L[2] );
+    const T l3 = static_cast< T >( m_L[3] );
+    const T l4 = static_cast< T >( m_L[4] );
+    const T l5 = static_cast< T >( m_L[5] );
+
+    for ( SizeValueType i = 0; i < count; ++i )
+      {
+      y3[i] = l3 * y1[i] + l4 * y2[i] + l5 * y3[i];
+      y2[i] = l1 * y1[i] + l2 * y2[i];
+      y1[i] = l0 * y1[i];
+      }
+    }
+
+  /** Filter a line in place, from the state (y[-1], y[-2], y[-3]). */
+  template< class T >
+  void FilterLine(T *line, const SizeValueType length, T y1, T y2, T y3) const
+    {
+    const T b = static_cast< T >( m_B );
+    const T a0 = static_cast< T >( m_A[0] );
+    const T a1 = static_cast< T >( m_A[1] );
+    const T a2 = static_cast< T >( m_A[2] );
+
+    for ( SizeValueType i = 0; i < length; ++i )
+      {
+      const T y = b * line[i] + a0 * y1 + a1 * y2 + a2 * y3;
+      line[i] = y;
+      y3 = y2;
+      y2 = y1;
+      y1 = y;
+      }
+    }
+
+  /** One step of the recursion applied to count parallel lines: current
+   * holds the inputs and receives the outputs. */
+  template< class T >
+  void FilterStep(T *current, const T *y1, const T *y2, const T *y3, const SizeValueType count) const
+    {
+    const T b = static_cast< T >( m_B );
+    const T a0 = static_cast< T >( m_A[0] );
+    const T a1 = static_cast< T >( m_A[1] );
+    const T a2 = static_cast< T >( m_A[2] );
+
+    for ( SizeValueType i = 0; i < count; ++i )
+      {
+      current[i] = b * current[i] + a0 * y1[i] + a1 * y2[i] + a2 * y3[i];
+      }
+    }
+
+private:
+  bool   m_Identity;
+  double m_B;
+  double m_A[3];
+  double m_Variance;
+  double m_L[6];
+};
+
+namespace Functor
+{
+/** \class CorrelatedGaussianNoise
+ * \brief Adds correlated gaussian noise to a pixel.
+ * The noise values are given to Apply() by CorrelatedGaussianNoiseImageFilter.
+ * Used alone through Evaluate(), the functor adds white noise.
+ * \ingroup ITKImageIntensity
+ */
+template< class TInput, class TOutput, class TRealType = double >
+class CorrelatedGaussianNoise
+{
+public:
+  typedef TRealType RealType;
+
+  CorrelatedGaussianNoise()
+    {
+    m_StandardDeviation = 1.0;
+    m_OutputMinimum = itk::NumericTraits< TOutput >::NonpositiveMin();
+    m_OutputMaximum = itk::NumericTraits< TOutput >::max();
+    }
+
+  ~CorrelatedGaussianNoise() {}
+
+  double GetStandardDeviation() const
+    { return m_StandardDeviation; }
+
+  void SetStandardDeviation(const double standardDeviation)
+    {
+    if(standardDeviation <= 0.0)
+      itkGenericExceptionMacro("standard deviation must be strictly positive");
+
+    m_StandardDeviation = static_cast< RealType >( standardDeviation );
+    }
+
+  TOutput GetOutputMinimum() const
+    { return m_OutputMinimum; }
+
+  TOutput GetOutputMaximum() const
+    { return m_OutputMaximum; }
+
+  void SetOutputBounds( const TOutput min, const TOutput max)
+    {
+    if(max <= min)
+      itkGenericExceptionMacro("invalid bounds: [" << min << "; " << max << "]");
+
+    m_OutputMinimum = min;
+    m_OutputMaximum = max;
+    }
+
+  bool operator!=(const CorrelatedGaussianNoise &other) const
+    {
+    return m_StandardDeviation != other.m_StandardDeviation
+      || m_OutputMaximum != other.m_OutputMaximum
+      || m_OutputMinimum != other.m_OutputMinimum;
+    }
+
+  bool operator==(const CorrelatedGaussianNoise & other) const
+    {
+    return !( *this != other );
+    }
+
+  /** Flags of the variant of Evaluate() matching the parameters. */
+  unsigned int GetVariant() const
+    {
+    unsigned int variant = 0;
+    if ( !NoiseClampIsNeeded< TOutput, RealType >(m_OutputMinimum, m_OutputMaximum) )
+      {
+      variant |= NoiseVariantNoClamp;
+      }
+    return variant;
+    }
+
+  /** Noisy value of a pixel, given a unit variance noise value. */
+  template< unsigned int VVariant >
+  inline TOutput Apply(const TInput & A, const RealType noise) const
+    {
+    float n;
+    return Apply< VVariant >(A, noise, n);
+    }
+
+  /** Noisy value of a pixel, and the correlated noise added to it. */
+  template< unsigned int VVariant >
+  inline TOutput Apply(const TInput & A, const RealType z, float & noise) const
+    {
+    const RealType n = m_StandardDeviation * z;
+    noise = static_cast< float >( n );
+    const RealType v = static_cast< RealType >( A ) + n;
+    return NoiseClamp< VVariant >(v, m_OutputMinimum, m_OutputMaximum);
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine) const
+    {
+    return Apply< VVariant >( A, NormalVariate< RealType >(engine) );
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine, float & noise) const
+    {
+    return Apply< VVariant >( A, NormalVariate< RealType >(engine), noise );
+    }
+
+  template< class TEngine >
+  inline TOutput operator()(const TInput & A, TEngine & engine) const
+    {
+    return Evaluate< 0 >(A, engine);
+    }
+
+private:
+  TOutput m_OutputMinimum;
+  TOutput m_OutputMaximum;
+  RealType m_StandardDeviation;
+};
+} // End namespace Functor
+
+/** \class CorrelatedGaussianNoiseImageFilter
+ * \brief Adds spatially correlated gaussian noise.
+ * The noise is white noise smoothed by a gaussian kernel of standard
+ * deviation Sigma (in physical units), renormalized to StandardDeviation.
+ * The smoothing is done by a causal recursive gaussian along each of the
+ * first three axes (see CausalRecursiveGaussian), so its cost does not
+ * depend on Sigma.
+ *
+ * The noise is generated slice by slice along the third axis: only four
+ * slices of noise are kept in memory, and each slice is added to the image
+ * as soon as it is complete. Within a slice, the threads share the rows for
+ * the white noise and the recursion along the first axis, then the columns
+ * for the recursions along the second and third axes, then the rows again to
+ * add the noise; only the slices follow each other. The white noise of each
+ * line is drawn from an engine seeded from the index of the line, so the
+ * output only depends on the seed and the requested region, and not on the
+ * number of threads.
+ * \ingroup ITKImageIntensity
+ */
+template< class TInputImage, class TOutputImage, class TEngine = Xoshiro256PlusPlusEngine,
+          class TRealType = double >
+class ITK_EXPORT CorrelatedGaussianNoiseImageFilter:
+  public
+  NoiseImageFilter< TInputImage, TOutputImage,
+                    Functor::CorrelatedGaussianNoise<
+                      typename TInputImage::PixelType,
+                      typename TOutputImage::PixelType,
+                      TRealType >,
+                    TEngine >
+{
+public:
+  /** Standard class typedefs. */
+  typedef CorrelatedGaussianNoiseImageFilter Self;
+  typedef NoiseImageFilter<
+    TInputImage, TOutputImage,
+    Functor::CorrelatedGaussianNoise< typename TInputImage::PixelType,
+                                      typename TOutputImage::PixelType,
+                                      TRealType >,
+    TEngine >  Superclass;
+
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  typedef typename Superclass::InputImagePixelType   InputImagePixelType;
+  typedef typename Superclass::OutputImagePixelType  OutputImagePixelType;
+  typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
+  typedef typename Superclass::IndexType             IndexType;
+  typedef typename Superclass::NoisePixelType        NoisePixelType;
+  typedef typename Superclass::EngineType            EngineType;
+  typedef typename TOutputImage::PixelType           OutputPixelType;
+  typedef typename TOutputImage::SpacingType         SpacingType;
+  typedef TRealType                                  RealType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int, TOutputImage::ImageDimension);
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Macro that provides the GetNameOfClass() method */
+  itkTypeMacro(CorrelatedGaussianNoiseImageFilter, NoiseImageFilter);
+
+  OutputPixelType GetOutputMinimum() const
+    {
+    return this->GetFunctor().GetOutputMinimum();
+    }
+
+  OutputPixelType GetOutputMaximum() const
+    {
+    return this->GetFunctor().GetOutputMaximum();
+    }
+
+  double GetStandardDeviation() const
+    { return this->GetFunctor().GetStandardDeviation(); }
+
+  void SetOutputBounds(const OutputPixelType min, const OutputPixelType max)
+    {
+    if ( min == this->GetFunctor().GetOutputMinimum() && max == this->GetFunctor().GetOutputMaximum())
+      {
+      return;
+      }
+
+    this->GetFunctor().SetOutputBounds(min, max);
+    this->Modified();
+    }
+
+  void SetStandardDeviation(const double standardDeviation)
+    {
+    if ( standardDeviation == this->GetFunctor().GetStandardDeviation() )
+      {
+      return;
+      }
+
+    this->GetFunctor().SetStandardDeviation(standardDeviation);
+    this->Modified();
+    }
+
+  /** Standard deviation, in physical units, of the gaussian kernel
+   * smoothing the white noise. 0 gives white noise. */
+  itkSetMacro(Sigma, double);
+  itkGetConstMacro(Sigma, double);
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+    {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "StandardDeviation: " << static_cast<typename NumericTraits<double>::PrintType>(GetStandardDeviation()) << std::endl;
+    os << indent << "Sigma: " << m_Sigma << std::endl;
+    os << indent << "OutputMinimum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMinimum()) << std::endl;
+    os << indent << "OutputMaximum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMaximum()) << std::endl;
+    }
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  itkConceptMacro( InputConvertibleToDoubleCheck,
+    ( Concept::Convertible< typename TInputImage::PixelType, double > ) );
+  itkConceptMacro( DoubleConvertibleToOutputCheck,
+    ( Concept::Convertible< double, OutputPixelType > ) );
+#endif
+
+protected:
+  CorrelatedGaussianNoiseImageFilter()
+    {
+    m_Sigma = 1.0;
+    m_NoiseNormalization = 1.0;
+    m_Slices = 0;
+    m_NextSlice = 0;
+    m_Current = ITK_NULLPTR;
+    m_Previous[0] = m_Previous[1] = m_Previous[2] = ITK_NULLPTR;
+    m_CurrentNoise = ITK_NULLPTR;
+    }
+
+  virtual ~CorrelatedGaussianNoiseImageFilter() {}
+
+  /** Generate the noise slice by slice and add each one to the image. */
+  void GenerateData()
+    {
+    if ( ImageDimension > 3 )
+      {
+      itkExceptionMacro("images of more than 3 dimensions are not supported");
+      }
+
+    this->AllocateOutputs();
+    this->BeforeThreadedGenerateData();
+
+    const OutputImageRegionType region = this->GetOutput()->GetRequestedRegion();
+    this->InitializeNoise( region, this->GetOutput()->GetSpacing() );
+
+    // The progress is reported by the first thread, from its lines.
+    SizeValueType begin = 0;
+    SizeValueType end = 1;
+    if ( ImageDimension > 1 )
+      {
+      SplitRange( region.GetSize(1), 0, this->GetNumberOfSliceThreads(), begin, end );
+      }
+    const SizeValueType lines = region.GetSize(0) > 0 ? ( end - begin ) * m_Slices : 0;
+    ProgressReporter progress( this, 0, lines );
+
+    SliceWork work;
+    work.filter = this;
+    work.phase = ApplyNoisePhase;
+    work.buffer = ITK_NULLPTR;
+    work.previous = ITK_NULLPTR;
+    work.z = 0;
+    work.slice = region;
+    work.progress = &progress;
+
+    for ( SizeValueType z = 0; z < m_Slices; ++z )
+      {
+      if ( ImageDimension > 2 )
+        {
+        work.slice.SetIndex( 2, region.GetIndex(2) + static_cast< IndexValueType >( z ) );
+        work.slice.SetSize( 2, 1 );
+        }
+
+      m_CurrentNoise = this->NextNoiseSlice();
+      this->ExecuteSliceWork(work);
+      }
+
+    this->ReleaseNoise();
+    this->AfterThreadedGenerateData();
+    }
+
+  void ProcessRun(const InputImagePixelType *in,
+                  OutputImagePixelType *out,
+                  NoisePixelType *noise,
+                  SizeValueType length,
+                  const IndexType & start) const
+    {
+    OffsetValueType offset = start[0] - m_NoiseIndex[0];
+    if ( ImageDimension > 1 )
+      {
+      offset += ( start[1] - m_NoiseIndex[1] ) * static_cast< OffsetValueType >( m_NoiseSize[0] );
+      }
+    const RealType *correlated = m_CurrentNoise + offset;
+
+    if ( this->GetFunctorVariant() & Functor::NoiseVariantNoClamp )
+      {
+      this->ProcessRunVariant< Functor::NoiseVariantNoClamp >(in, out, noise, length, correlated);
+      }
+    else if ( this->GetFunctorVariant() & Functor::NoiseVariantStatistics )
+      {
+      this->ProcessRunVariant< Functor::NoiseVariantStatistics >(in, out, noise, length, correlated);
+      }
+    else
+      {
+      this->ProcessRunVariant< 0 >(in, out, noise, length, correlated);
+      }
+    }
+
+  /** Prepare the generation of the noise of a region, whose first slice
+   * is then returned by NextNoiseSlice(). */
+  void InitializeNoise(const OutputImageRegionType & region, const SpacingType & spacing)
+    {
+    double variance = 1.0;
+    for ( unsigned int d = 0; d < 3; ++d )
+      {
+      // The autocorrelation of white noise smoothed by a gaussian of
+      // standard deviation sigma is a gaussian of standard deviation
+      // sigma * sqrt(2).
+      m_Axes[d].SetSigma( d < ImageDimension ? m_Sigma * std::sqrt(2.0) / spacing[d] : 0.0 );
+      variance *= m_Axes[d].GetVariance();
+
+      m_NoiseIndex[d] = d < ImageDimension ? region.GetIndex(d) : 0;
+      m_NoiseSize[d] = d < ImageDimension ? region.GetSize(d) : 1;
+      }
+    m_NoiseNormalization = static_cast< RealType >( 1.0 / std::sqrt(variance) );
+
+    m_Slices = m_NoiseSize[2];
+    m_NextSlice = 0;
+
+    // Each buffer is a slice preceded by the three rows of the initial
+    // state of the recursion along the second axis.
+    const SizeValueType sliceSize = m_NoiseSize[0] * ( m_NoiseSize[1] + 3 );
+    for ( unsigned int i = 0; i < 4; ++i )
+      {
+      m_Buffers[i].assign(sliceSize, 0);
+      }
+    m_Current = &m_Buffers[0][0];
+    for ( unsigned int k = 0; k < 3; ++k )
+      {
+      m_Previous[k] = &m_Buffers[k + 1][0];
+      }
+
+    if ( !m_Axes[2].IsIdentity() )
+      {
+      for ( unsigned int k = 0; k < 3; ++k )
+        {
+        this->GenerateSlice( m_NoiseIndex[2] - 1 - static_cast< IndexValueType >( k ), m_Previous[k], ITK_NULLPTR );
+        }
+
+      const SizeValueType rows = 3 * m_NoiseSize[0];
+      m_Axes[2].MixInitialState( m_Previous[0] + rows, m_Previous[1] + rows, m_Previous[2] + rows,
+                                 m_NoiseSize[0] * m_NoiseSize[1] );
+      }
+    }
+
+  /** Noise of the next slice, with unit variance (see
+   * m_NoiseNormalization), rows of m_NoiseSize[0] values. */
+  const RealType * NextNoiseSlice()
+    {
+    const SizeValueType rows = 3 * m_NoiseSize[0];
+
+    this->GenerateSlice( m_NoiseIndex[2] + static_cast< IndexValueType >( m_NextSlice ), m_Current,
+                         m_Axes[2].IsIdentity() ? ITK_NULLPTR : m_Previous );
+    ++m_NextSlice;
+
+    RealType *slice = m_Current;
+    m_Current = m_Previous[2];
+    m_Previous[2] = m_Previous[1];
+    m_Previous[1] = m_Previous[0];
+    m_Previous[0] = slice;
+
+    return slice + rows;
+    }
+
+  void ReleaseNoise()
+    {
+    for ( unsigned int i = 0; i < 4; ++i )
+      {
+      std::vector< RealType >().swap(m_Buffers[i]);
+      }
+    }
+
+  RealType GetNoiseNormalization() const
+    { return m_NoiseNormalization; }
+
+private:
+  CorrelatedGaussianNoiseImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+
+  template< unsigned int VVariant >
+  void ProcessRunVariant(const InputImagePixelType *in,
+                         OutputImagePixelType *out,
+                         NoisePixelType *noise,
+                         SizeValueType length,
+                         const RealType *correlated) const
+    {
+    const typename Superclass::FunctorType & functor = this->GetFunctor();
+
+    if ( noise )
+      {
+      for ( SizeValueType i = 0; i < length; ++i )
+        {
+        out[i] = functor.template Apply< VVariant >(in[i], m_NoiseNormalization * correlated[i], noise[i]);
+        }
+      return;
+      }
+
+    for ( SizeValueType i = 0; i < length; ++i )
+      {
+      out[i] = functor.template Apply< VVariant >(in[i], m_NoiseNormalization * correlated[i]);
+      }
+    }
+
+  /** Steps of the generation of a slice, each one shared by the threads. */
+  enum SlicePhase
+    {
+    GenerateRowsPhase,
+    FilterColumnsPhase,
+    ApplyNoisePhase
+    };
+
+  /** Work of the threads on a slice. */
+  struct SliceWork
+    {
+    Self                 *filter;
+    SlicePhase            phase;
+    IndexValueType        z;
+    RealType             *buffer;
+    RealType * const     *previous;
+    OutputImageRegionType slice;
+    ProgressReporter     *progress;
+    };
+
+  static ITK_THREAD_RETURN_TYPE SliceWorkCallback(void *arg)
+    {
+    MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+    const SliceWork *work = static_cast< const SliceWork * >( info->UserData );
+
+    work->filter->ThreadedSliceWork( *work, info->ThreadID, info->NumberOfThreads );
+
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  /** Number of threads sharing the work on a slice. */
+  ThreadIdType GetNumberOfSliceThreads()
+    {
+    this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+    return this->GetMultiThreader()->GetNumberOfThreads();
+    }
+
+  /** Run a phase of the work on a slice in all the threads. */
+  void ExecuteSliceWork(const SliceWork & work)
+    {
+    this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+    this->GetMultiThreader()->SetSingleMethod( SliceWorkCallback, const_cast< SliceWork * >( &work ) );
+    this->GetMultiThreader()->SingleMethodExecute();
+    }
+
+  /** Contiguous part of count items given to a thread. */
+  static void SplitRange(const SizeValueType count, const ThreadIdType threadId, const ThreadIdType threads,
+                         SizeValueType & begin, SizeValueType & end)
+    {
+    const SizeValueType chunk = ( count + threads - 1 ) / threads;
+    begin = std::min( count, threadId * chunk );
+    end = std::min( count, begin + chunk );
+    }
+
+  /** The part of a phase of the work on a slice done by a thread. */
+  void ThreadedSliceWork(const SliceWork & work, const ThreadIdType threadId, const ThreadIdType threads)
+    {
+    const SizeValueType size0 = m_NoiseSize[0];
+    const SizeValueType size1 = m_NoiseSize[1];
+
+    SizeValueType begin;
+    SizeValueType end;
+
+    switch ( work.phase )
+      {
+      case GenerateRowsPhase:
+        {
+        // Rows y[-1], y[-2] and y[-3] of the initial state along the second
+        // axis are rows 2, 1 and 0 of the buffer.
+        const SizeValueType first = m_Axes[1].IsIdentity() ? 3 : 0;
+        SplitRange( size1 + 3 - first, threadId, threads, begin, end );
+        for ( SizeValueType r = first + begin; r < first + end; ++r )
+          {
+          this->GenerateRow( m_NoiseIndex[1] + static_cast< IndexValueType >( r ) - 3, work.z, work.buffer + r * size0 );
+          }
+        break;
+        }
+      case FilterColumnsPhase:
+        {
+        SplitRange( size0, threadId, threads, begin, end );
+        const SizeValueType count = end - begin;
+        if ( count == 0 )
+          {
+          break;
+          }
+
+        RealType *columns = work.buffer + begin;
+        if ( !m_Axes[1].IsIdentity() )
+          {
+          m_Axes[1].MixInitialState( columns + 2 * size0, columns + size0, columns, count );
+          for ( SizeValueType y = 0; y < size1; ++y )
+            {
+            RealType *row = columns + ( y + 3 ) * size0;
+            m_Axes[1].FilterStep( row, row - size0, row - 2 * size0, row - 3 * size0, count );
+            }
+          }
+
+        if ( work.previous )
+          {
+          for ( SizeValueType y = 0; y < size1; ++y )
+            {
+            const SizeValueType offset = ( y + 3 ) * size0 + begin;
+            m_Axes[2].FilterStep( work.buffer + offset, work.previous[0] + offset, work.previous[1] + offset,
+                                  work.previous[2] + offset, count );
+            }
+          }
+        break;
+        }
+      case ApplyNoisePhase:
+        {
+        OutputImageRegionType lines = work.slice;
+        if ( ImageDimension > 1 )
+          {
+          SplitRange( lines.GetSize(1), threadId, threads, begin, end );
+          lines.SetIndex( 1, lines.GetIndex(1) + static_cast< IndexValueType >( begin ) );
+          lines.SetSize( 1, end - begin );
+          }
+        else if ( threadId > 0 )
+          {
+          break;
+          }
+
+        if ( lines.GetNumberOfPixels() == 0 )
+          {
+          break;
+          }
+
+        if ( threadId == 0 )
+          {
+          this->GenerateLines( lines, *work.progress, this->GetThreadStatistics(threadId) );
+          }
+        else
+          {
+          // Only the first thread reports the progress.
+          ProgressReporter progress( this, threadId, 0 );
+          this->GenerateLines( lines, progress, this->GetThreadStatistics(threadId) );
+          }
+        break;
+        }
+      }
+    }
+
+  /** White noise filtered along the first two axes, into a buffer whose
+   * first three rows receive the initial state along the second axis, then
+   * along the third axis when previous gives the three previous slices. */
+  void GenerateSlice(const IndexValueType z, RealType *buffer, RealType * const *previous)
+    {
+    SliceWork work;
+    work.filter = this;
+    work.z = z;
+    work.buffer = buffer;
+    work.previous = previous;
+    work.progress = ITK_NULLPTR;
+
+    work.phase = GenerateRowsPhase;
+    this->ExecuteSliceWork(work);
+
+    if ( !m_Axes[1].IsIdentity() || previous )
+      {
+      work.phase = FilterColumnsPhase;
+      this->ExecuteSliceWork(work);
+      }
+    }
+
+  /** White noise filtered along the first axis. */
+  void GenerateRow(const IndexValueType y, const IndexValueType z, RealType *row) const
+    {
+    IndexType index;
+    index.Fill(0);
+    index[0] = m_NoiseIndex[0];
+    if ( ImageDimension > 1 )
+      {
+      index[1] = y;
+      }
+    if ( ImageDimension > 2 )
+      {
+      index[2] = z;
+      }
+
+    EngineType engine;
+    this->SeedRunEngine(engine, index);
+
+    RealType state[4];
+    NormalVariatePair(engine, state[0], state[1]);
+    NormalVariatePair(engine, state[2], state[3]);
+
+    const SizeValueType size0 = m_NoiseSize[0];
+    for ( SizeValueType x = 0; x + 1 < size0; x += 2 )
+      {
+      NormalVariatePair(engine, row[x], row[x + 1]);
+      }
+    if ( size0 % 2 )
+      {
+      row[size0 - 1] = NormalVariate< RealType >(engine);
+      }
+
+    if ( !m_Axes[0].IsIdentity() )
+      {
+      m_Axes[0].MixInitialState(state, state + 1, state + 2, 1);
+      m_Axes[0].FilterLine(row, size0, state[0], state[1], state[2]);
+      }
+    }
+
+  double m_Sigma;
+
+  CausalRecursiveGaussian m_Axes[3];
+  RealType                m_NoiseNormalization;
+  IndexValueType          m_NoiseIndex[3];
+  SizeValueType           m_NoiseSize[3];
+
+  SizeValueType m_Slices;
+  SizeValueType m_NextSlice;
+
+  std::vector< RealType > m_Buffers[4];
+  RealType               *m_Current;
+  RealType               *m_Previous[3];
+  const RealType         *m_CurrentNoise;
+};
+
+} // End namespace itk
+
+#endif /* __itkCorrelatedGaussianNoiseImageFilter */
@@ -1,9 +1,10 @@
 #ifndef __itkImpulseNoiseImageFilter
 #define __itkImpulseNoiseImageFilter
 
-#include <itkUnaryFunctorImageFilter.h>
+#include "itkSparseNoiseImageFilter.h"
 #include <itkConceptChecking.h>
-#include <vnl/vnl_sample.h>
+
+#include "noise_kernels.h"
 
 namespace itk
 {
@@ -13,10 +14,12 @@ namespace Functor
  * \brief Adds impulse noise to a pixel.
  * \ingroup ITKImageIntensity
  */
-template< class TInput, class TOutput >
+template< class TInput, class TOutput, class TRealType = double >
 class ImpulseNoise
 {
 public:
+  typedef TRealType RealType;
+
   ImpulseNoise() {
     m_Probability = 0.01;
     m_OutputMinimum = itk::NumericTraits< TOutput >::NonpositiveMin();
@@ -62,17 +65,45 @@ public:
     return !( *this != other );
     }
 
-  inline TOutput operator()(const TInput & A) const
+  /** Impulse noise has a single variant. */
+  unsigned int GetVariant() const
+    { return 0; }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine) const
+    {
+    float selected;
+    return Evaluate< VVariant >(A, engine, selected);
+    }
+
+  /** Noisy value of a pixel, and whether it was selected (1 or 0). */
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine, float & selected) const
     {
-    if(vnl_sample_uniform(0., 1.) <= m_Probability)
+    if(UniformVariate(engine) <= m_Probability)
       {
-      if(vnl_sample_uniform(0., 1.) < 0.5)
-        return static_cast<TOutput>(m_OutputMinimum);
-      else
-        return static_cast<TOutput>(m_OutputMaximum);
+      selected = 1.0f;
+      return Corrupt< VVariant >(A, engine);
       }
+
+    selected = 0.0f;
+    return static_cast<TOutput>(A);
+    }
+
+  template< class TEngine >
+  inline TOutput operator()(const TInput & A, TEngine & engine) const
+    {
+    return Evaluate< 0 >(A, engine);
+    }
+
+  /** Impulse value of a selected pixel. */
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Corrupt(const TInput &, TEngine & engine) const
+    {
+    if(UniformVariate< RealType >(engine) < RealType(0.5))
+      return static_cast<TOutput>(m_OutputMinimum);
     else
-      return static_cast<TOutput>(A);
+      return static_cast<TOutput>(m_OutputMaximum);
     }
 
 private:
@@ -82,31 +113,41 @@ private:
   };
 } // End namespace Functor
 
-template< class TInputImage, class TOutputImage >
+template< class TInputImage, class TOutputImage, class TEngine = Xoshiro256PlusPlusEngine,
+          class TRealType = double >
 class ITK_EXPORT ImpulseNoiseImageFilter:
-public UnaryFunctorImageFilter< TInputImage, TOutputImage,
-                                Functor::ImpulseNoise<
-                                  typename TInputImage::PixelType,
-                                  typename TOutputImage::PixelType > >
+public SparseNoiseImageFilter< TInputImage, TOutputImage,
+                               Functor::ImpulseNoise<
+                                 typename TInputImage::PixelType,
+                                 typename TOutputImage::PixelType,
+                                 TRealType >,
+                               TEngine >
 {
 public:
   /** Standard class typedefs. */
   typedef ImpulseNoiseImageFilter Self;
-  typedef UnaryFunctorImageFilter<
+  typedef SparseNoiseImageFilter<
     TInputImage, TOutputImage,
     Functor::ImpulseNoise< typename TInputImage::PixelType,
-                           typename TOutputImage::PixelType > >  Superclass;
+                           typename TOutputImage::PixelType,
+                           TRealType >,
+    TEngine >  Superclass;
 
   typedef SmartPointer< Self >       Pointer;
   typedef SmartPointer< const Self > ConstPointer;
 
   typedef typename TOutputImage::PixelType OutputPixelType;
 
+  typedef typename Superclass::InputImagePixelType  InputImagePixelType;
+  typedef typename Superclass::OutputImagePixelType OutputImagePixelType;
+  typedef typename Superclass::IndexType            IndexType;
+  typedef typename Superclass::NoisePixelType       NoisePixelType;
+
   /** Method for creation through the object factory. */
   itkNewMacro(Self);
 
   /** Macro that provides the GetNameOfClass() method */
-  itkTypeMacro(ImpulseNoiseImageFilter, UnaryFunctorImageFilter);
+  itkTypeMacro(ImpulseNoiseImageFilter, SparseNoiseImageFilter);
 
   OutputPixelType GetOutputMinimum() const
     {
@@ -159,9 +200,61 @@ protected:
   ImpulseNoiseImageFilter() {}
   virtual ~ImpulseNoiseImageFilter() {}
 
+  /** unsigned char runs use the integer kernel when possible, which also
+   * writes the selection of the pixels. */
+  virtual void ProcessRun(const InputImagePixelType *in,
+                          OutputImagePixelType *out,
+                          NoisePixelType *noise,
+                          SizeValueType length,
+                          const IndexType & start) const
+    {
+    if ( !this->ProcessIntegerRun( in, out, noise, length, start, static_cast< TEngine * >( ITK_NULLPTR ) ) )
+      {
+      Superclass::ProcessRun(in, out, noise, length, start);
+      }
+    }
+
 private:
   ImpulseNoiseImageFilter(const Self &); //purposely not implemented
   void operator=(const Self &);     //purposely not implemented
+
+  template< class TIn, class TOut, class TRunEngine >
+  bool ProcessIntegerRun(const TIn *, TOut *, NoisePixelType *, SizeValueType, const IndexType &, TRunEngine *) const
+    {
+    return false;
+    }
+
+  /** unsigned char images use the integer kernel when the
+   * filter uses the engine of the kernels. */
+  bool ProcessIntegerRun(const unsigned char *in, unsigned char *out, NoisePixelType *noise,
+                         SizeValueType length, const IndexType & start,
+                         NoiseKernels::EngineType *) const
+    {
+    if ( this->GetProbability() <= 0.0 )
+      {
+      return false;
+      }
+
+    NoiseKernels::EngineType engine;
+    this->SeedRunEngine(engine, start);
+
+    NoiseKernels::impulse_u8(in, out, noise, length,
+                             NoiseKernels::impulse_threshold( this->GetProbability() ),
+                             this->GetOutputMinimum(), this->GetOutputMaximum(),
+                             engine);
+
+    // The selection is counted from the noise field, which GenerateLines()
+    // provides with the statistics.
+    if ( noise && ( this->GetFunctorVariant() & Functor::NoiseVariantStatistics ) )
+      {
+      Functor::NoiseCounts & counts = Functor::NoiseCountsOfThread();
+      for ( SizeValueType i = 0; i < length; ++i )
+        {
+        counts.m_Corrupted += noise[i] != NoisePixelType(0);
+        }
+      }
+    return true;
+    }
 };
 
 } // End namespace itk
@@ -0,0 +1,481 @@
+#ifndef __itkKSpaceNoiseImageFilter
+#define __itkKSpaceNoiseImageFilter
+
+#include "itkNoiseImageFilter.h"
+#include <itkConceptChecking.h>
+#include <itkRealToHalfHermitianForwardFFTImageFilter.h>
+#include <itkHalfHermitianToRealInverseFFTImageFilter.h>
+#include <itkImageLinearConstIteratorWithIndex.h>
+#include <itkSimpleFastMutexLock.h>
+#include <itkMutexLockHolder.h>
+
+#include <cmath>
+#include <complex>
+
+namespace itk
+{
+namespace Functor
+{
+/** \class KSpaceNoise
+ * \brief Clamps the pixels computed by KSpaceNoiseImageFilter.
+ * The standard deviation is the one of the noise in the image, before any
+ * undersampling. Used alone through Evaluate(), the functor adds white
+ * gaussian noise of this standard deviation, which is what complex white
+ * noise in k-space gives.
+ * \ingroup ITKImageIntensity
+ */
+template< class TInput, class TOutput, class TRealType = double >
+class KSpaceNoise
+{
+public:
+  typedef TRealType RealType;
+
+  KSpaceNoise()
+    {
+    m_StandardDeviation = 1.0;
+    m_OutputMinimum = itk::NumericTraits< TOutput >::NonpositiveMin();
+    m_OutputMaximum = itk::NumericTraits< TOutput >::max();
+    }
+
+  ~KSpaceNoise() {}
+
+  double GetStandardDeviation() const
+    { return m_StandardDeviation; }
+
+  void SetStandardDeviation(const double standardDeviation)
+    {
+    if(standardDeviation <= 0.0)
+      itkGenericExceptionMacro("standard deviation must be strictly positive");
+
+    m_StandardDeviation = static_cast< RealType >( standardDeviation );
+    }
+
+  TOutput GetOutputMinimum() const
+    { return m_OutputMinimum; }
+
+  TOutput GetOutputMaximum() const
+    { return m_OutputMaximum; }
+
+  void SetOutputBounds( const TOutput min, const TOutput max)
+    {
+    if(max <= min)
+      itkGenericExceptionMacro("invalid bounds: [" << min << "; " << max << "]");
+
+    m_OutputMinimum = min;
+    m_OutputMaximum = max;
+    }
+
+  bool operator!=(const KSpaceNoise &other) const
+    {
+    return m_StandardDeviation != other.m_StandardDeviation
+      || m_OutputMaximum != other.m_OutputMaximum
+      || m_OutputMinimum != other.m_OutputMinimum;
+    }
+
+  bool operator==(const KSpaceNoise & other) const
+    {
+    return !( *this != other );
+    }
+
+  /** Flags of the variant of Evaluate() matching the parameters. */
+  unsigned int GetVariant() const
+    {
+    unsigned int variant = 0;
+    if ( !NoiseClampIsNeeded< TOutput, RealType >(m_OutputMinimum, m_OutputMaximum) )
+      {
+      variant |= NoiseVariantNoClamp;
+      }
+    return variant;
+    }
+
+  /** Output pixel of a value computed in k-space. */
+  template< unsigned int VVariant >
+  inline TOutput Apply(const RealType v) const
+    {
+    return NoiseClamp< VVariant >(v, m_OutputMinimum, m_OutputMaximum);
+    }
+
+  /** Output pixel of a value computed in k-space, and its difference to
+   * the input pixel A before clamping. */
+  template< unsigned int VVariant >
+  inline TOutput Apply(const TInput & A, const RealType v, float & noise) const
+    {
+    noise = static_cast< float >( v - static_cast< RealType >( A ) );
+    return NoiseClamp< VVariant >(v, m_OutputMinimum, m_OutputMaximum);
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine) const
+    {
+    return Apply< VVariant >( static_cast< RealType >( A ) + m_StandardDeviation * NormalVariate< RealType >(engine) );
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine, float & noise) const
+    {
+    return Apply< VVariant >( A, static_cast< RealType >( A ) + m_StandardDeviation * NormalVariate< RealType >(engine), noise );
+    }
+
+  template< class TEngine >
+  inline TOutput operator()(const TInput & A, TEngine & engine) const
+    {
+    return Evaluate< 0 >(A, engine);
+    }
+
+private:
+  TOutput m_OutputMinimum;
+  TOutput m_OutputMaximum;
+  RealType m_StandardDeviation;
+};
+} // End namespace Functor
+
+/** \class KSpaceNoiseImageFilter
+ * \brief Adds complex gaussian noise in k-space, like the noise of an MR
+ * acquisition.
+ * The image is transformed with a real-to-complex FFT, which only stores
+ * the half of the spectrum not given by Hermitian symmetry. Complex white
+ * noise is added to it, and the phase encoding lines (second axis) not
+ * acquired with the AccelerationFactor are set to zero, except in the
+ * fully sampled center (CenterFraction of the lines). The image is then
+ * transformed back, and copied to the output in the mask and region of
+ * interest.
+ *
+ * The noise is scaled so that, without undersampling, it gives white noise
+ * of StandardDeviation in the image.
+ *
+ * The forward and inverse FFT filters are kept between updates as long as
+ * the image size does not change, and shared by all the filters of the
+ * same type, so that a batch of images of the same size reuses their
+ * plans. They run with as many threads as this filter. With the VNL FFT,
+ * the sizes must only have 2, 3 and 5 as prime factors.
+ * \ingroup ITKImageIntensity
+ */
+template< class TInputImage, class TOutputImage, class TEngine = Xoshiro256PlusPlusEngine,
+          class TRealType = double >
+class ITK_EXPORT KSpaceNoiseImageFilter:
+  public
+  NoiseImageFilter< TInputImage, TOutputImage,
+                    Functor::KSpaceNoise<
+                      typename TInputImage::PixelType,
+                      typename TOutputImage::PixelType,
+                      TRealType >,
+                    TEngine >
+{
+public:
+  /** Standard class typedefs. */
+  typedef KSpaceNoiseImageFilter Self;
+  typedef NoiseImageFilter<
+    TInputImage, TOutputImage,
+    Functor::KSpaceNoise< typename TInputImage::PixelType,
+                          typename TOutputImage::PixelType,
+                          TRealType >,
+    TEngine >  Superclass;
+
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  typedef typename Superclass::InputImagePixelType  InputImagePixelType;
+  typedef typename Superclass::OutputImagePixelType OutputImagePixelType;
+  typedef typename Superclass::IndexType            IndexType;
+  typedef typename Superclass::NoisePixelType       NoisePixelType;
+  typedef typename Superclass::EngineType           EngineType;
+  typedef typename TOutputImage::PixelType          OutputPixelType;
+  typedef TRealType                                 RealType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int, TOutputImage::ImageDimension);
+
+  typedef Image< RealType, itkGetStaticConstMacro(ImageDimension) >                 RealImageType;
+  typedef Image< std::complex< RealType >, itkGetStaticConstMacro(ImageDimension) > ComplexImageType;
+  typedef RealToHalfHermitianForwardFFTImageFilter< RealImageType, ComplexImageType > ForwardFFTType;
+  typedef HalfHermitianToRealInverseFFTImageFilter< ComplexImageType, RealImageType > InverseFFTType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Macro that provides the GetNameOfClass() method */
+  itkTypeMacro(KSpaceNoiseImageFilter, NoiseImageFilter);
+
+  OutputPixelType GetOutputMinimum() const
+    {
+    return this->GetFunctor().GetOutputMinimum();
+    }
+
+  OutputPixelType GetOutputMaximum() const
+    {
+    return this->GetFunctor().GetOutputMaximum();
+    }
+
+  double GetStandardDeviation() const
+    { return this->GetFunctor().GetStandardDeviation(); }
+
+  void SetOutputBounds(const OutputPixelType min, const OutputPixelType max)
+    {
+    if ( min == this->GetFunctor().GetOutputMinimum() && max == this->GetFunctor().GetOutputMaximum())
+      {
+      return;
+      }
+
+    this->GetFunctor().SetOutputBounds(min, max);
+    this->Modified();
+    }
+
+  void SetStandardDeviation(const double standardDeviation)
+    {
+    if ( standardDeviation == this->GetFunctor().GetStandardDeviation() )
+      {
+      return;
+      }
+
+    this->GetFunctor().SetStandardDeviation(standardDeviation);
+    this->Modified();
+    }
+
+  /** One phase encoding line out of AccelerationFactor is acquired
+   * outside of the center. 1 acquires all of them. */
+  itkSetClampMacro(AccelerationFactor, unsigned int, 1, NumericTraits< unsigned int >::max());
+  itkGetConstMacro(AccelerationFactor, unsigned int);
+
+  /** Fraction of the phase encoding lines, around the center of k-space,
+   * which are always acquired. */
+  itkSetClampMacro(CenterFraction, double, 0.0, 1.0);
+  itkGetConstMacro(CenterFraction, double);
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+    {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "StandardDeviation: " << static_cast<typename NumericTraits<double>::PrintType>(GetStandardDeviation()) << std::endl;
+    os << indent << "AccelerationFactor: " << m_AccelerationFactor << std::endl;
+    os << indent << "CenterFraction: " << m_CenterFraction << std::endl;
+    os << indent << "OutputMinimum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMinimum()) << std::endl;
+    os << indent << "OutputMaximum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMaximum()) << std::endl;
+    }
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  itkConceptMacro( InputConvertibleToDoubleCheck,
+    ( Concept::Convertible< typename TInputImage::PixelType, double > ) );
+  itkConceptMacro( DoubleConvertibleToOutputCheck,
+    ( Concept::Convertible< double, OutputPixelType > ) );
+#endif
+
+protected:
+  KSpaceNoiseImageFilter()
+    {
+    m_AccelerationFactor = 1;
+    m_CenterFraction = 0.08;
+    }
+
+  virtual ~KSpaceNoiseImageFilter() {}
+
+  /** The FFT needs the whole image. */
+  void GenerateInputRequestedRegion()
+    {
+    Superclass::GenerateInputRequestedRegion();
+
+    TInputImage *input = const_cast< TInputImage * >( this->GetInput() );
+    if ( input )
+      {
+      input->SetRequestedRegion( input->GetLargestPossibleRegion() );
+      }
+    }
+
+  void EnlargeOutputRequestedRegion(DataObject *output)
+    {
+    Superclass::EnlargeOutputRequestedRegion(output);
+    output->SetRequestedRegionToLargestPossibleRegion();
+    }
+
+  /** Compute the noisy image before the threads copy it to the output. */
+  void BeforeThreadedGenerateData()
+    {
+    Superclass::BeforeThreadedGenerateData();
+
+    const TInputImage *input = this->GetInput();
+
+    typename RealImageType::Pointer image = RealImageType::New();
+    image->CopyInformation(input);
+    image->SetRegions( input->GetBufferedRegion() );
+    image->Allocate();
+
+    const SizeValueType pixels = input->GetBufferedRegion().GetNumberOfPixels();
+    Superclass::CopyRun( input->GetBufferPointer(), image->GetBufferPointer(), static_cast< IndexValueType >( pixels ) );
+
+    MutexLockHolder< SimpleFastMutexLock > holder( GetFFTMutex() );
+
+    FFTFilters & filters = GetFFTFilters( image->GetLargestPossibleRegion().GetSize() );
+    filters.m_Forward->SetNumberOfThreads( this->GetNumberOfThreads() );
+    filters.m_Inverse->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+    filters.m_Forward->SetInput(image);
+    filters.m_Forward->Update();
+    typename ComplexImageType::Pointer spectrum = filters.m_Forward->GetOutput();
+    spectrum->DisconnectPipeline();
+    filters.m_Forward->SetInput(ITK_NULLPTR);
+    image = ITK_NULLPTR;
+
+    this->AddSpectrumNoise( spectrum, input->GetBufferedRegion() );
+
+    filters.m_Inverse->SetActualXDimensionIsOdd( input->GetBufferedRegion().GetSize(0) % 2 == 1 );
+    filters.m_Inverse->SetInput(spectrum);
+    filters.m_Inverse->Update();
+    m_NoisyImage = filters.m_Inverse->GetOutput();
+    m_NoisyImage->DisconnectPipeline();
+    filters.m_Inverse->SetInput(ITK_NULLPTR);
+    }
+
+  void AfterThreadedGenerateData()
+    {
+    m_NoisyImage = ITK_NULLPTR;
+    Superclass::AfterThreadedGenerateData();
+    }
+
+  void ProcessRun(const InputImagePixelType *in,
+                  OutputImagePixelType *out,
+                  NoisePixelType *noise,
+                  SizeValueType length,
+                  const IndexType & start) const
+    {
+    const RealType *noisy = m_NoisyImage->GetBufferPointer() + m_NoisyImage->ComputeOffset(start);
+
+    if ( this->GetFunctorVariant() & Functor::NoiseVariantNoClamp )
+      {
+      this->ProcessRunVariant< Functor::NoiseVariantNoClamp >(in, noisy, out, noise, length);
+      }
+    else if ( this->GetFunctorVariant() & Functor::NoiseVariantStatistics )
+      {
+      this->ProcessRunVariant< Functor::NoiseVariantStatistics >(in, noisy, out, noise, length);
+      }
+    else
+      {
+      this->ProcessRunVariant< 0 >(in, noisy, out, noise, length);
+      }
+    }
+
+private:
+  KSpaceNoiseImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+
+  struct FFTFilters
+  {
+    typename ForwardFFTType::Pointer m_Forward;
+    typename InverseFFTType::Pointer m_Inverse;
+    typename RealImageType::SizeType m_Size;
+  };
+
+  static SimpleFastMutexLock & GetFFTMutex()
+    {
+    static SimpleFastMutexLock mutex;
+    return mutex;
+    }
+
+  /** FFT filters of the given image size, created again when the size
+   * changes. Must be called with the mutex locked. */
+  static FFTFilters & GetFFTFilters(const typename RealImageType::SizeType & size)
+    {
+    static FFTFilters filters;
+
+    if ( filters.m_Forward.IsNull() || filters.m_Size != size )
+      {
+      filters.m_Forward = ForwardFFTType::New();
+      filters.m_Inverse = InverseFFTType::New();
+      filters.m_Size = size;
+      }
+    return filters;
+    }
+
+  /** Whether a phase encoding line is acquired. */
+  bool IsLineAcquired(const SizeValueType line, const SizeValueType lines) const
+    {
+    // Frequency of the line, in [-lines / 2; lines / 2].
+    const OffsetValueType frequency = line <= lines / 2 ? static_cast< OffsetValueType >( line )
+                                                        : static_cast< OffsetValueType >( line ) - static_cast< OffsetValueType >( lines );
+
+    const double center = 0.5 * m_CenterFraction * lines;
+    if ( std::fabs( static_cast< double >( frequency ) ) < center )
+      {
+      return true;
+      }
+
+    const OffsetValueType factor = static_cast< OffsetValueType >( m_AccelerationFactor );
+    return ( ( frequency % factor ) + factor ) % factor == 0;
+    }
+
+  /** Add the noise to the half spectrum of an image of the given region,
+   * and remove the lines which are not acquired. */
+  void AddSpectrumNoise(ComplexImageType *spectrum, const typename TInputImage::RegionType & imageRegion) const
+    {
+    typedef std::complex< RealType > ComplexType;
+
+    // A real white noise of variance s^2 has, in the spectrum of its N
+    // pixels, real and imaginary parts of variance N s^2 / 2. The inverse
+    // FFT only keeps the Hermitian part of the first and (for an even
+    // size) last columns, stored twice, which halves the variance there.
+    const double pixels = static_cast< double >( imageRegion.GetNumberOfPixels() );
+    const RealType deviation = static_cast< RealType >( this->GetStandardDeviation() * std::sqrt(0.5 * pixels) );
+    const RealType edgeDeviation = static_cast< RealType >( this->GetStandardDeviation() * std::sqrt(pixels) );
+
+    const typename ComplexImageType::RegionType region = spectrum->GetBufferedRegion();
+    const SizeValueType size0 = region.GetSize(0);
+    const bool evenSize = imageRegion.GetSize(0) % 2 == 0;
+
+    ImageLinearConstIteratorWithIndex< ComplexImageType > it(spectrum, region);
+    it.SetDirection(0);
+
+    for ( it.GoToBegin(); !it.IsAtEnd(); it.NextLine() )
+      {
+      const IndexType index = it.GetIndex();
+      ComplexType *row = spectrum->GetBufferPointer() + spectrum->ComputeOffset(index);
+
+      if ( ImageDimension > 1 && m_AccelerationFactor > 1
+           && !this->IsLineAcquired( index[1] - region.GetIndex(1), region.GetSize(1) ) )
+        {
+        std::fill( row, row + size0, ComplexType(0) );
+        continue;
+        }
+
+      EngineType engine;
+      this->SeedRunEngine(engine, index);
+
+      for ( SizeValueType x = 0; x < size0; ++x )
+        {
+        RealType z0, z1;
+        NormalVariatePair(engine, z0, z1);
+
+        const RealType s = ( x == 0 || ( evenSize && x == size0 - 1 ) ) ? edgeDeviation : deviation;
+        row[x] += ComplexType(s * z0, s * z1);
+        }
+      }
+    }
+
+  template< unsigned int VVariant >
+  void ProcessRunVariant(const InputImagePixelType *in,
+                         const RealType *noisy,
+                         OutputImagePixelType *out,
+                         NoisePixelType *noise,
+                         SizeValueType length) const
+    {
+    const typename Superclass::FunctorType & functor = this->GetFunctor();
+
+    if ( noise )
+      {
+      for ( SizeValueType i = 0; i < length; ++i )
+        {
+        out[i] = functor.template Apply< VVariant >(in[i], noisy[i], noise[i]);
+        }
+      return;
+      }
+
+    for ( SizeValueType i = 0; i < length; ++i )
+      {
+      out[i] = functor.template Apply< VVariant >(noisy[i]);
+      }
+    }
+
+  unsigned int m_AccelerationFactor;
+  double       m_CenterFraction;
+
+  typename RealImageType::Pointer m_NoisyImage;
+};
+
+} // End namespace itk
+
+#endif /* __itkKSpaceNoiseImageFilter */
@@ -0,0 +1,122 @@
+#ifndef __itkNoiseFunctorVariant
+#define __itkNoiseFunctorVariant
+
+#include <itkIntTypes.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace itk
+{
+namespace Functor
+{
+/** Flags of the compile-time variants of the noise functors.
+ * A functor returns with GetVariant() the flags which hold for its current
+ * parameters, and the filters call the Evaluate() (or Corrupt()) method
+ * specialized for these flags, so that the inner loops do not test the
+ * parameters for each pixel. */
+enum NoiseVariantFlags
+{
+  /** The output bounds are the full range of a floating point output type:
+   * no clamping. */
+  NoiseVariantNoClamp = 1,
+  /** The mean of an additive noise is zero. */
+  NoiseVariantZeroMean = 2,
+  /** The statistics of the filter are computed: NoiseClamp() and the
+   * sparse filters count in NoiseCountsOfThread() the values they clamp
+   * and the pixels they corrupt. Added by the filters, never returned by
+   * GetVariant(). */
+  NoiseVariantStatistics = 4
+};
+
+/** Numbers of values clamped to the output bounds and of pixels corrupted
+ * by a sparse noise, counted by the variants with NoiseVariantStatistics.
+ * The counts only grow: the filters add the difference of the counts before
+ * and after the lines of a thread to its statistics. */
+struct NoiseCounts
+{
+  SizeValueType m_BelowMinimum;
+  SizeValueType m_AboveMaximum;
+  SizeValueType m_Corrupted;
+};
+
+/** Counts of the thread calling it. */
+inline NoiseCounts & NoiseCountsOfThread()
+{
+  static thread_local NoiseCounts counts = { 0, 0, 0 };
+  return counts;
+}
+
+/** Whether values of type TRealType must be clamped to [min; max] before
+ * their conversion to TOutput. Integer outputs are always clamped, since
+ * their conversion from an out of range value is undefined. */
+template< class TOutput, class TRealType >
+inline bool NoiseClampIsNeeded(const TOutput min, const TOutput max)
+{
+  return std::numeric_limits< TOutput >::is_integer
+    || sizeof( TRealType ) > sizeof( TOutput )
+    || min != -std::numeric_limits< TOutput >::max()
+    || max != std::numeric_limits< TOutput >::max();
+}
+
+/** Clamp (branch-free) and convert a noisy value. The statistics variant
+ * counts the values out of the bounds. */
+template< unsigned int VVariant, class TOutput, class TRealType >
+inline TOutput NoiseClamp(const TRealType v, const TOutput min, const TOutput max)
+{
+  if ( VVariant & NoiseVariantNoClamp )
+    {
+    return static_cast< TOutput >( v );
+    }
+
+  if ( VVariant & NoiseVariantStatistics )
+    {
+    NoiseCounts & counts = NoiseCountsOfThread();
+    counts.m_BelowMinimum += v < static_cast< TRealType >( min );
+    counts.m_AboveMaximum += v > static_cast< TRealType >( max );
+    }
+
+  return static_cast< TOutput >( std::min( std::max( v, static_cast< TRealType >( min ) ),
+                                           static_cast< TRealType >( max ) ) );
+}
+
+/** Whether a functor has an Initialize() method, which computes its tables
+ * once its parameters are set (e.g. PoissonNoise and CameraNoise). */
+template< class TFunctor >
+class NoiseFunctorHasInitialize
+{
+  template< class U, void ( U::* )() > struct Signature {};
+
+  template< class U >
+  static char Test(Signature< U, &U::Initialize > *);
+
+  template< class U >
+  static long Test(...);
+
+public:
+  static const bool Value = sizeof( Test< TFunctor >(0) ) == sizeof( char );
+};
+
+template< class TFunctor, bool VHasInitialize = NoiseFunctorHasInitialize< TFunctor >::Value >
+struct NoiseFunctorInitializer
+{
+  static void Initialize(TFunctor &) {}
+};
+
+template< class TFunctor >
+struct NoiseFunctorInitializer< TFunctor, true >
+{
+  static void Initialize(TFunctor & functor)
+    { functor.Initialize(); }
+};
+
+/** Call the Initialize() method of a functor, if it has one. */
+template< class TFunctor >
+inline void InitializeNoiseFunctor(TFunctor & functor)
+{
+  NoiseFunctorInitializer< TFunctor >::Initialize(functor);
+}
+} // End namespace Functor
+} // End namespace itk
+
+#endif /* __itkNoiseFunctorVariant */
@@ -0,0 +1,609 @@
+#ifndef __itkNoiseImageFilter
+#define __itkNoiseImageFilter
+
+#include <itkInPlaceImageFilter.h>
+#include <itkImageLinearConstIteratorWithIndex.h>
+#include <itkProgressReporter.h>
+
+#include "itkNoiseRandomEngines.h"
+#include "itkNoiseFunctorVariant.h"
+#include "itkNoiseStatistics.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace itk
+{
+/** \class NoiseImageFilter
+ * \brief Base class of the noise filters.
+ * Applies a noise functor to each pixel, like UnaryFunctorImageFilter,
+ * but the noise can be restricted to the non-zero pixels of a mask image
+ * and/or to a region of interest. Other pixels are copied from the input.
+ *
+ * The mask is run-length encoded before the threads start, so the threads
+ * only iterate over the runs of noisy pixels and copy the others with
+ * memcpy. Subclasses can override ProcessRun() to provide a faster
+ * implementation of the noise for a run of contiguous pixels.
+ *
+ * The functor draws its random numbers from an engine of type TEngine
+ * (see itkNoiseRandomEngines.h), given as second argument of operator().
+ * The noise filters also take the type in which their functor samples and
+ * computes the noise (TRealType, double by default). float is
+ * statistically equivalent for integer output pixel types, and twice as
+ * many values fit in a vector register.
+ *
+ * The functor gives with GetVariant() the flags of the compile-time
+ * variant of its Evaluate() method matching its parameters (see
+ * itkNoiseFunctorVariant.h). The variant is chosen once in
+ * BeforeThreadedGenerateData().
+ * Runs drawing their random numbers from an engine seed it with
+ * SeedRunEngine(), from the filter seed and the index of the first pixel
+ * of the run, so the output does not depend on the way the image is split
+ * between the threads.
+ *
+ * With GenerateNoiseOutput on, the filter has a second output, the noise
+ * field: a float image giving for each pixel the noise the functor applied
+ * to it, computed in the same pass as the noisy image. It is the noisy
+ * value before clamping minus the input value for the dense noises, and
+ * 1 for the selected pixels and 0 for the others for the sparse noises.
+ * The pixels left untouched (mask, region of interest) have a zero noise.
+ *
+ * With ComputeStatistics on, each thread also sums the squared error and
+ * the energy of the signal line by line while they are in cache, and the
+ * runs use the NoiseVariantStatistics variant, which counts the values
+ * clamped by the functor and the pixels selected by the sparse noises where
+ * they are computed. The sums of the threads are added in
+ * AfterThreadedGenerateData() and given by GetStatistics().
+ * The functors give it with the Evaluate() overload taking a float
+ * reference, and ProcessRun() writes it when its noise pointer is not
+ * NULL.
+ * \ingroup ITKImageIntensity
+ */
+template< class TInputImage, class TOutputImage, class TFunction,
+          class TEngine = Xoshiro256PlusPlusEngine >
+class ITK_EXPORT NoiseImageFilter:
+  public InPlaceImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef NoiseImageFilter                                Self;
+  typedef InPlaceImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                            Pointer;
+  typedef SmartPointer< const Self >                      ConstPointer;
+
+  /** Macro that provides the GetNameOfClass() method */
+  itkTypeMacro(NoiseImageFilter, InPlaceImageFilter);
+
+  itkStaticConstMacro(ImageDimension, unsigned int, TOutputImage::ImageDimension);
+
+  typedef TFunction FunctorType;
+  typedef TEngine   EngineType;
+
+  typedef TInputImage                              InputImageType;
+  typedef typename InputImageType::PixelType       InputImagePixelType;
+  typedef TOutputImage                             OutputImageType;
+  typedef typename OutputImageType::PixelType      OutputImagePixelType;
+  typedef typename OutputImageType::RegionType     OutputImageRegionType;
+  typedef typename OutputImageType::IndexType      IndexType;
+
+  typedef Image< unsigned char, itkGetStaticConstMacro(ImageDimension) > MaskImageType;
+  typedef typename MaskImageType::PixelType                             MaskPixelType;
+
+  typedef Image< float, itkGetStaticConstMacro(ImageDimension) > NoiseImageType;
+  typedef typename NoiseImageType::PixelType                    NoisePixelType;
+
+  FunctorType & GetFunctor()
+    { return m_Functor; }
+
+  const FunctorType & GetFunctor() const
+    { return m_Functor; }
+
+  void SetFunctor(const FunctorType & functor)
+    {
+    if ( m_Functor != functor )
+      {
+      m_Functor = functor;
+      this->Modified();
+      }
+    }
+
+  /** Restrict the noise to the non-zero pixels of the mask.
+   * The mask must have the same geometry as the input. */
+  void SetMaskImage(const MaskImageType *mask)
+    {
+    this->SetNthInput( 1, const_cast< MaskImageType * >( mask ) );
+    }
+
+  const MaskImageType * GetMaskImage() const
+    {
+    return static_cast< const MaskImageType * >( this->ProcessObject::GetInput(1) );
+    }
+
+  /** Restrict the noise to a region of the image. */
+  void SetRegionOfInterest(const OutputImageRegionType & region)
+    {
+    if ( m_UseRegionOfInterest && region == m_RegionOfInterest )
+      {
+      return;
+      }
+
+    m_RegionOfInterest = region;
+    m_UseRegionOfInterest = true;
+    this->Modified();
+    }
+
+  /** Seed of the random number engines. */
+  itkSetMacro(Seed, uint64_t);
+  itkGetConstMacro(Seed, uint64_t);
+
+  /** Produce the noise field as second output. */
+  void SetGenerateNoiseOutput(const bool generate)
+    {
+    if ( generate == m_GenerateNoiseOutput )
+      {
+      return;
+      }
+
+    m_GenerateNoiseOutput = generate;
+    if ( generate )
+      {
+      this->SetNumberOfRequiredOutputs(2);
+      this->SetNthOutput( 1, this->MakeOutput(1) );
+      }
+    else
+      {
+      this->SetNumberOfRequiredOutputs(1);
+      this->RemoveOutput(1);
+      }
+    this->Modified();
+    }
+
+  itkGetConstMacro(GenerateNoiseOutput, bool);
+  itkBooleanMacro(GenerateNoiseOutput);
+
+  /** Compare the output to the input while generating it. */
+  itkSetMacro(ComputeStatistics, bool);
+  itkGetConstMacro(ComputeStatistics, bool);
+  itkBooleanMacro(ComputeStatistics);
+
+  /** Statistics of the last update, with ComputeStatistics. */
+  const NoiseStatistics & GetStatistics() const
+    { return m_Statistics; }
+
+  /** Noise field, NULL without GenerateNoiseOutput. */
+  NoiseImageType * GetNoiseOutput()
+    {
+    if ( !m_GenerateNoiseOutput )
+      {
+      return ITK_NULLPTR;
+      }
+    return static_cast< NoiseImageType * >( this->ProcessObject::GetOutput(1) );
+    }
+
+  /** Create the noisy image or the noise field. */
+  using Superclass::MakeOutput;
+  virtual DataObject::Pointer MakeOutput(ProcessObject::DataObjectPointerArraySizeType idx)
+    {
+    if ( idx == 1 )
+      {
+      return NoiseImageType::New().GetPointer();
+      }
+    return Superclass::MakeOutput(idx);
+    }
+
+  const OutputImageRegionType & GetRegionOfInterest() const
+    { return m_RegionOfInterest; }
+
+  bool GetUseRegionOfInterest() const
+    { return m_UseRegionOfInterest; }
+
+  void ClearRegionOfInterest()
+    {
+    if ( m_UseRegionOfInterest )
+      {
+      m_UseRegionOfInterest = false;
+      this->Modified();
+      }
+    }
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+    {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "Seed: " << m_Seed << std::endl;
+    os << indent << "GenerateNoiseOutput: " << m_GenerateNoiseOutput << std::endl;
+    os << indent << "ComputeStatistics: " << m_ComputeStatistics << std::endl;
+    os << indent << "MaskImage: " << this->GetMaskImage() << std::endl;
+    os << indent << "UseRegionOfInterest: " << m_UseRegionOfInterest << std::endl;
+    os << indent << "RegionOfInterest: " << m_RegionOfInterest << std::endl;
+    }
+
+protected:
+  NoiseImageFilter()
+    {
+    m_Seed = 0;
+    m_FunctorVariant = 0;
+    m_UseRegionOfInterest = false;
+    m_GenerateNoiseOutput = false;
+    m_ComputeStatistics = false;
+    this->SetNumberOfRequiredInputs(1);
+    this->InPlaceOff();
+    }
+
+  virtual ~NoiseImageFilter() {}
+
+  /** Choose the functor variant, reset the statistics and run-length
+   * encode the mask. */
+  void BeforeThreadedGenerateData()
+    {
+    m_FunctorVariant = m_Functor.GetVariant();
+    if ( m_ComputeStatistics )
+      {
+      m_FunctorVariant |= Functor::NoiseVariantStatistics;
+      }
+
+    m_Statistics = NoiseStatistics();
+    m_ThreadStatistics.assign( m_ComputeStatistics ? this->GetNumberOfThreads() : 0, NoiseStatistics() );
+
+    m_MaskRunOffsets.clear();
+    m_MaskRuns.clear();
+
+    const MaskImageType *mask = this->GetMaskImage();
+    if ( !mask )
+      {
+      return;
+      }
+
+    // The runs of the lines of the output are looked up by their offset in
+    // the mask.
+    const typename MaskImageType::RegionType region = mask->GetBufferedRegion();
+    const OutputImageRegionType requested = this->GetOutput()->GetRequestedRegion();
+    if ( !region.IsInside(requested) )
+      {
+      itkExceptionMacro("the mask (index " << region.GetIndex() << ", size " << region.GetSize()
+                        << ") does not cover the output (index " << requested.GetIndex()
+                        << ", size " << requested.GetSize() << ")");
+      }
+
+    const SizeValueType  size0 = region.GetSize(0);
+    const IndexValueType begin0 = region.GetIndex(0);
+    const SizeValueType  rows = size0 > 0 ? region.GetNumberOfPixels() / size0 : 0;
+
+    const MaskPixelType *row = mask->GetBufferPointer();
+
+    m_MaskRunOffsets.reserve(rows + 1);
+    for ( SizeValueType r = 0; r < rows; ++r, row += size0 )
+      {
+      m_MaskRunOffsets.push_back( m_MaskRuns.size() );
+
+      SizeValueType x = 0;
+      while ( x < size0 )
+        {
+        while ( x < size0 && row[x] == 0 ) { ++x; }
+        if ( x == size0 )
+          {
+          break;
+          }
+
+        const SizeValueType runBegin = x;
+        while ( x < size0 && row[x] != 0 ) { ++x; }
+
+        m_MaskRuns.push_back( begin0 + static_cast< IndexValueType >( runBegin ) );
+        m_MaskRuns.push_back( begin0 + static_cast< IndexValueType >( x ) );
+        }
+      }
+    m_MaskRunOffsets.push_back( m_MaskRuns.size() );
+    }
+
+  void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                            ThreadIdType threadId)
+    {
+    const SizeValueType size0 = outputRegionForThread.GetSize(0);
+    if ( size0 == 0 )
+      {
+      return;
+      }
+
+    ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() / size0 );
+
+    if ( !m_ComputeStatistics )
+      {
+      this->GenerateLines(outputRegionForThread, progress, ITK_NULLPTR);
+      return;
+      }
+
+    NoiseStatistics statistics;
+    this->GenerateLines(outputRegionForThread, progress, &statistics);
+    m_ThreadStatistics[threadId] += statistics;
+    }
+
+  /** Add the statistics of the threads. */
+  void AfterThreadedGenerateData()
+    {
+    for ( size_t i = 0; i < m_ThreadStatistics.size(); ++i )
+      {
+      m_Statistics += m_ThreadStatistics[i];
+      }
+    m_ThreadStatistics.clear();
+    }
+
+  /** Statistics of a thread, NULL without ComputeStatistics. */
+  NoiseStatistics * GetThreadStatistics(const ThreadIdType threadId)
+    {
+    return m_ComputeStatistics ? &m_ThreadStatistics[threadId] : ITK_NULLPTR;
+    }
+
+  /** Process the lines of a region: copy the pixels outside of the mask
+   * and of the region of interest, and call ProcessRun() on the others.
+   * Reports the completion of each line to progress, and adds the
+   * statistics of the lines to statistics when it is not NULL. The runs
+   * then always receive a noise field, from which the integer kernels
+   * count their saturated and corrupted pixels. */
+  void GenerateLines(const OutputImageRegionType & region, ProgressReporter & progress,
+                     NoiseStatistics *statistics)
+    {
+    const SizeValueType size0 = region.GetSize(0);
+    if ( size0 == 0 )
+      {
+      return;
+      }
+
+    const InputImageType *inputPtr = this->GetInput();
+    OutputImageType      *outputPtr = this->GetOutput(0);
+    NoiseImageType       *noisePtr = this->GetNoiseOutput();
+    const MaskImageType  *maskPtr = this->GetMaskImage();
+
+    const IndexValueType begin0 = region.GetIndex(0);
+    const IndexValueType end0 = begin0 + static_cast< IndexValueType >( size0 );
+
+    std::vector< NoisePixelType > lineNoise;
+    if ( statistics && !noisePtr )
+      {
+      lineNoise.resize(size0);
+      }
+
+    const Functor::NoiseCounts counts = Functor::NoiseCountsOfThread();
+    SizeValueType              noised = 0;
+
+    ImageLinearConstIteratorWithIndex< OutputImageType > it(outputPtr, region);
+    it.SetDirection(0);
+
+    for ( it.GoToBegin(); !it.IsAtEnd(); it.NextLine() )
+      {
+      const IndexType index = it.GetIndex();
+
+      const InputImagePixelType *in = inputPtr->GetBufferPointer() + inputPtr->ComputeOffset(index);
+      OutputImagePixelType      *out = outputPtr->GetBufferPointer() + outputPtr->ComputeOffset(index);
+      NoisePixelType            *noise = ITK_NULLPTR;
+      if ( noisePtr )
+        {
+        noise = noisePtr->GetBufferPointer() + noisePtr->ComputeOffset(index);
+        }
+      else if ( !lineNoise.empty() )
+        {
+        noise = &lineNoise[0];
+        }
+      if ( noise )
+        {
+        std::fill( noise, noise + size0, NoisePixelType(0) );
+        }
+
+      // Part of the line which may be noised.
+      IndexValueType lo = begin0;
+      IndexValueType hi = end0;
+      if ( m_UseRegionOfInterest )
+        {
+        this->CropLineToRegionOfInterest(index, lo, hi);
+        }
+
+      IndexType runStart = index;
+
+      IndexValueType x = begin0;
+      if ( lo < hi )
+        {
+        if ( maskPtr )
+          {
+          IndexType rowIndex = index;
+          rowIndex[0] = maskPtr->GetBufferedRegion().GetIndex(0);
+          const SizeValueType row = maskPtr->ComputeOffset(rowIndex) / maskPtr->GetBufferedRegion().GetSize(0);
+
+          for ( SizeValueType r = m_MaskRunOffsets[row]; r < m_MaskRunOffsets[row + 1]; r += 2 )
+            {
+            const IndexValueType runBegin = std::max( m_MaskRuns[r], lo );
+            const IndexValueType runEnd = std::min( m_MaskRuns[r + 1], hi );
+            if ( runBegin >= runEnd )
+              {
+              continue;
+              }
+
+            CopyRun( in + ( x - begin0 ), out + ( x - begin0 ), runBegin - x );
+            runStart[0] = runBegin;
+            this->ProcessRun( in + ( runBegin - begin0 ), out + ( runBegin - begin0 ),
+                              noise ? noise + ( runBegin - begin0 ) : ITK_NULLPTR,
+                              runEnd - runBegin, runStart );
+            noised += runEnd - runBegin;
+            x = runEnd;
+            }
+          }
+        else
+          {
+          CopyRun( in, out, lo - x );
+          runStart[0] = lo;
+          this->ProcessRun( in + ( lo - begin0 ), out + ( lo - begin0 ),
+                            noise ? noise + ( lo - begin0 ) : ITK_NULLPTR,
+                            hi - lo, runStart );
+          noised += hi - lo;
+          x = hi;
+          }
+        }
+
+      CopyRun( in + ( x - begin0 ), out + ( x - begin0 ), end0 - x );
+
+      if ( statistics )
+        {
+        AccumulateLine( in, out, size0, *statistics );
+        }
+
+      progress.CompletedPixel();
+      }
+
+    if ( statistics )
+      {
+      const Functor::NoiseCounts & after = Functor::NoiseCountsOfThread();
+      statistics->m_AtMinimum += after.m_BelowMinimum - counts.m_BelowMinimum;
+      statistics->m_AtMaximum += after.m_AboveMaximum - counts.m_AboveMaximum;
+      statistics->m_Corrupted += this->IsSparse() ? after.m_Corrupted - counts.m_Corrupted : noised;
+      }
+    }
+
+  /** Whether the noise only corrupts a random subset of the pixels of the
+   * runs, which ProcessRun() then counts in NoiseCountsOfThread(). */
+  virtual bool IsSparse() const
+    { return false; }
+
+  /** Apply the noise to a run of contiguous pixels, and write the noise
+   * field of the run in noise when it is not NULL (it is zeroed before).
+   * Must be thread safe. */
+  virtual void ProcessRun(const InputImagePixelType *in,
+                          OutputImagePixelType *out,
+                          NoisePixelType *noise,
+                          SizeValueType length,
+                          const IndexType & start) const
+    {
+    switch ( m_FunctorVariant )
+      {
+      case 0: this->ProcessRunVariant< 0 >(in, out, noise, length, start); break;
+      case 1: this->ProcessRunVariant< 1 >(in, out, noise, length, start); break;
+      case 2: this->ProcessRunVariant< 2 >(in, out, noise, length, start); break;
+      case 3: this->ProcessRunVariant< 3 >(in, out, noise, length, start); break;
+      case 4: this->ProcessRunVariant< 4 >(in, out, noise, length, start); break;
+      case 5: this->ProcessRunVariant< 5 >(in, out, noise, length, start); break;
+      case 6: this->ProcessRunVariant< 6 >(in, out, noise, length, start); break;
+      default: this->ProcessRunVariant< 7 >(in, out, noise, length, start); break;
+      }
+    }
+
+  /** Flags of the functor variant chosen for the current update. */
+  unsigned int GetFunctorVariant() const
+    { return m_FunctorVariant; }
+
+  /** Seed the engine of the run starting at the given index. */
+  template< class TRunEngine >
+  void SeedRunEngine(TRunEngine & engine, const IndexType & start) const
+    {
+    SeedIndexStream(engine, m_Seed, start);
+    }
+
+  /** Copy a run of pixels from the input to the output. */
+  template< class TIn, class TOut >
+  static void CopyRun(const TIn *in, TOut *out, const IndexValueType length)
+    {
+    for ( IndexValueType i = 0; i < length; ++i )
+      {
+      out[i] = static_cast< TOut >( in[i] );
+      }
+    }
+
+  template< class T >
+  static void CopyRun(const T *in, T *out, const IndexValueType length)
+    {
+    // Nothing to do when running in place.
+    if ( length > 0 && in != out )
+      {
+      std::memcpy( out, in, length * sizeof( T ) );
+      }
+    }
+
+private:
+  NoiseImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+
+  static void AccumulateLine(const InputImagePixelType *in,
+                             const OutputImagePixelType *out,
+                             const SizeValueType length,
+                             NoiseStatistics & statistics)
+    {
+    double squaredError = 0.0;
+    double signalEnergy = 0.0;
+
+    for ( SizeValueType i = 0; i < length; ++i )
+      {
+      const double a = static_cast< double >( in[i] );
+      const double b = static_cast< double >( out[i] );
+      squaredError += ( b - a ) * ( b - a );
+      signalEnergy += a * a;
+      }
+
+    statistics.m_Pixels += length;
+    statistics.m_SquaredError += squaredError;
+    statistics.m_SignalEnergy += signalEnergy;
+    }
+
+  template< unsigned int VVariant >
+  void ProcessRunVariant(const InputImagePixelType *in,
+                         OutputImagePixelType *out,
+                         NoisePixelType *noise,
+                         SizeValueType length,
+                         const IndexType & start) const
+    {
+    EngineType engine;
+    this->SeedRunEngine(engine, start);
+
+    if ( noise )
+      {
+      for ( SizeValueType i = 0; i < length; ++i )
+        {
+        out[i] = m_Functor.template Evaluate< VVariant >( in[i], engine, noise[i] );
+        }
+      return;
+      }
+
+    for ( SizeValueType i = 0; i < length; ++i )
+      {
+      out[i] = m_Functor.template Evaluate< VVariant >( in[i], engine );
+      }
+    }
+
+  void CropLineToRegionOfInterest(const IndexType & index, IndexValueType & lo, IndexValueType & hi) const
+    {
+    const IndexType & roiIndex = m_RegionOfInterest.GetIndex();
+    const typename OutputImageRegionType::SizeType & roiSize = m_RegionOfInterest.GetSize();
+
+    for ( unsigned int d = 1; d < ImageDimension; ++d )
+      {
+      if ( index[d] < roiIndex[d] || index[d] >= roiIndex[d] + static_cast< IndexValueType >( roiSize[d] ) )
+        {
+        hi = lo;
+        return;
+        }
+      }
+
+    lo = std::max( lo, roiIndex[0] );
+    hi = std::min( hi, roiIndex[0] + static_cast< IndexValueType >( roiSize[0] ) );
+    }
+
+  FunctorType m_Functor;
+
+  uint64_t m_Seed;
+
+  unsigned int m_FunctorVariant;
+
+  OutputImageRegionType m_RegionOfInterest;
+  bool                  m_UseRegionOfInterest;
+
+  bool m_GenerateNoiseOutput;
+
+  bool                           m_ComputeStatistics;
+  NoiseStatistics                m_Statistics;
+  std::vector< NoiseStatistics > m_ThreadStatistics;
+
+  /** Run-length encoded mask: the runs of the i-th line of the mask are
+   * the [begin, end) pairs of m_MaskRuns between m_MaskRunOffsets[i] and
+   * m_MaskRunOffsets[i + 1]. */
+  std::vector< SizeValueType >  m_MaskRunOffsets;
+  std::vector< IndexValueType > m_MaskRuns;
+};
+
+} // End namespace itk
+
+#endif /* __itkNoiseImageFilter */
@@ -0,0 +1,205 @@
+#ifndef __itkNoiseImageSource
+#define __itkNoiseImageSource
+
+#include <itkImageSource.h>
+#include <itkImageLinearConstIteratorWithIndex.h>
+#include <itkProgressReporter.h>
+
+#include "itkNoiseRandomEngines.h"
+#include "itkNoiseFunctorVariant.h"
+
+namespace itk
+{
+/** \class NoiseImageSource
+ * \brief Generates an image of noise without input image.
+ * Applies a noise functor (the functor of any pixel-wise noise filter,
+ * e.g. AdditiveGaussianNoiseImageFilter::FunctorType) to a constant
+ * Background intensity, over an image of the given geometry.
+ *
+ * Only the requested region is generated, and each line draws its random
+ * numbers from an engine seeded with the seed and the index of the line
+ * (see SeedIndexStream()), so the image is the same whatever the number of
+ * threads and however a writer streams it. Its pixels follow the
+ * distribution of the output of the matching filter for a constant input,
+ * but are not the same values: the filters which draw their runs by blocks
+ * or by pairs, select their pixels, or use the integer kernels consume the
+ * engine in another order than Evaluate(). As the filters do, the source
+ * computes the tables of the functors which have an Initialize() method
+ * before the threads start.
+ * \ingroup ITKImageSources
+ */
+template< class TOutputImage, class TFunction, class TEngine = Xoshiro256PlusPlusEngine >
+class ITK_EXPORT NoiseImageSource:
+  public ImageSource< TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef NoiseImageSource            Self;
+  typedef ImageSource< TOutputImage > Superclass;
+  typedef SmartPointer< Self >        Pointer;
+  typedef SmartPointer< const Self >  ConstPointer;
+
+  typedef TFunction FunctorType;
+  typedef TEngine   EngineType;
+
+  typedef TOutputImage                              OutputImageType;
+  typedef typename OutputImageType::PixelType       OutputImagePixelType;
+  typedef typename OutputImageType::RegionType      OutputImageRegionType;
+  typedef typename OutputImageType::IndexType       IndexType;
+  typedef typename OutputImageType::SizeType        SizeType;
+  typedef typename OutputImageType::SpacingType     SpacingType;
+  typedef typename OutputImageType::PointType       PointType;
+  typedef typename OutputImageType::DirectionType   DirectionType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int, TOutputImage::ImageDimension);
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Macro that provides the GetNameOfClass() method */
+  itkTypeMacro(NoiseImageSource, ImageSource);
+
+  FunctorType & GetFunctor()
+    { return m_Functor; }
+
+  const FunctorType & GetFunctor() const
+    { return m_Functor; }
+
+  void SetFunctor(const FunctorType & functor)
+    {
+    if ( m_Functor != functor )
+      {
+      m_Functor = functor;
+      this->Modified();
+      }
+    }
+
+  /** Geometry of the generated image. */
+  itkSetMacro(Size, SizeType);
+  itkGetConstReferenceMacro(Size, SizeType);
+  itkSetMacro(Spacing, SpacingType);
+  itkGetConstReferenceMacro(Spacing, SpacingType);
+  itkSetMacro(Origin, PointType);
+  itkGetConstReferenceMacro(Origin, PointType);
+  itkSetMacro(Direction, DirectionType);
+  itkGetConstReferenceMacro(Direction, DirectionType);
+
+  /** Intensity of the image the noise is applied to. */
+  itkSetMacro(Background, OutputImagePixelType);
+  itkGetConstMacro(Background, OutputImagePixelType);
+
+  /** Seed of the random number engines. */
+  itkSetMacro(Seed, uint64_t);
+  itkGetConstMacro(Seed, uint64_t);
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+    {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "Size: " << m_Size << std::endl;
+    os << indent << "Spacing: " << m_Spacing << std::endl;
+    os << indent << "Origin: " << m_Origin << std::endl;
+    os << indent << "Direction: " << m_Direction << std::endl;
+    os << indent << "Background: " << static_cast<typename NumericTraits<OutputImagePixelType>::PrintType>(m_Background) << std::endl;
+    os << indent << "Seed: " << m_Seed << std::endl;
+    }
+
+protected:
+  NoiseImageSource()
+    {
+    m_Size.Fill(64);
+    m_Spacing.Fill(1.0);
+    m_Origin.Fill(0.0);
+    m_Direction.SetIdentity();
+    m_Background = NumericTraits< OutputImagePixelType >::ZeroValue();
+    m_Seed = 0;
+    m_FunctorVariant = 0;
+    }
+
+  virtual ~NoiseImageSource() {}
+
+  void GenerateOutputInformation()
+    {
+    OutputImageType *output = this->GetOutput(0);
+
+    OutputImageRegionType largestPossibleRegion;
+    largestPossibleRegion.SetSize(m_Size);
+    output->SetLargestPossibleRegion(largestPossibleRegion);
+
+    output->SetSpacing(m_Spacing);
+    output->SetOrigin(m_Origin);
+    output->SetDirection(m_Direction);
+    }
+
+  /** Compute the tables of the functor, if any, and choose its variant. */
+  void BeforeThreadedGenerateData()
+    {
+    Functor::InitializeNoiseFunctor(m_Functor);
+    m_FunctorVariant = m_Functor.GetVariant();
+    }
+
+  void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                            ThreadIdType threadId)
+    {
+    switch ( m_FunctorVariant )
+      {
+      case 0: this->ThreadedGenerateDataVariant< 0 >(outputRegionForThread, threadId); break;
+      case 1: this->ThreadedGenerateDataVariant< 1 >(outputRegionForThread, threadId); break;
+      case 2: this->ThreadedGenerateDataVariant< 2 >(outputRegionForThread, threadId); break;
+      default: this->ThreadedGenerateDataVariant< 3 >(outputRegionForThread, threadId); break;
+      }
+    }
+
+private:
+  NoiseImageSource(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+
+  template< unsigned int VVariant >
+  void ThreadedGenerateDataVariant(const OutputImageRegionType & outputRegionForThread,
+                                   ThreadIdType threadId)
+    {
+    const SizeValueType size0 = outputRegionForThread.GetSize(0);
+    if ( size0 == 0 )
+      {
+      return;
+      }
+
+    ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() / size0 );
+
+    OutputImageType *outputPtr = this->GetOutput(0);
+
+    ImageLinearConstIteratorWithIndex< OutputImageType > it(outputPtr, outputRegionForThread);
+    it.SetDirection(0);
+
+    for ( it.GoToBegin(); !it.IsAtEnd(); it.NextLine() )
+      {
+      const IndexType index = it.GetIndex();
+      OutputImagePixelType *out = outputPtr->GetBufferPointer() + outputPtr->ComputeOffset(index);
+
+      EngineType engine;
+      SeedIndexStream(engine, m_Seed, index);
+
+      for ( SizeValueType x = 0; x < size0; ++x )
+        {
+        out[x] = m_Functor.template Evaluate< VVariant >(m_Background, engine);
+        }
+
+      progress.CompletedPixel();
+      }
+    }
+
+  FunctorType m_Functor;
+
+  SizeType      m_Size;
+  SpacingType   m_Spacing;
+  PointType     m_Origin;
+  DirectionType m_Direction;
+
+  OutputImagePixelType m_Background;
+  uint64_t             m_Seed;
+
+  unsigned int m_FunctorVariant;
+};
+
+} // End namespace itk
+
+#endif /* __itkNoiseImageSource */
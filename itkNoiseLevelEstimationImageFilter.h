@@ -0,0 +1,389 @@
+#ifndef __itkNoiseLevelEstimationImageFilter
+#define __itkNoiseLevelEstimationImageFilter
+
+#include <itkImageToImageFilter.h>
+#include <itkImageLinearConstIteratorWithIndex.h>
+#include <itkProgressReporter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace itk
+{
+/** \class NoiseResidualHistogram
+ * \brief Distribution of positive values, for the quantiles of the
+ * residuals of NoiseLevelEstimationImageFilter.
+ * The values below the number of bins are counted in bins of width 1,
+ * which is exact for integer values; the other ones are kept in an
+ * overflow list, sorted partially when a quantile falls into it.
+ */
+class NoiseResidualHistogram
+{
+public:
+  NoiseResidualHistogram(const SizeValueType bins = 0):
+    m_Bins(bins, 0),
+    m_Count(0)
+    {}
+
+  void Add(const double value)
+    {
+    ++m_Count;
+    if ( value < m_Bins.size() )
+      {
+      ++m_Bins[static_cast< size_t >( value )];
+      }
+    else
+      {
+      m_Overflow.push_back(value);
+      }
+    }
+
+  /** Add the values of another histogram with the same number of bins. */
+  void Merge(const NoiseResidualHistogram & other)
+    {
+    for ( size_t i = 0; i < m_Bins.size(); ++i )
+      {
+      m_Bins[i] += other.m_Bins[i];
+      }
+    m_Overflow.insert( m_Overflow.end(), other.m_Overflow.begin(), other.m_Overflow.end() );
+    m_Count += other.m_Count;
+    }
+
+  SizeValueType GetCount() const
+    { return m_Count; }
+
+  /** Value of rank q * (count - 1), q in [0; 1]. Reorders the overflow
+   * list. */
+  double Quantile(const double q)
+    {
+    if ( m_Count == 0 )
+      {
+      return 0.0;
+      }
+
+    SizeValueType rank = static_cast< SizeValueType >( q * ( m_Count - 1 ) );
+    for ( size_t i = 0; i < m_Bins.size(); ++i )
+      {
+      if ( rank < m_Bins[i] )
+        {
+        return static_cast< double >( i );
+        }
+      rank -= m_Bins[i];
+      }
+
+    std::nth_element( m_Overflow.begin(), m_Overflow.begin() + rank, m_Overflow.end() );
+    return m_Overflow[rank];
+    }
+
+  /** Number of values strictly greater than threshold. */
+  SizeValueType CountAbove(const double threshold) const
+    {
+    SizeValueType count = 0;
+    for ( size_t i = 0; i < m_Bins.size(); ++i )
+      {
+      if ( i > threshold )
+        {
+        count += m_Bins[i];
+        }
+      }
+    for ( size_t i = 0; i < m_Overflow.size(); ++i )
+      {
+      if ( m_Overflow[i] > threshold )
+        {
+        ++count;
+        }
+      }
+    return count;
+    }
+
+private:
+  std::vector< SizeValueType > m_Bins;
+  std::vector< double >        m_Overflow;
+  SizeValueType                m_Count;
+};
+
+/** \class NoiseLevelEstimationImageFilter
+ * \brief Estimates the noise already in an image, as the parameters of the
+ * noise filters that would give it.
+ * The residual of a pixel is the separable second difference [1 -2 1] of
+ * the image along each axis of at least 3 pixels: the smooth structures
+ * cancel out, and independent noise of standard deviation sigma gives a
+ * residual of standard deviation sigma * sqrt(6^k) over k axes. The noise
+ * standard deviation is estimated robustly from the median absolute
+ * residual (MAD), scaled by 1.4826 as for a gaussian.
+ *
+ * The impulse probability is the fraction of the pixels at a bound of the
+ * pixel type whose absolute residual exceeds OutlierThreshold times the
+ * residual standard deviation, i.e. the pixels of impulse noise.
+ *
+ * The residuals are computed in a single pass, split between the threads,
+ * on the interior pixels of the image. With integer pixels they are
+ * integers, so their median is taken exactly from per-thread histograms;
+ * with floating point pixels it is selected with std::nth_element.
+ *
+ * The output is the input, as for StatisticsImageFilter.
+ */
+template< class TInputImage >
+class ITK_EXPORT NoiseLevelEstimationImageFilter:
+  public ImageToImageFilter< TInputImage, TInputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef NoiseLevelEstimationImageFilter                Self;
+  typedef ImageToImageFilter< TInputImage, TInputImage > Superclass;
+  typedef SmartPointer< Self >                           Pointer;
+  typedef SmartPointer< const Self >                     ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Macro that provides the GetNameOfClass() method */
+  itkTypeMacro(NoiseLevelEstimationImageFilter, ImageToImageFilter);
+
+  itkStaticConstMacro(ImageDimension, unsigned int, TInputImage::ImageDimension);
+
+  typedef TInputImage                          InputImageType;
+  typedef typename InputImageType::PixelType   InputImagePixelType;
+  typedef typename InputImageType::RegionType  RegionType;
+  typedef typename InputImageType::IndexType   IndexType;
+  typedef typename InputImageType::SizeType    SizeType;
+
+  /** Number of residual standard deviations above which a pixel at a
+   * bound of the pixel type is counted as impulse noise. */
+  itkSetMacro(OutlierThreshold, double);
+  itkGetConstMacro(OutlierThreshold, double);
+
+  /** Estimated standard deviation of the noise (see --stddev). */
+  itkGetConstMacro(StandardDeviation, double);
+
+  /** Estimated probability of the impulse noise (see --probability). */
+  itkGetConstMacro(ImpulseProbability, double);
+
+  /** Number of pixels the estimates are computed from. */
+  itkGetConstMacro(Pixels, SizeValueType);
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+    {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "OutlierThreshold: " << m_OutlierThreshold << std::endl;
+    os << indent << "StandardDeviation: " << m_StandardDeviation << std::endl;
+    os << indent << "ImpulseProbability: " << m_ImpulseProbability << std::endl;
+    os << indent << "Pixels: " << m_Pixels << std::endl;
+    }
+
+protected:
+  NoiseLevelEstimationImageFilter()
+    {
+    m_OutlierThreshold = 5.0;
+    m_StandardDeviation = 0.0;
+    m_ImpulseProbability = 0.0;
+    m_Pixels = 0;
+    m_UseFirstAxis = false;
+    m_ResidualAxes = 0;
+    }
+
+  virtual ~NoiseLevelEstimationImageFilter() {}
+
+  /** The residuals need the neighbours of the pixels. */
+  void GenerateInputRequestedRegion()
+    {
+    Superclass::GenerateInputRequestedRegion();
+
+    InputImageType *input = const_cast< InputImageType * >( this->GetInput() );
+    if ( input )
+      {
+      input->SetRequestedRegion( input->GetLargestPossibleRegion() );
+      }
+    }
+
+  void EnlargeOutputRequestedRegion(DataObject *output)
+    {
+    Superclass::EnlargeOutputRequestedRegion(output);
+    output->SetRequestedRegionToLargestPossibleRegion();
+    }
+
+  /** The output is the input: graft it instead of allocating it. */
+  void AllocateOutputs()
+    {
+    this->GraftOutput( const_cast< InputImageType * >( this->GetInput() ) );
+    }
+
+  /** Compute the offsets and weights of the neighbours of a pixel along the
+   * axes other than the first, and clear the histograms of the threads. */
+  void BeforeThreadedGenerateData()
+    {
+    const InputImageType *input = this->GetInput();
+    const SizeType size = input->GetLargestPossibleRegion().GetSize();
+    const OffsetValueType *offsetTable = input->GetOffsetTable();
+
+    m_UseFirstAxis = size[0] >= 3;
+    m_ResidualAxes = m_UseFirstAxis ? 1 : 0;
+
+    m_NeighbourOffsets.assign(1, 0);
+    m_NeighbourWeights.assign(1, 1.0);
+    for ( unsigned int d = 1; d < ImageDimension; ++d )
+      {
+      if ( size[d] < 3 )
+        {
+        continue;
+        }
+      ++m_ResidualAxes;
+
+      const size_t count = m_NeighbourOffsets.size();
+      for ( size_t i = 0; i < count; ++i )
+        {
+        m_NeighbourOffsets.push_back( m_NeighbourOffsets[i] - offsetTable[d] );
+        m_NeighbourWeights.push_back( m_NeighbourWeights[i] );
+        m_NeighbourOffsets.push_back( m_NeighbourOffsets[i] + offsetTable[d] );
+        m_NeighbourWeights.push_back( m_NeighbourWeights[i] );
+        m_NeighbourWeights[i] *= -2.0;
+        }
+      }
+
+    if ( m_ResidualAxes == 0 )
+      {
+      itkExceptionMacro("the image needs at least 3 pixels along an axis");
+      }
+
+    const SizeValueType bins = NumericTraits< InputImagePixelType >::is_integer ? 65536 : 0;
+    m_ThreadResiduals.assign( this->GetNumberOfThreads(), NoiseResidualHistogram(bins) );
+    m_ThreadOutliers.assign( this->GetNumberOfThreads(), NoiseResidualHistogram(bins) );
+    }
+
+  void ThreadedGenerateData(const RegionType & outputRegionForThread,
+                            ThreadIdType threadId)
+    {
+    const SizeValueType size0 = outputRegionForThread.GetSize(0);
+    if ( size0 == 0 )
+      {
+      return;
+      }
+
+    ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() / size0 );
+
+    const InputImageType *input = this->GetInput();
+    const RegionType largest = input->GetLargestPossibleRegion();
+    const IndexType & start = largest.GetIndex();
+    const SizeType & size = largest.GetSize();
+
+    // Pixels of the line with a residual, and the ones the residuals read.
+    const IndexValueType margin = m_UseFirstAxis ? 1 : 0;
+    const IndexValueType xBegin = std::max( outputRegionForThread.GetIndex(0), start[0] + margin );
+    const IndexValueType xEnd = std::min( outputRegionForThread.GetIndex(0) + static_cast< IndexValueType >( size0 ),
+                                          start[0] + static_cast< IndexValueType >( size[0] ) - margin );
+
+    const InputImagePixelType minimum = NumericTraits< InputImagePixelType >::NonpositiveMin();
+    const InputImagePixelType maximum = NumericTraits< InputImagePixelType >::max();
+
+    NoiseResidualHistogram & residuals = m_ThreadResiduals[threadId];
+    NoiseResidualHistogram & outliers = m_ThreadOutliers[threadId];
+
+    std::vector< double > combined( xEnd > xBegin ? xEnd - xBegin + 2 * margin : 0 );
+
+    ImageLinearConstIteratorWithIndex< InputImageType > it(input, outputRegionForThread);
+    it.SetDirection(0);
+
+    for ( it.GoToBegin(); !it.IsAtEnd(); it.NextLine() )
+      {
+      IndexType index = it.GetIndex();
+
+      bool interior = xEnd > xBegin;
+      for ( unsigned int d = 1; d < ImageDimension && interior; ++d )
+        {
+        interior = size[d] < 3
+          || ( index[d] > start[d] && index[d] < start[d] + static_cast< IndexValueType >( size[d] ) - 1 );
+        }
+
+      if ( interior )
+        {
+        index[0] = xBegin - margin;
+        const InputImagePixelType *in = input->GetBufferPointer() + input->ComputeOffset(index);
+
+        // Second differences along the other axes, summed over the
+        // neighbour lines.
+        for ( size_t x = 0; x < combined.size(); ++x )
+          {
+          const InputImagePixelType *pixel = in + x;
+          double sum = 0.0;
+          for ( size_t n = 0; n < m_NeighbourOffsets.size(); ++n )
+            {
+            sum += m_NeighbourWeights[n] * static_cast< double >( pixel[m_NeighbourOffsets[n]] );
+            }
+          combined[x] = sum;
+          }
+
+        for ( size_t x = margin; x < combined.size() - margin; ++x )
+          {
+          const double residual = m_UseFirstAxis
+            ? combined[x - 1] - 2.0 * combined[x] + combined[x + 1]
+            : combined[x];
+          const double magnitude = std::fabs(residual);
+
+          residuals.Add(magnitude);
+          if ( in[x] == minimum || in[x] == maximum )
+            {
+            outliers.Add(magnitude);
+            }
+          }
+        }
+
+      progress.CompletedPixel();
+      }
+    }
+
+  /** Merge the histograms of the threads and compute the estimates. */
+  void AfterThreadedGenerateData()
+    {
+    NoiseResidualHistogram residuals = m_ThreadResiduals[0];
+    NoiseResidualHistogram outliers = m_ThreadOutliers[0];
+    for ( size_t i = 1; i < m_ThreadResiduals.size(); ++i )
+      {
+      residuals.Merge(m_ThreadResiduals[i]);
+      outliers.Merge(m_ThreadOutliers[i]);
+      }
+    m_ThreadResiduals.clear();
+    m_ThreadOutliers.clear();
+
+    m_Pixels = residuals.GetCount();
+    if ( m_Pixels == 0 )
+      {
+      m_StandardDeviation = 0.0;
+      m_ImpulseProbability = 0.0;
+      return;
+      }
+
+    const double residualSigma = 1.4826 * residuals.Quantile(0.5);
+
+    m_StandardDeviation = residualSigma / std::sqrt( std::pow( 6.0, static_cast< double >( m_ResidualAxes ) ) );
+    m_ImpulseProbability = static_cast< double >( outliers.CountAbove(m_OutlierThreshold * residualSigma) )
+      / static_cast< double >( m_Pixels );
+    }
+
+private:
+  NoiseLevelEstimationImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+
+  double        m_OutlierThreshold;
+  double        m_StandardDeviation;
+  double        m_ImpulseProbability;
+  SizeValueType m_Pixels;
+
+  /** Whether the first axis has a second difference, and the number of
+   * axes with one. */
+  bool         m_UseFirstAxis;
+  unsigned int m_ResidualAxes;
+
+  /** Buffer offsets and weights of the 3^(k-1) neighbour lines. */
+  std::vector< OffsetValueType > m_NeighbourOffsets;
+  std::vector< double >          m_NeighbourWeights;
+
+  /** Absolute residuals of all the pixels and of the pixels at a bound of
+   * the pixel type, per thread. */
+  std::vector< NoiseResidualHistogram > m_ThreadResiduals;
+  std::vector< NoiseResidualHistogram > m_ThreadOutliers;
+};
+
+} // End namespace itk
+
+#endif /* __itkNoiseLevelEstimationImageFilter */
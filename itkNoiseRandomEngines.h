@@ -0,0 +1,462 @@
+#ifndef __itkNoiseRandomEngines
+#define __itkNoiseRandomEngines
+
+#include <stdint.h>
+#include <cmath>
+#include <cstddef>
+#include <random>
+
+namespace itk
+{
+/** Mixing function of splitmix64, used to derive engine states from a
+ * seed and a stream identifier. */
+inline uint64_t SplitMix64(uint64_t & state)
+{
+  uint64_t z = ( state += 0x9E3779B97F4A7C15ULL );
+  z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+  z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+  return z ^ ( z >> 31 );
+}
+
+/** \class Xoshiro256PlusPlusEngine
+ * \brief xoshiro256++ pseudo-random generator (Blackman & Vigna).
+ * Produces 64 random bits per call. Independent streams are obtained by
+ * seeding with the same seed and different stream identifiers.
+ *
+ * All the engines of this file share this interface, and can be used as
+ * the engine policy of the noise filters. This one is the fastest and the
+ * default.
+ */
+class Xoshiro256PlusPlusEngine
+{
+public:
+  typedef uint64_t ResultType;
+
+  Xoshiro256PlusPlusEngine()
+    { this->Seed(0, 0); }
+
+  void Seed(const uint64_t seed, const uint64_t stream)
+    {
+    uint64_t sm = seed ^ ( stream * 0xD1B54A32D192ED03ULL );
+    for ( unsigned int i = 0; i < 4; ++i )
+      {
+      m_State[i] = SplitMix64(sm);
+      }
+    }
+
+  inline ResultType operator()()
+    {
+    const uint64_t result = Rotl( m_State[0] + m_State[3], 23 ) + m_State[0];
+    const uint64_t t = m_State[1] << 17;
+
+    m_State[2] ^= m_State[0];
+    m_State[3] ^= m_State[1];
+    m_State[1] ^= m_State[2];
+    m_State[0] ^= m_State[3];
+    m_State[2] ^= t;
+    m_State[3] = Rotl( m_State[3], 45 );
+
+    return result;
+    }
+
+  /** Fill a buffer with random words. */
+  inline void Fill(uint64_t *words, const size_t count)
+    {
+    for ( size_t i = 0; i < count; ++i )
+      {
+      words[i] = ( *this )();
+      }
+    }
+
+private:
+  static inline uint64_t Rotl(const uint64_t x, const int k)
+    { return ( x << k ) | ( x >> ( 64 - k ) ); }
+
+  uint64_t m_State[4];
+};
+
+/** \class Pcg64Engine
+ * \brief PCG64 (XSL RR 128/64) pseudo-random generator (O'Neill).
+ * The stream identifier selects the increment of the LCG.
+ */
+class Pcg64Engine
+{
+public:
+  typedef uint64_t ResultType;
+
+  Pcg64Engine()
+    { this->Seed(0, 0); }
+
+  void Seed(const uint64_t seed, const uint64_t stream)
+    {
+    uint64_t sm = stream;
+    m_Increment = ( ( static_cast< UInt128 >( SplitMix64(sm) ) << 64 ) | SplitMix64(sm) ) << 1 | 1u;
+
+    sm = seed;
+    m_State = 0;
+    this->Step();
+    m_State += ( static_cast< UInt128 >( SplitMix64(sm) ) << 64 ) | SplitMix64(sm);
+    this->Step();
+    }
+
+  inline ResultType operator()()
+    {
+    this->Step();
+
+    const uint64_t xsl = static_cast< uint64_t >( m_State >> 64 ) ^ static_cast< uint64_t >( m_State );
+    const unsigned int rot = static_cast< unsigned int >( m_State >> 122 );
+
+    return ( xsl >> rot ) | ( xsl << ( ( 64 - rot ) & 63 ) );
+    }
+
+  inline void Fill(uint64_t *words, const size_t count)
+    {
+    for ( size_t i = 0; i < count; ++i )
+      {
+      words[i] = ( *this )();
+      }
+    }
+
+private:
+  __extension__ typedef unsigned __int128 UInt128;
+
+  inline void Step()
+    {
+    const UInt128 multiplier = ( static_cast< UInt128 >( 2549297995355413924ULL ) << 64 ) | 4865540595714422341ULL;
+    m_State = m_State * multiplier + m_Increment;
+    }
+
+  UInt128 m_State;
+  UInt128 m_Increment;
+};
+
+/** \class Philox4x32Engine
+ * \brief Philox4x32-10 counter-based generator (Salmon et al.).
+ * The seed is the key, the stream identifier the high half of the
+ * counter. Each block of the counter gives two 64 bit results.
+ */
+class Philox4x32Engine
+{
+public:
+  typedef uint64_t ResultType;
+
+  Philox4x32Engine()
+    { this->Seed(0, 0); }
+
+  void Seed(const uint64_t seed, const uint64_t stream)
+    {
+    m_Key[0] = static_cast< uint32_t >( seed );
+    m_Key[1] = static_cast< uint32_t >( seed >> 32 );
+    m_Counter[0] = 0;
+    m_Counter[1] = 0;
+    m_Counter[2] = static_cast< uint32_t >( stream );
+    m_Counter[3] = static_cast< uint32_t >( stream >> 32 );
+    m_Index = 2;
+    }
+
+  inline ResultType operator()()
+    {
+    if ( m_Index == 2 )
+      {
+      this->GenerateBlock();
+      m_Index = 0;
+      }
+
+    return m_Results[m_Index++];
+    }
+
+  inline void Fill(uint64_t *words, const size_t count)
+    {
+    for ( size_t i = 0; i < count; ++i )
+      {
+      words[i] = ( *this )();
+      }
+    }
+
+private:
+  void GenerateBlock()
+    {
+    uint32_t c[4] = { m_Counter[0], m_Counter[1], m_Counter[2], m_Counter[3] };
+    uint32_t k[2] = { m_Key[0], m_Key[1] };
+
+    for ( unsigned int round = 0; round < 10; ++round )
+      {
+      const uint64_t p0 = static_cast< uint64_t >( 0xD2511F53u ) * c[0];
+      const uint64_t p1 = static_cast< uint64_t >( 0xCD9E8D57u ) * c[2];
+
+      const uint32_t c0 = static_cast< uint32_t >( p1 >> 32 ) ^ c[1] ^ k[0];
+      const uint32_t c1 = static_cast< uint32_t >( p1 );
+      const uint32_t c2 = static_cast< uint32_t >( p0 >> 32 ) ^ c[3] ^ k[1];
+      const uint32_t c3 = static_cast< uint32_t >( p0 );
+
+      c[0] = c0; c[1] = c1; c[2] = c2; c[3] = c3;
+
+      k[0] += 0x9E3779B9u;
+      k[1] += 0xBB67AE85u;
+      }
+
+    m_Results[0] = c[0] | ( static_cast< uint64_t >( c[1] ) << 32 );
+    m_Results[1] = c[2] | ( static_cast< uint64_t >( c[3] ) << 32 );
+
+    if ( ++m_Counter[0] == 0 )
+      {
+      ++m_Counter[1];
+      }
+    }
+
+  uint32_t     m_Key[2];
+  uint32_t     m_Counter[4];
+  uint64_t     m_Results[2];
+  unsigned int m_Index;
+};
+
+/** \class Mt19937_64Engine
+ * \brief 64 bit Mersenne Twister of the standard library.
+ * Seeding is expensive (the whole 312 words state is initialized), which
+ * makes it the slowest of the engines with short runs.
+ */
+class Mt19937_64Engine
+{
+public:
+  typedef uint64_t ResultType;
+
+  Mt19937_64Engine()
+    { this->Seed(0, 0); }
+
+  void Seed(const uint64_t seed, const uint64_t stream)
+    {
+    std::seed_seq sequence = { static_cast< uint32_t >( seed ), static_cast< uint32_t >( seed >> 32 ),
+                               static_cast< uint32_t >( stream ), static_cast< uint32_t >( stream >> 32 ) };
+    m_Generator.seed(sequence);
+    }
+
+  inline ResultType operator()()
+    { return m_Generator(); }
+
+  inline void Fill(uint64_t *words, const size_t count)
+    {
+    for ( size_t i = 0; i < count; ++i )
+      {
+      words[i] = m_Generator();
+      }
+    }
+
+private:
+  std::mt19937_64 m_Generator;
+};
+
+/** Seed an engine with the stream of the pixels starting at the given
+ * index, so that the noise of a pixel does not depend on the way the image
+ * is split between the threads or streamed. */
+template< class TEngine, class TIndex >
+inline void SeedIndexStream(TEngine & engine, const uint64_t seed, const TIndex & index)
+{
+  uint64_t stream = 0;
+  for ( unsigned int d = 0; d < TIndex::GetIndexDimension(); ++d )
+    {
+    stream ^= static_cast< uint64_t >( index[d] );
+    stream = SplitMix64(stream);
+    }
+  engine.Seed(seed, stream);
+}
+
+/** Conversion of 64 random bits to a uniform variate in [0; 1[, with as
+ * many random bits as the mantissa of TRealType. */
+template< class TRealType >
+struct UniformBits;
+
+template<>
+struct UniformBits< double >
+{
+  static inline double Convert(const uint64_t bits)
+    { return ( bits >> 11 ) * ( 1.0 / 9007199254740992.0 ); }
+};
+
+template<>
+struct UniformBits< float >
+{
+  static inline float Convert(const uint64_t bits)
+    { return ( bits >> 40 ) * ( 1.0f / 16777216.0f ); }
+};
+
+/** Uniform variate in [0; 1[. */
+template< class TRealType = double, class TEngine >
+inline TRealType UniformVariate(TEngine & engine)
+{
+  return UniformBits< TRealType >::Convert( engine() );
+}
+
+/** Two independent standard normal variates (Marsaglia's polar method). */
+template< class TRealType, class TEngine >
+inline void NormalVariatePair(TEngine & engine, TRealType & z0, TRealType & z1)
+{
+  TRealType u, v, s;
+  do
+    {
+    u = 2 * UniformVariate< TRealType >(engine) - 1;
+    v = 2 * UniformVariate< TRealType >(engine) - 1;
+    s = u * u + v * v;
+    }
+  while ( s >= 1 || s == 0 );
+
+  const TRealType f = std::sqrt( -2 * std::log(s) / s );
+  z0 = u * f;
+  z1 = v * f;
+}
+
+/** Standard normal variate. */
+template< class TRealType = double, class TEngine >
+inline TRealType NormalVariate(TEngine & engine)
+{
+  TRealType z0, z1;
+  NormalVariatePair(engine, z0, z1);
+  return z0;
+}
+
+/** Constants of the Marsaglia-Tsang gamma sampler for a given shape.
+ * Shapes below 1 are sampled from shape + 1 and boosted by u^(1/shape). */
+struct GammaParameters
+{
+  GammaParameters() {}
+
+  explicit GammaParameters(const double shape)
+    {
+    m_Shape = shape;
+    m_D = ( shape < 1.0 ? shape + 1.0 : shape ) - 1.0 / 3.0;
+    m_C = 1.0 / std::sqrt(9.0 * m_D);
+    m_InverseShape = 1.0 / shape;
+    }
+
+  double m_Shape;
+  double m_D;
+  double m_C;
+  double m_InverseShape;
+};
+
+/** One trial of the Marsaglia-Tsang sampler, from a standard normal
+ * variate z and a uniform variate u. On acceptance, x is a gamma variate
+ * of shape m_D + 1/3 and scale 1, not boosted. */
+template< class TRealType >
+inline bool GammaTrial(const GammaParameters & parameters, const TRealType z, const TRealType u, TRealType & x)
+{
+  TRealType v = 1 + static_cast< TRealType >( parameters.m_C ) * z;
+  if ( v <= 0 )
+    {
+    return false;
+    }
+  v = v * v * v;
+  x = static_cast< TRealType >( parameters.m_D ) * v;
+
+  const TRealType z2 = z * z;
+  // The squeeze accepts most trials without a logarithm.
+  return u < 1 - TRealType(0.0331) * z2 * z2
+    || std::log(u) < TRealType(0.5) * z2 + static_cast< TRealType >( parameters.m_D ) * ( 1 - v + std::log(v) );
+}
+
+/** Gamma variate of scale 1 (Marsaglia & Tsang). */
+template< class TRealType = double, class TEngine >
+inline TRealType GammaVariate(TEngine & engine, const GammaParameters & parameters)
+{
+  TRealType x;
+  while ( true )
+    {
+    TRealType z0, z1;
+    NormalVariatePair(engine, z0, z1);
+    if ( GammaTrial(parameters, z0, UniformVariate< TRealType >(engine), x)
+         || GammaTrial(parameters, z1, UniformVariate< TRealType >(engine), x) )
+      {
+      break;
+      }
+    }
+
+  if ( parameters.m_Shape < 1.0 )
+    {
+    x *= std::pow( UniformVariate< TRealType >(engine), static_cast< TRealType >( parameters.m_InverseShape ) );
+    }
+  return x;
+}
+
+/** Constants of the PTRS Poisson sampler for a given mean. */
+struct PoissonPtrsParameters
+{
+  PoissonPtrsParameters() {}
+
+  explicit PoissonPtrsParameters(const double lambda)
+    {
+    m_Lambda = lambda;
+    m_LogLambda = std::log(lambda);
+    m_B = 0.931 + 2.53 * std::sqrt(lambda);
+    m_A = -0.059 + 0.02483 * m_B;
+    m_LogInverseAlpha = std::log( 1.1239 + 1.1328 / ( m_B - 3.4 ) );
+    m_VR = 0.9277 - 3.6224 / ( m_B - 2.0 );
+    }
+
+  double m_Lambda;
+  double m_LogLambda;
+  double m_A;
+  double m_B;
+  double m_LogInverseAlpha;
+  double m_VR;
+};
+
+/** Poisson variate by transformed rejection with squeeze (Hormann's PTRS).
+ * Only valid for means of at least 10. */
+template< class TEngine >
+inline double PoissonPtrsVariate(TEngine & engine, const PoissonPtrsParameters & parameters)
+{
+  while ( true )
+    {
+    const double u = UniformVariate(engine) - 0.5;
+    const double v = UniformVariate(engine);
+    const double us = 0.5 - std::fabs(u);
+    const double k = std::floor( ( 2.0 * parameters.m_A / us + parameters.m_B ) * u + parameters.m_Lambda + 0.43 );
+
+    if ( us >= 0.07 && v <= parameters.m_VR )
+      {
+      return k;
+      }
+
+    if ( k < 0.0 || ( us < 0.013 && v > us ) )
+      {
+      continue;
+      }
+
+    if ( std::log(v) + parameters.m_LogInverseAlpha - std::log( parameters.m_A / ( us * us ) + parameters.m_B )
+         <= -parameters.m_Lambda + k * parameters.m_LogLambda - std::lgamma(k + 1.0) )
+      {
+      return k;
+      }
+    }
+}
+
+/** Poisson variate: sequential inversion below a mean of 10, PTRS above. */
+template< class TEngine >
+inline double PoissonVariate(TEngine & engine, const double lambda)
+{
+  if ( lambda <= 0.0 )
+    {
+    return 0.0;
+    }
+
+  if ( lambda >= 10.0 )
+    {
+    return PoissonPtrsVariate( engine, PoissonPtrsParameters(lambda) );
+    }
+
+  const double u = UniformVariate(engine);
+
+  double k = 0.0;
+  double p = std::exp(-lambda);
+  double cdf = p;
+  while ( u > cdf && p > 0.0 )
+    {
+    k += 1.0;
+    p *= lambda / k;
+    cdf += p;
+    }
+  return k;
+}
+
+} // End namespace itk
+
+#endif /* __itkNoiseRandomEngines */
@@ -0,0 +1,51 @@
+#ifndef __itkNoiseStatistics
+#define __itkNoiseStatistics
+
+#include <itkIntTypes.h>
+
+namespace itk
+{
+/** Sums comparing the output of a noise filter to its input, over the
+ * pixels of the output requested region. */
+struct NoiseStatistics
+{
+  NoiseStatistics()
+    {
+    m_Pixels = 0;
+    m_SquaredError = 0.0;
+    m_SignalEnergy = 0.0;
+    m_AtMinimum = 0;
+    m_AtMaximum = 0;
+    m_Corrupted = 0;
+    }
+
+  NoiseStatistics & operator+=(const NoiseStatistics & other)
+    {
+    m_Pixels += other.m_Pixels;
+    m_SquaredError += other.m_SquaredError;
+    m_SignalEnergy += other.m_SignalEnergy;
+    m_AtMinimum += other.m_AtMinimum;
+    m_AtMaximum += other.m_AtMaximum;
+    m_Corrupted += other.m_Corrupted;
+    return *this;
+    }
+
+  /** Number of pixels compared. */
+  SizeValueType m_Pixels;
+  /** Sum of the squared differences between the output and the input. */
+  double m_SquaredError;
+  /** Sum of the squared input values. */
+  double m_SignalEnergy;
+  /** Number of noisy values below the output minimum and above the output
+   * maximum of the functor before clamping, i.e. saturated. */
+  SizeValueType m_AtMinimum;
+  SizeValueType m_AtMaximum;
+  /** Number of pixels the noise was applied to: the pixels selected by the
+   * sparse noises, whether or not their value changed, and all the noised
+   * pixels for the others. */
+  SizeValueType m_Corrupted;
+};
+
+} // End namespace itk
+
+#endif /* __itkNoiseStatistics */
@@ -0,0 +1,359 @@
+#ifndef __itkPoissonNoiseImageFilter
+#define __itkPoissonNoiseImageFilter
+
+#include "itkNoiseImageFilter.h"
+#include <itkConceptChecking.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace itk
+{
+/** \class PoissonIntensitySampler
+ * \brief Draws Poisson counts whose mean is an intensity times a scale.
+ *
+ * For integer intensity types of at most 16 bits, Initialize() precomputes
+ * the sampling of every intensity: a cumulative distribution table searched
+ * from the mode for small means, the PTRS constants for larger ones.
+ * Other intensity types compute the sampler for each pixel.
+ */
+template< class TInput >
+class PoissonIntensitySampler
+{
+public:
+  /** Means from which PTRS is used instead of a table. */
+  static const unsigned int TableMaximumLambda = 64;
+
+  PoissonIntensitySampler()
+    {
+    m_Scale = 1.0;
+    }
+
+  double GetScale() const
+    { return m_Scale; }
+
+  /** Set the scale. The tables must be computed again with Initialize(). */
+  void SetScale(const double scale)
+    {
+    m_Scale = scale;
+    this->Clear();
+    }
+
+  /** Precompute the samplers of the intensities, when the intensity type is
+   * small enough. */
+  void Initialize()
+    {
+    this->Clear();
+
+    if ( !std::numeric_limits< TInput >::is_integer || sizeof( TInput ) > 2 )
+      {
+      return;
+      }
+
+    const long min = static_cast< long >( std::numeric_limits< TInput >::min() );
+    const long max = static_cast< long >( std::numeric_limits< TInput >::max() );
+
+    m_Entries.resize(max - min + 1);
+    for ( long intensity = min; intensity <= max; ++intensity )
+      {
+      TableEntry & entry = m_Entries[intensity - min];
+      const double lambda = intensity * m_Scale;
+
+      if ( lambda >= TableMaximumLambda )
+        {
+        entry.m_Offset = m_Ptrs.size();
+        entry.m_Size = 0;
+        m_Ptrs.push_back( PoissonPtrsParameters(lambda) );
+        continue;
+        }
+
+      entry.m_Offset = m_Cdf.size();
+      entry.m_Mode = lambda > 0.0 ? static_cast< unsigned int >( lambda ) : 0;
+
+      double p = std::exp( -std::max(lambda, 0.0) );
+      double cdf = p;
+      m_Cdf.push_back(cdf);
+      for ( double k = 1.0; lambda > 0.0 && 1.0 - cdf > 1e-12 && p > 0.0; k += 1.0 )
+        {
+        p *= lambda / k;
+        cdf += p;
+        m_Cdf.push_back(cdf);
+        }
+      // The search must stop on the last entry.
+      m_Cdf.back() = 1.0;
+
+      entry.m_Size = static_cast< unsigned int >( m_Cdf.size() - entry.m_Offset );
+      }
+    }
+
+  /** Poisson count of mean A * scale. */
+  template< class TEngine >
+  inline double Sample(const TInput & A, TEngine & engine) const
+    {
+    if ( m_Entries.empty() )
+      {
+      return PoissonVariate(engine, A * m_Scale);
+      }
+
+    const TableEntry & entry = m_Entries[static_cast< long >( A ) - static_cast< long >( std::numeric_limits< TInput >::min() )];
+    if ( entry.m_Size == 0 )
+      {
+      return PoissonPtrsVariate(engine, m_Ptrs[entry.m_Offset]);
+      }
+
+    return SearchTable(entry, UniformVariate(engine));
+    }
+
+private:
+  struct TableEntry
+  {
+    size_t       m_Offset;
+    unsigned int m_Size;
+    unsigned int m_Mode;
+  };
+
+  void Clear()
+    {
+    m_Entries.clear();
+    m_Cdf.clear();
+    m_Ptrs.clear();
+    }
+
+  /** Smallest k such that u <= cdf[k], searched from the mode. */
+  inline double SearchTable(const TableEntry & entry, const double u) const
+    {
+    const double *cdf = &m_Cdf[entry.m_Offset];
+
+    unsigned int k = std::min(entry.m_Mode, entry.m_Size - 1);
+    if ( u > cdf[k] )
+      {
+      do { ++k; } while ( u > cdf[k] );
+      }
+    else
+      {
+      while ( k > 0 && u <= cdf[k - 1] ) { --k; }
+      }
+    return k;
+    }
+
+  double m_Scale;
+
+  std::vector< TableEntry >            m_Entries;
+  std::vector< double >                m_Cdf;
+  std::vector< PoissonPtrsParameters > m_Ptrs;
+};
+
+namespace Functor
+{
+/** \class PoissonNoise
+ * \brief Replaces a pixel by a Poisson (shot noise) realization.
+ * The pixel value times the scale is the mean photon count, the output is
+ * the drawn photon count divided by the scale.
+ *
+ * The counts are drawn by a PoissonIntensitySampler, whose tables are
+ * computed by Initialize().
+ * \ingroup ITKImageIntensity
+ */
+template< class TInput, class TOutput, class TRealType = double >
+class PoissonNoise
+{
+public:
+  typedef TRealType RealType;
+
+  PoissonNoise()
+    {
+    m_OutputMinimum = itk::NumericTraits< TOutput >::NonpositiveMin();
+    m_OutputMaximum = itk::NumericTraits< TOutput >::max();
+    }
+
+  ~PoissonNoise() {}
+
+  double GetScale() const
+    { return m_Sampler.GetScale(); }
+
+  void SetScale(const double scale)
+    {
+    if(scale <= 0.0)
+      itkGenericExceptionMacro("scale must be strictly positive");
+
+    m_Sampler.SetScale(scale);
+    }
+
+  TOutput GetOutputMinimum() const
+    { return m_OutputMinimum; }
+
+  TOutput GetOutputMaximum() const
+    { return m_OutputMaximum; }
+
+  void SetOutputBounds( const TOutput min, const TOutput max)
+    {
+    if(max <= min)
+      itkGenericExceptionMacro("invalid bounds: [" << min << "; " << max << "]");
+
+    m_OutputMinimum = min;
+    m_OutputMaximum = max;
+    }
+
+  bool operator!=(const PoissonNoise &other) const
+    {
+    return GetScale() != other.GetScale()
+      || m_OutputMaximum != other.m_OutputMaximum
+      || m_OutputMinimum != other.m_OutputMinimum;
+    }
+
+  bool operator==(const PoissonNoise & other) const
+    {
+    return !( *this != other );
+    }
+
+  /** Precompute the samplers of the intensities. Must be called after the
+   * parameters are set. */
+  void Initialize()
+    { m_Sampler.Initialize(); }
+
+  /** Flags of the variant of Evaluate() matching the parameters. */
+  unsigned int GetVariant() const
+    {
+    unsigned int variant = 0;
+    if ( !NoiseClampIsNeeded< TOutput, RealType >(m_OutputMinimum, m_OutputMaximum) )
+      {
+      variant |= NoiseVariantNoClamp;
+      }
+    return variant;
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine) const
+    {
+    float noise;
+    return Evaluate< VVariant >(A, engine, noise);
+    }
+
+  /** Noisy value of a pixel, and the difference between the scaled count
+   * and A, before clamping. */
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine, float & noise) const
+    {
+    const double count = m_Sampler.Sample(A, engine);
+    const RealType v = static_cast< RealType >( count / m_Sampler.GetScale() );
+    noise = static_cast< float >( v - static_cast< RealType >( A ) );
+    return NoiseClamp< VVariant >(v, m_OutputMinimum, m_OutputMaximum);
+    }
+
+  template< class TEngine >
+  inline TOutput operator()(const TInput & A, TEngine & engine) const
+    {
+    return Evaluate< 0 >(A, engine);
+    }
+
+private:
+  TOutput m_OutputMinimum;
+  TOutput m_OutputMaximum;
+
+  PoissonIntensitySampler< TInput > m_Sampler;
+};
+} // End namespace Functor
+
+template< class TInputImage, class TOutputImage, class TEngine = Xoshiro256PlusPlusEngine,
+          class TRealType = double >
+class ITK_EXPORT PoissonNoiseImageFilter:
+  public
+  NoiseImageFilter< TInputImage, TOutputImage,
+                    Functor::PoissonNoise<
+                      typename TInputImage::PixelType,
+                      typename TOutputImage::PixelType,
+                      TRealType >,
+                    TEngine >
+{
+public:
+  /** Standard class typedefs. */
+  typedef PoissonNoiseImageFilter Self;
+  typedef NoiseImageFilter<
+    TInputImage, TOutputImage,
+    Functor::PoissonNoise< typename TInputImage::PixelType,
+                           typename TOutputImage::PixelType,
+                           TRealType >,
+    TEngine >  Superclass;
+
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  typedef typename TOutputImage::PixelType OutputPixelType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Macro that provides the GetNameOfClass() method */
+  itkTypeMacro(PoissonNoiseImageFilter, NoiseImageFilter);
+
+  OutputPixelType GetOutputMinimum() const
+    {
+    return this->GetFunctor().GetOutputMinimum();
+    }
+
+  OutputPixelType GetOutputMaximum() const
+    {
+    return this->GetFunctor().GetOutputMaximum();
+    }
+
+  double GetScale() const
+    { return this->GetFunctor().GetScale(); }
+
+  void SetOutputBounds(const OutputPixelType min, const OutputPixelType max)
+    {
+    if ( min == this->GetFunctor().GetOutputMinimum() && max == this->GetFunctor().GetOutputMaximum())
+      {
+      return;
+      }
+
+    this->GetFunctor().SetOutputBounds(min, max);
+    this->Modified();
+    }
+
+  /** Photon count corresponding to an intensity of 1. */
+  void SetScale(const double scale)
+    {
+    if ( scale == this->GetFunctor().GetScale() )
+      {
+      return;
+      }
+
+    this->GetFunctor().SetScale(scale);
+    this->Modified();
+    }
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+    {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "Scale: " << static_cast<typename NumericTraits<double>::PrintType>(GetScale()) << std::endl;
+    os << indent << "OutputMinimum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMinimum()) << std::endl;
+    os << indent << "OutputMaximum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMaximum()) << std::endl;
+    }
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  itkConceptMacro( InputConvertibleToDoubleCheck,
+    ( Concept::Convertible< typename TInputImage::PixelType, double > ) );
+  itkConceptMacro( DoubleConvertibleToOutputCheck,
+    ( Concept::Convertible< double, OutputPixelType > ) );
+#endif
+
+protected:
+  PoissonNoiseImageFilter() {}
+  virtual ~PoissonNoiseImageFilter() {}
+
+  /** Precompute the samplers before the threads start. */
+  void BeforeThreadedGenerateData()
+    {
+    this->GetFunctor().Initialize();
+    Superclass::BeforeThreadedGenerateData();
+    }
+
+private:
+  PoissonNoiseImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+};
+
+} // End namespace itk
+
+#endif /* __itkPoissonNoiseImageFilter */
@@ -0,0 +1,312 @@
+#ifndef __itkRicianNoiseImageFilter
+#define __itkRicianNoiseImageFilter
+
+#include "itkNoiseImageFilter.h"
+#include <itkConceptChecking.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+namespace Functor
+{
+/** \class RicianNoise
+ * \brief Adds Rician noise to a pixel.
+ * The pixel is taken as the magnitude of a complex signal whose real and
+ * imaginary parts receive independent gaussian noise:
+ * sqrt((A + n1)^2 + n2^2). Both noise values come from a single draw of
+ * the polar method.
+ * \ingroup ITKImageIntensity
+ */
+template< class TInput, class TOutput, class TRealType = double >
+class RicianNoise
+{
+public:
+  typedef TRealType RealType;
+
+  RicianNoise()
+    {
+    m_StandardDeviation = 1.0;
+    m_OutputMinimum = itk::NumericTraits< TOutput >::NonpositiveMin();
+    m_OutputMaximum = itk::NumericTraits< TOutput >::max();
+    }
+
+  ~RicianNoise() {}
+
+  double GetStandardDeviation() const
+    { return m_StandardDeviation; }
+
+  void SetStandardDeviation(const double standardDeviation)
+    {
+    if(standardDeviation <= 0.0)
+      itkGenericExceptionMacro("standard deviation must be strictly positive");
+
+    m_StandardDeviation = static_cast< RealType >( standardDeviation );
+    }
+
+  TOutput GetOutputMinimum() const
+    { return m_OutputMinimum; }
+
+  TOutput GetOutputMaximum() const
+    { return m_OutputMaximum; }
+
+  void SetOutputBounds( const TOutput min, const TOutput max)
+    {
+    if(max <= min)
+      itkGenericExceptionMacro("invalid bounds: [" << min << "; " << max << "]");
+
+    m_OutputMinimum = min;
+    m_OutputMaximum = max;
+    }
+
+  bool operator!=(const RicianNoise &other) const
+    {
+    return m_StandardDeviation != other.m_StandardDeviation
+      || m_OutputMaximum != other.m_OutputMaximum
+      || m_OutputMinimum != other.m_OutputMinimum;
+    }
+
+  bool operator==(const RicianNoise & other) const
+    {
+    return !( *this != other );
+    }
+
+  /** Flags of the variant of Evaluate() matching the parameters. */
+  unsigned int GetVariant() const
+    {
+    unsigned int variant = 0;
+    if ( !NoiseClampIsNeeded< TOutput, RealType >(m_OutputMinimum, m_OutputMaximum) )
+      {
+      variant |= NoiseVariantNoClamp;
+      }
+    return variant;
+    }
+
+  /** Noisy value of a pixel, given the standard normal variates of the
+   * real and imaginary parts. */
+  template< unsigned int VVariant >
+  inline TOutput Apply(const TInput & A, const RealType z0, const RealType z1) const
+    {
+    return NoiseClamp< VVariant >(this->Magnitude(A, z0, z1), m_OutputMinimum, m_OutputMaximum);
+    }
+
+  /** Noisy value of a pixel, and the difference between the magnitude and
+   * A, before clamping. */
+  template< unsigned int VVariant >
+  inline TOutput Apply(const TInput & A, const RealType z0, const RealType z1, float & noise) const
+    {
+    const RealType v = this->Magnitude(A, z0, z1);
+    noise = static_cast< float >( v - static_cast< RealType >( A ) );
+    return NoiseClamp< VVariant >(v, m_OutputMinimum, m_OutputMaximum);
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine) const
+    {
+    RealType z0, z1;
+    NormalVariatePair(engine, z0, z1);
+    return Apply< VVariant >(A, z0, z1);
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine, float & noise) const
+    {
+    RealType z0, z1;
+    NormalVariatePair(engine, z0, z1);
+    return Apply< VVariant >(A, z0, z1, noise);
+    }
+
+  template< class TEngine >
+  inline TOutput operator()(const TInput & A, TEngine & engine) const
+    {
+    return Evaluate< 0 >(A, engine);
+    }
+
+private:
+  /** Unclamped magnitude of the noisy complex signal. */
+  inline RealType Magnitude(const TInput & A, const RealType z0, const RealType z1) const
+    {
+    const RealType re = static_cast< RealType >( A ) + m_StandardDeviation * z0;
+    const RealType im = m_StandardDeviation * z1;
+    return std::sqrt(re * re + im * im);
+    }
+
+  TOutput m_OutputMinimum;
+  TOutput m_OutputMaximum;
+  RealType m_StandardDeviation;
+};
+} // End namespace Functor
+
+/** \class RicianNoiseImageFilter
+ * \brief Adds Rician noise to an image.
+ * The runs are processed by blocks: the gaussian noise of the real and
+ * imaginary parts is drawn first, one polar-method draw per pixel, and the
+ * magnitudes are computed in a loop without random draws.
+ * \ingroup ITKImageIntensity
+ */
+
+template< class TInputImage, class TOutputImage, class TEngine = Xoshiro256PlusPlusEngine,
+          class TRealType = double >
+class ITK_EXPORT RicianNoiseImageFilter:
+  public
+  NoiseImageFilter< TInputImage, TOutputImage,
+                    Functor::RicianNoise<
+                      typename TInputImage::PixelType,
+                      typename TOutputImage::PixelType,
+                      TRealType >,
+                    TEngine >
+{
+public:
+  /** Standard class typedefs. */
+  typedef RicianNoiseImageFilter Self;
+  typedef NoiseImageFilter<
+    TInputImage, TOutputImage,
+    Functor::RicianNoise< typename TInputImage::PixelType,
+                          typename TOutputImage::PixelType,
+                          TRealType >,
+    TEngine >  Superclass;
+
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  typedef typename Superclass::InputImagePixelType  InputImagePixelType;
+  typedef typename Superclass::OutputImagePixelType OutputImagePixelType;
+  typedef typename Superclass::IndexType            IndexType;
+  typedef typename Superclass::NoisePixelType       NoisePixelType;
+  typedef typename Superclass::EngineType           EngineType;
+  typedef typename TOutputImage::PixelType          OutputPixelType;
+  typedef TRealType                                 RealType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Macro that provides the GetNameOfClass() method */
+  itkTypeMacro(RicianNoiseImageFilter, NoiseImageFilter);
+
+  OutputPixelType GetOutputMinimum() const
+    {
+    return this->GetFunctor().GetOutputMinimum();
+    }
+
+  OutputPixelType GetOutputMaximum() const
+    {
+    return this->GetFunctor().GetOutputMaximum();
+    }
+
+  double GetStandardDeviation() const
+    { return this->GetFunctor().GetStandardDeviation(); }
+
+  void SetOutputBounds(const OutputPixelType min, const OutputPixelType max)
+    {
+    if ( min == this->GetFunctor().GetOutputMinimum() && max == this->GetFunctor().GetOutputMaximum())
+      {
+      return;
+      }
+
+    this->GetFunctor().SetOutputBounds(min, max);
+    this->Modified();
+    }
+
+  void SetStandardDeviation(const double standardDeviation)
+    {
+    if ( standardDeviation == this->GetFunctor().GetStandardDeviation() )
+      {
+      return;
+      }
+
+    this->GetFunctor().SetStandardDeviation(standardDeviation);
+    this->Modified();
+    }
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+    {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "StandardDeviation: " << static_cast<typename NumericTraits<double>::PrintType>(GetStandardDeviation()) << std::endl;
+    os << indent << "OutputMinimum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMinimum()) << std::endl;
+    os << indent << "OutputMaximum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMaximum()) << std::endl;
+    }
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  itkConceptMacro( InputConvertibleToDoubleCheck,
+    ( Concept::Convertible< typename TInputImage::PixelType, double > ) );
+  itkConceptMacro( DoubleConvertibleToOutputCheck,
+    ( Concept::Convertible< double, OutputPixelType > ) );
+#endif
+
+protected:
+  RicianNoiseImageFilter() {}
+  virtual ~RicianNoiseImageFilter() {}
+
+  void ProcessRun(const InputImagePixelType *in,
+                  OutputImagePixelType *out,
+                  NoisePixelType *noise,
+                  SizeValueType length,
+                  const IndexType & start) const
+    {
+    if ( this->GetFunctorVariant() & Functor::NoiseVariantNoClamp )
+      {
+      this->ProcessRunVariant< Functor::NoiseVariantNoClamp >(in, out, noise, length, start);
+      }
+    else if ( this->GetFunctorVariant() & Functor::NoiseVariantStatistics )
+      {
+      this->ProcessRunVariant< Functor::NoiseVariantStatistics >(in, out, noise, length, start);
+      }
+    else
+      {
+      this->ProcessRunVariant< 0 >(in, out, noise, length, start);
+      }
+    }
+
+private:
+  RicianNoiseImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+
+  template< unsigned int VVariant >
+  void ProcessRunVariant(const InputImagePixelType *in,
+                         OutputImagePixelType *out,
+                         NoisePixelType *noise,
+                         SizeValueType length,
+                         const IndexType & start) const
+    {
+    const typename Superclass::FunctorType & functor = this->GetFunctor();
+
+    EngineType engine;
+    this->SeedRunEngine(engine, start);
+
+    // Pixels whose random numbers are drawn at once. The variates are drawn
+    // in the order of Evaluate(), so the output is the same.
+    const SizeValueType blockSize = 64;
+
+    RealType z0[blockSize];
+    RealType z1[blockSize];
+
+    for ( SizeValueType offset = 0; offset < length; offset += blockSize )
+      {
+      const SizeValueType count = std::min(blockSize, length - offset);
+
+      for ( SizeValueType i = 0; i < count; ++i )
+        {
+        NormalVariatePair(engine, z0[i], z1[i]);
+        }
+
+      if ( noise )
+        {
+        for ( SizeValueType i = 0; i < count; ++i )
+          {
+          out[offset + i] = functor.template Apply< VVariant >(in[offset + i], z0[i], z1[i], noise[offset + i]);
+          }
+        continue;
+        }
+
+      for ( SizeValueType i = 0; i < count; ++i )
+        {
+        out[offset + i] = functor.template Apply< VVariant >(in[offset + i], z0[i], z1[i]);
+        }
+      }
+    }
+};
+
+} // End namespace itk
+
+#endif /* __itkRicianNoiseImageFilter */
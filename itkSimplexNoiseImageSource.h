@@ -0,0 +1,320 @@
+#ifndef __itkSimplexNoiseImageSource
+#define __itkSimplexNoiseImageSource
+
+#include <itkImageSource.h>
+#include <itkImageLinearConstIteratorWithIndex.h>
+#include <itkProgressReporter.h>
+
+#include "itkNoiseRandomEngines.h"
+#include "noise_kernels.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace itk
+{
+/** \class SimplexNoiseTexture
+ * \brief Fractal sum of octaves of 3D simplex noise.
+ * The first octave has Frequency cycles per physical unit, each next one
+ * Lacunarity times more, with Persistence times its amplitude. The sum is
+ * normalized by the sum of the amplitudes, so the texture is in [-1; 1].
+ * The octaves use different lattice hashes, derived from the seed.
+ *
+ * The rows are evaluated by NoiseKernels::simplex_row(), with the widest
+ * float registers of the CPU. The points are in the image axes (the
+ * direction of the image is ignored), and the value of a pixel only
+ * depends on its index, not on the row it is evaluated with.
+ */
+class SimplexNoiseTexture
+{
+public:
+  SimplexNoiseTexture()
+    {
+    m_Frequency = 0.05;
+    m_Octaves = 4;
+    m_Persistence = 0.5;
+    m_Lacunarity = 2.0;
+    m_Seed = 0;
+    }
+
+  double GetFrequency() const
+    { return m_Frequency; }
+
+  void SetFrequency(const double frequency)
+    {
+    if(frequency <= 0.0)
+      itkGenericExceptionMacro("frequency must be strictly positive");
+
+    m_Frequency = frequency;
+    }
+
+  unsigned int GetOctaves() const
+    { return m_Octaves; }
+
+  void SetOctaves(const unsigned int octaves)
+    {
+    if(octaves < 1)
+      itkGenericExceptionMacro("there must be at least one octave");
+
+    m_Octaves = octaves;
+    }
+
+  double GetPersistence() const
+    { return m_Persistence; }
+
+  void SetPersistence(const double persistence)
+    {
+    if(persistence <= 0.0)
+      itkGenericExceptionMacro("persistence must be strictly positive");
+
+    m_Persistence = persistence;
+    }
+
+  double GetLacunarity() const
+    { return m_Lacunarity; }
+
+  void SetLacunarity(const double lacunarity)
+    {
+    if(lacunarity <= 0.0)
+      itkGenericExceptionMacro("lacunarity must be strictly positive");
+
+    m_Lacunarity = lacunarity;
+    }
+
+  uint64_t GetSeed() const
+    { return m_Seed; }
+
+  void SetSeed(const uint64_t seed)
+    { m_Seed = seed; }
+
+  bool operator!=(const SimplexNoiseTexture &other) const
+    {
+    return m_Frequency != other.m_Frequency
+      || m_Octaves != other.m_Octaves
+      || m_Persistence != other.m_Persistence
+      || m_Lacunarity != other.m_Lacunarity
+      || m_Seed != other.m_Seed;
+    }
+
+  bool operator==(const SimplexNoiseTexture & other) const
+    {
+    return !( *this != other );
+    }
+
+  /** Texture at the points point + (first + i) * step along the first
+   * axis, for i in [0; length[. */
+  void EvaluateRow(float *out, const SizeValueType length, const SizeValueType first,
+                   const double point[3], const double step) const
+    {
+    std::fill(out, out + length, 0.0f);
+
+    double sum = 0.0;
+    double amplitude = 1.0;
+    for ( unsigned int o = 0; o < m_Octaves; ++o )
+      {
+      sum += amplitude;
+      amplitude *= m_Persistence;
+      }
+
+    uint64_t state = m_Seed;
+    double frequency = m_Frequency;
+    amplitude = 1.0 / sum;
+    for ( unsigned int o = 0; o < m_Octaves; ++o )
+      {
+      const uint32_t seed = static_cast< uint32_t >( SplitMix64(state) >> 32 );
+
+      NoiseKernels::simplex_row( out, length, first,
+                                 static_cast< float >( point[0] * frequency ),
+                                 static_cast< float >( step * frequency ),
+                                 static_cast< float >( point[1] * frequency ),
+                                 static_cast< float >( point[2] * frequency ),
+                                 static_cast< float >( amplitude ), seed );
+
+      frequency *= m_Lacunarity;
+      amplitude *= m_Persistence;
+      }
+    }
+
+private:
+  double       m_Frequency;
+  unsigned int m_Octaves;
+  double       m_Persistence;
+  double       m_Lacunarity;
+  uint64_t     m_Seed;
+};
+
+/** \class SimplexNoiseImageSource
+ * \brief Generates an image of fractal simplex noise (see
+ * SimplexNoiseTexture): Mean + Amplitude * texture, clamped to the range
+ * of the pixel type.
+ * The image is split between the threads along its last axis, in slabs of
+ * rows evaluated with the SIMD kernel.
+ * \ingroup ITKImageSources
+ */
+template< class TOutputImage >
+class ITK_EXPORT SimplexNoiseImageSource:
+  public ImageSource< TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef SimplexNoiseImageSource     Self;
+  typedef ImageSource< TOutputImage > Superclass;
+  typedef SmartPointer< Self >        Pointer;
+  typedef SmartPointer< const Self >  ConstPointer;
+
+  typedef TOutputImage                              OutputImageType;
+  typedef typename OutputImageType::PixelType       OutputImagePixelType;
+  typedef typename OutputImageType::RegionType      OutputImageRegionType;
+  typedef typename OutputImageType::IndexType       IndexType;
+  typedef typename OutputImageType::SizeType        SizeType;
+  typedef typename OutputImageType::SpacingType     SpacingType;
+  typedef typename OutputImageType::PointType       PointType;
+  typedef typename OutputImageType::DirectionType   DirectionType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int, TOutputImage::ImageDimension);
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Macro that provides the GetNameOfClass() method */
+  itkTypeMacro(SimplexNoiseImageSource, ImageSource);
+
+  /** Geometry of the generated image. */
+  itkSetMacro(Size, SizeType);
+  itkGetConstReferenceMacro(Size, SizeType);
+  itkSetMacro(Spacing, SpacingType);
+  itkGetConstReferenceMacro(Spacing, SpacingType);
+  itkSetMacro(Origin, PointType);
+  itkGetConstReferenceMacro(Origin, PointType);
+  itkSetMacro(Direction, DirectionType);
+  itkGetConstReferenceMacro(Direction, DirectionType);
+
+  itkSetMacro(Mean, double);
+  itkGetConstMacro(Mean, double);
+  itkSetMacro(Amplitude, double);
+  itkGetConstMacro(Amplitude, double);
+
+  const SimplexNoiseTexture & GetTexture() const
+    { return m_Texture; }
+
+  void SetTexture(const SimplexNoiseTexture & texture)
+    {
+    if ( m_Texture != texture )
+      {
+      m_Texture = texture;
+      this->Modified();
+      }
+    }
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+    {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "Size: " << m_Size << std::endl;
+    os << indent << "Spacing: " << m_Spacing << std::endl;
+    os << indent << "Origin: " << m_Origin << std::endl;
+    os << indent << "Direction: " << m_Direction << std::endl;
+    os << indent << "Mean: " << m_Mean << std::endl;
+    os << indent << "Amplitude: " << m_Amplitude << std::endl;
+    os << indent << "Frequency: " << m_Texture.GetFrequency() << std::endl;
+    os << indent << "Octaves: " << m_Texture.GetOctaves() << std::endl;
+    os << indent << "Persistence: " << m_Texture.GetPersistence() << std::endl;
+    os << indent << "Lacunarity: " << m_Texture.GetLacunarity() << std::endl;
+    os << indent << "Seed: " << m_Texture.GetSeed() << std::endl;
+    }
+
+protected:
+  SimplexNoiseImageSource()
+    {
+    m_Size.Fill(64);
+    m_Spacing.Fill(1.0);
+    m_Origin.Fill(0.0);
+    m_Direction.SetIdentity();
+    m_Mean = 0.0;
+    m_Amplitude = 1.0;
+    }
+
+  virtual ~SimplexNoiseImageSource() {}
+
+  void GenerateOutputInformation()
+    {
+    OutputImageType *output = this->GetOutput(0);
+
+    OutputImageRegionType largestPossibleRegion;
+    largestPossibleRegion.SetSize(m_Size);
+    output->SetLargestPossibleRegion(largestPossibleRegion);
+
+    output->SetSpacing(m_Spacing);
+    output->SetOrigin(m_Origin);
+    output->SetDirection(m_Direction);
+    }
+
+  void BeforeThreadedGenerateData()
+    {
+    if ( ImageDimension > 3 )
+      {
+      itkExceptionMacro("images of more than 3 dimensions are not supported");
+      }
+    }
+
+  void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                            ThreadIdType threadId)
+    {
+    const SizeValueType size0 = outputRegionForThread.GetSize(0);
+    if ( size0 == 0 )
+      {
+      return;
+      }
+
+    ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() / size0 );
+
+    OutputImageType *outputPtr = this->GetOutput(0);
+
+    const double minimum = static_cast< double >( NumericTraits< OutputImagePixelType >::NonpositiveMin() );
+    const double maximum = static_cast< double >( NumericTraits< OutputImagePixelType >::max() );
+
+    std::vector< float > row(size0);
+
+    ImageLinearConstIteratorWithIndex< OutputImageType > it(outputPtr, outputRegionForThread);
+    it.SetDirection(0);
+
+    for ( it.GoToBegin(); !it.IsAtEnd(); it.NextLine() )
+      {
+      const IndexType index = it.GetIndex();
+
+      double point[3] = { m_Origin[0], 0.0, 0.0 };
+      for ( unsigned int d = 1; d < ImageDimension && d < 3; ++d )
+        {
+        point[d] = m_Origin[d] + index[d] * m_Spacing[d];
+        }
+
+      m_Texture.EvaluateRow( &row[0], size0, static_cast< SizeValueType >( index[0] ), point, m_Spacing[0] );
+
+      OutputImagePixelType *out = outputPtr->GetBufferPointer() + outputPtr->ComputeOffset(index);
+      for ( SizeValueType x = 0; x < size0; ++x )
+        {
+        const double v = m_Mean + m_Amplitude * row[x];
+        out[x] = static_cast< OutputImagePixelType >( std::min( std::max(v, minimum), maximum ) );
+        }
+
+      progress.CompletedPixel();
+      }
+    }
+
+private:
+  SimplexNoiseImageSource(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+
+  SizeType      m_Size;
+  SpacingType   m_Spacing;
+  PointType     m_Origin;
+  DirectionType m_Direction;
+
+  double m_Mean;
+  double m_Amplitude;
+
+  SimplexNoiseTexture m_Texture;
+};
+
+} // End namespace itk
+
+#endif /* __itkSimplexNoiseImageSource */
@@ -1,9 +1,8 @@
 #ifndef __itkSparseAdditiveUniformNoiseImageFilter
 #define __itkSparseAdditiveUniformNoiseImageFilter
 
-#include <itkUnaryFunctorImageFilter.h>
+#include "itkSparseNoiseImageFilter.h"
 #include <itkConceptChecking.h>
-#include <vnl/vnl_sample.h>
 
 namespace itk
 {
@@ -14,10 +13,12 @@ namespace Functor
  * The probability to alter a pixel is user-defined.
  * \ingroup ITKImageIntensity
  */
-template< class TInput, class TOutput >
+template< class TInput, class TOutput, class TRealType = double >
 class SparseAdditiveUniformNoise
 {
 public:
+  typedef TRealType RealType;
+
   SparseAdditiveUniformNoise()
     {
     m_Probability = 1.0;
@@ -48,7 +49,7 @@ public:
 
   void SetMean(const double mean)
     {
-    m_Mean = mean;
+    m_Mean = static_cast< RealType >( mean );
     ComputeNoiseRange();
     }
 
@@ -57,7 +58,7 @@ public:
     if(amplitude < 0.0)
       itkGenericExceptionMacro("amplitude must be positive");
 
-    m_Amplitude = amplitude;
+    m_Amplitude = static_cast< RealType >( amplitude );
     ComputeNoiseRange();
     }
 
@@ -90,15 +91,50 @@ public:
     return !( *this != other );
     }
 
-  inline TOutput operator()(const TInput & A) const
+  /** Flags of the variant of Evaluate() and Corrupt() matching the parameters. */
+  unsigned int GetVariant() const
+    {
+    unsigned int variant = 0;
+    if ( !NoiseClampIsNeeded< TOutput, RealType >(m_OutputMinimum, m_OutputMaximum) )
+      {
+      variant |= NoiseVariantNoClamp;
+      }
+    return variant;
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine) const
+    {
+    float selected;
+    return Evaluate< VVariant >(A, engine, selected);
+    }
+
+  /** Noisy value of a pixel, and whether it was selected (1 or 0). */
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine, float & selected) const
     {
-    if(vnl_sample_uniform(0., 1.) <= m_Probability)
+    if(UniformVariate(engine) <= m_Probability)
       {
-      const double v = A + vnl_sample_uniform(m_NoiseMin, m_NoiseMax);
-      return static_cast<TOutput>(v < m_OutputMinimum ? m_OutputMinimum : (v > m_OutputMaximum ? m_OutputMaximum : v));
+      selected = 1.0f;
+      return Corrupt< VVariant >(A, engine);
       }
-    else
-      return static_cast<TOutput>(A);
+
+    selected = 0.0f;
+    return static_cast<TOutput>(A);
+    }
+
+  template< class TEngine >
+  inline TOutput operator()(const TInput & A, TEngine & engine) const
+    {
+    return Evaluate< 0 >(A, engine);
+    }
+
+  /** Noisy value of a selected pixel. */
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Corrupt(const TInput & A, TEngine & engine) const
+    {
+    const RealType v = static_cast< RealType >( A ) + ( m_NoiseMin + ( m_NoiseMax - m_NoiseMin ) * UniformVariate< RealType >(engine) );
+    return NoiseClamp< VVariant >(v, m_OutputMinimum, m_OutputMaximum);
     }
 
 private:
@@ -112,29 +148,34 @@ private:
   TOutput m_OutputMinimum;
   TOutput m_OutputMaximum;
   double m_Probability;
-  double m_Mean;
-  double m_Amplitude;
+  RealType m_Mean;
+  RealType m_Amplitude;
 
-  double m_NoiseMin;
-  double m_NoiseMax;
+  RealType m_NoiseMin;
+  RealType m_NoiseMax;
 };
 } // End namespace Functor
 
-template< class TInputImage, class TOutputImage >
+template< class TInputImage, class TOutputImage, class TEngine = Xoshiro256PlusPlusEngine,
+          class TRealType = double >
 class ITK_EXPORT SparseAdditiveUniformNoiseImageFilter:
   public
-  UnaryFunctorImageFilter< TInputImage, TOutputImage,
-                           Functor::SparseAdditiveUniformNoise<
-                             typename TInputImage::PixelType,
-                             typename TOutputImage::PixelType > >
+  SparseNoiseImageFilter< TInputImage, TOutputImage,
+                          Functor::SparseAdditiveUniformNoise<
+                            typename TInputImage::PixelType,
+                            typename TOutputImage::PixelType,
+                            TRealType >,
+                          TEngine >
 {
 public:
   /** Standard class typedefs. */
   typedef SparseAdditiveUniformNoiseImageFilter Self;
-  typedef UnaryFunctorImageFilter<
+  typedef SparseNoiseImageFilter<
     TInputImage, TOutputImage,
     Functor::SparseAdditiveUniformNoise< typename TInputImage::PixelType,
-                                    typename TOutputImage::PixelType > >  Superclass;
+                                    typename TOutputImage::PixelType,
+                                    TRealType >,
+    TEngine >  Superclass;
 
   typedef SmartPointer< Self >       Pointer;
   typedef SmartPointer< const Self > ConstPointer;
@@ -145,7 +186,7 @@ public:
   itkNewMacro(Self);
 
   /** Macro that provides the GetNameOfClass() method */
-  itkTypeMacro(SparseAdditiveUniformNoiseImageFilter, UnaryFunctorImageFilter);
+  itkTypeMacro(SparseAdditiveUniformNoiseImageFilter, SparseNoiseImageFilter);
 
   OutputPixelType GetOutputMinimum() const
     {
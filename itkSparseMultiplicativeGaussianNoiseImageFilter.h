@@ -1,9 +1,8 @@
 #ifndef __itkSparseMultiplicativeGaussianNoiseImageFilter
 #define __itkSparseMultiplicativeGaussianNoiseImageFilter
 
-#include <itkUnaryFunctorImageFilter.h>
+#include "itkSparseNoiseImageFilter.h"
 #include <itkConceptChecking.h>
-#include <vnl/vnl_sample.h>
 
 namespace itk
 {
@@ -14,10 +13,12 @@ namespace Functor
  * The probability to alter a pixel is user-defined.
  * \ingroup ITKImageIntensity
  */
-template< class TInput, class TOutput >
+template< class TInput, class TOutput, class TRealType = double >
 class SparseMultiplicativeGaussianNoise
 {
 public:
+  typedef TRealType RealType;
+
   SparseMultiplicativeGaussianNoise()
     {
     m_Probability = 1.0;
@@ -47,14 +48,14 @@ public:
     { return m_StandardDeviation; }
 
   void SetMean(const double mean)
-    { m_Mean = mean; }
+    { m_Mean = static_cast< RealType >( mean ); }
 
   void SetStandardDeviation(const double standardDeviation)
     {
     if(standardDeviation <= 0.0)
       itkGenericExceptionMacro("standard deviation must be strictly positive");
 
-    m_StandardDeviation = standardDeviation;
+    m_StandardDeviation = static_cast< RealType >( standardDeviation );
     }
 
   TOutput GetOutputMinimum() const
@@ -86,41 +87,81 @@ public:
     return !( *this != other );
     }
 
-  inline TOutput operator()(const TInput & A) const
+  /** Flags of the variant of Evaluate() and Corrupt() matching the parameters. */
+  unsigned int GetVariant() const
+    {
+    unsigned int variant = 0;
+    if ( !NoiseClampIsNeeded< TOutput, RealType >(m_OutputMinimum, m_OutputMaximum) )
+      {
+      variant |= NoiseVariantNoClamp;
+      }
+    return variant;
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine) const
+    {
+    float selected;
+    return Evaluate< VVariant >(A, engine, selected);
+    }
+
+  /** Noisy value of a pixel, and whether it was selected (1 or 0). */
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine, float & selected) const
     {
-    if(vnl_sample_uniform(0., 1.) <= m_Probability)
+    if(UniformVariate(engine) <= m_Probability)
       {
-      const double v = A * vnl_sample_normal(m_Mean, m_StandardDeviation);
-      return static_cast<TOutput>(v < m_OutputMinimum ? m_OutputMinimum : (v > m_OutputMaximum ? m_OutputMaximum : v));
+      selected = 1.0f;
+      return Corrupt< VVariant >(A, engine);
       }
-    else
-      return static_cast<TOutput>(A);
+
+    selected = 0.0f;
+    return static_cast<TOutput>(A);
+    }
+
+  template< class TEngine >
+  inline TOutput operator()(const TInput & A, TEngine & engine) const
+    {
+    return Evaluate< 0 >(A, engine);
+    }
+
+  /** Noisy value of a selected pixel. */
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Corrupt(const TInput & A, TEngine & engine) const
+    {
+    const RealType v = static_cast< RealType >( A ) * ( m_Mean + m_StandardDeviation * NormalVariate< RealType >(engine) );
+    return NoiseClamp< VVariant >(v, m_OutputMinimum, m_OutputMaximum);
     }
 
 private:
   TOutput m_OutputMinimum;
   TOutput m_OutputMaximum;
   double m_Probability;
-  double m_Mean;
-  double m_StandardDeviation;
+  RealType m_Mean;
+  RealType m_StandardDeviation;
 };
 } // End namespace Functor
 
-template< class TInputImage, class TOutputImage >
+template< class TInputImage, class TOutputImage, class TEngine = Xoshiro256PlusPlusEngine,
+          class TRealType = double >
 class ITK_EXPORT SparseMultiplicativeGaussianNoiseImageFilter:
   public
-  UnaryFunctorImageFilter< TInputImage, TOutputImage,
-                           Functor::SparseMultiplicativeGaussianNoise<
-                             typename TInputImage::PixelType,
-                             typename TOutputImage::PixelType > >
+  SparseNoiseImageFilter< TInputImage, TOutputImage,
+                          Functor::SparseMultiplicativeGaussianNoise<
+                            typename TInputImage::PixelType,
+                            typename TOutputImage::PixelType,
+                            TRealType >,
+                          TEngine >
 {
 public:
   /** Standard class typedefs. */
   typedef SparseMultiplicativeGaussianNoiseImageFilter Self;
-  typedef UnaryFunctorImageFilter<
+  typedef SparseNoiseImageFilter<
     TInputImage, TOutputImage,
     Functor::SparseMultiplicativeGaussianNoise< typename TInputImage::PixelType,
-                                    typename TOutputImage::PixelType > >  Superclass;
+                                    typename TOutputImage::PixelType,
+                                    TRealType >,
+    TEngine >  Superclass;
 
   typedef SmartPointer< Self >       Pointer;
   typedef SmartPointer< const Self > ConstPointer;
@@ -131,7 +172,7 @@ public:
   itkNewMacro(Self);
 
   /** Macro that provides the GetNameOfClass() method */
-  itkTypeMacro(SparseMultiplicativeGaussianNoiseImageFilter, UnaryFunctorImageFilter);
+  itkTypeMacro(SparseMultiplicativeGaussianNoiseImageFilter, SparseNoiseImageFilter);
 
   OutputPixelType GetOutputMinimum() const
     {
@@ -0,0 +1,239 @@
+#ifndef __itkSparseNoiseImageFilter
+#define __itkSparseNoiseImageFilter
+
+#include "itkNoiseImageFilter.h"
+
+#include <cmath>
+
+#include "noise_kernels.h"
+
+namespace itk
+{
+/** \class SparseNoiseImageFilter
+ * \brief Base class of the noise filters which only alter a random subset
+ * of the pixels.
+ * The functor gives the probability to alter a pixel with
+ * GetProbability(), and the altered value with Corrupt(). The filter
+ * selects the pixels itself, with one of two strategies:
+ *  - for low probabilities, the distance to the next selected pixel is
+ *    drawn from a geometric distribution (skip-ahead), so the cost is
+ *    proportional to the number of selected pixels;
+ *  - otherwise, 64 pixels are selected at once by a bitmask built from
+ *    32 bit random lanes compared to an integer threshold in SIMD
+ *    registers (see NoiseKernels::bernoulli_masks()), and only the set
+ *    bits are visited.
+ * The strategy is chosen by comparing the probability to
+ * SkipAheadMaximumProbability. When the probability is 1, all the pixels
+ * are altered without any selection.
+ * The noise field of these filters is the selection mask: 1 for the
+ * altered pixels, 0 for the others. The statistics variant counts the
+ * selected pixels as corrupted, whether or not their value changed.
+ * \ingroup ITKImageIntensity
+ */
+template< class TInputImage, class TOutputImage, class TFunction,
+          class TEngine = Xoshiro256PlusPlusEngine >
+class ITK_EXPORT SparseNoiseImageFilter:
+  public NoiseImageFilter< TInputImage, TOutputImage, TFunction, TEngine >
+{
+public:
+  /** Standard class typedefs. */
+  typedef SparseNoiseImageFilter                                          Self;
+  typedef NoiseImageFilter< TInputImage, TOutputImage, TFunction, TEngine > Superclass;
+  typedef SmartPointer< Self >                                            Pointer;
+  typedef SmartPointer< const Self >                                      ConstPointer;
+
+  /** Macro that provides the GetNameOfClass() method */
+  itkTypeMacro(SparseNoiseImageFilter, NoiseImageFilter);
+
+  typedef typename Superclass::InputImagePixelType  InputImagePixelType;
+  typedef typename Superclass::OutputImagePixelType OutputImagePixelType;
+  typedef typename Superclass::IndexType            IndexType;
+  typedef typename Superclass::NoisePixelType       NoisePixelType;
+  typedef typename Superclass::EngineType           EngineType;
+
+  /** Probability below which the pixels are selected by skip-ahead
+   * rather than by bitmasks. */
+  itkSetMacro(SkipAheadMaximumProbability, double);
+  itkGetConstMacro(SkipAheadMaximumProbability, double);
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+    {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "SkipAheadMaximumProbability: " << m_SkipAheadMaximumProbability << std::endl;
+    }
+
+protected:
+  SparseNoiseImageFilter()
+    {
+    m_SkipAheadMaximumProbability = 0.05;
+    }
+
+  virtual ~SparseNoiseImageFilter() {}
+
+  virtual void ProcessRun(const InputImagePixelType *in,
+                          OutputImagePixelType *out,
+                          NoisePixelType *noise,
+                          SizeValueType length,
+                          const IndexType & start) const
+    {
+    const double probability = this->GetFunctor().GetProbability();
+
+    if ( probability <= 0.0 )
+      {
+      Superclass::CopyRun( in, out, static_cast< IndexValueType >( length ) );
+      return;
+      }
+
+    switch ( this->GetFunctorVariant() )
+      {
+      case 0: this->ProcessRunVariant< 0 >(in, out, noise, length, start, probability); break;
+      case 1: this->ProcessRunVariant< 1 >(in, out, noise, length, start, probability); break;
+      case 2: this->ProcessRunVariant< 2 >(in, out, noise, length, start, probability); break;
+      case 3: this->ProcessRunVariant< 3 >(in, out, noise, length, start, probability); break;
+      case 4: this->ProcessRunVariant< 4 >(in, out, noise, length, start, probability); break;
+      case 5: this->ProcessRunVariant< 5 >(in, out, noise, length, start, probability); break;
+      case 6: this->ProcessRunVariant< 6 >(in, out, noise, length, start, probability); break;
+      default: this->ProcessRunVariant< 7 >(in, out, noise, length, start, probability); break;
+      }
+    }
+
+  virtual bool IsSparse() const
+    { return true; }
+
+  /** Counts selected pixels as corrupted in the statistics variant. */
+  template< unsigned int VVariant >
+  static void CountCorrupted(const SizeValueType selected)
+    {
+    if ( VVariant & Functor::NoiseVariantStatistics )
+      {
+      Functor::NoiseCountsOfThread().m_Corrupted += selected;
+      }
+    }
+
+private:
+  SparseNoiseImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+
+  template< unsigned int VVariant >
+  void ProcessRunVariant(const InputImagePixelType *in,
+                         OutputImagePixelType *out,
+                         NoisePixelType *noise,
+                         SizeValueType length,
+                         const IndexType & start,
+                         const double probability) const
+    {
+    EngineType engine;
+    this->SeedRunEngine(engine, start);
+
+    if ( probability >= 1.0 )
+      {
+      for ( SizeValueType i = 0; i < length; ++i )
+        {
+        out[i] = this->GetFunctor().template Corrupt< VVariant >(in[i], engine);
+        }
+      if ( noise )
+        {
+        std::fill( noise, noise + length, NoisePixelType(1) );
+        }
+      CountCorrupted< VVariant >(length);
+      }
+    else if ( probability < m_SkipAheadMaximumProbability )
+      {
+      this->ProcessRunSkipAhead< VVariant >(in, out, noise, length, probability, engine);
+      }
+    else
+      {
+      this->ProcessRunBitmask< VVariant >(in, out, noise, length, probability, engine);
+      }
+    }
+
+  template< unsigned int VVariant >
+  void ProcessRunSkipAhead(const InputImagePixelType *in,
+                           OutputImagePixelType *out,
+                           NoisePixelType *noise,
+                           SizeValueType length,
+                           const double probability,
+                           EngineType & engine) const
+    {
+    Superclass::CopyRun( in, out, static_cast< IndexValueType >( length ) );
+
+    const double logFailure = std::log1p(-probability);
+
+    double position = -1.0;
+    while ( true )
+      {
+      // Number of unselected pixels before the next selected one.
+      position += 1.0 + std::floor( std::log( 1.0 - UniformVariate(engine) ) / logFailure );
+      if ( position >= static_cast< double >( length ) )
+        {
+        break;
+        }
+
+      const SizeValueType i = static_cast< SizeValueType >( position );
+      out[i] = this->GetFunctor().template Corrupt< VVariant >(in[i], engine);
+      if ( noise )
+        {
+        noise[i] = NoisePixelType(1);
+        }
+      CountCorrupted< VVariant >(1);
+      }
+    }
+
+  template< unsigned int VVariant >
+  void ProcessRunBitmask(const InputImagePixelType *in,
+                         OutputImagePixelType *out,
+                         NoisePixelType *noise,
+                         SizeValueType length,
+                         const double probability,
+                         EngineType & engine) const
+    {
+    // Masks built per batch, to amortize the kernel call.
+    const SizeValueType batchMasks = 16;
+
+    const uint32_t threshold = static_cast< uint32_t >( probability * 4294967296.0 );
+
+    uint64_t words[batchMasks * NoiseKernels::BERNOULLI_MASK_WORDS];
+    uint64_t masks[batchMasks];
+
+    for ( SizeValueType batch = 0; batch < length; batch += 64 * batchMasks )
+      {
+      const SizeValueType count = std::min( batchMasks, ( length - batch + 63 ) / 64 );
+
+      engine.Fill( words, count * NoiseKernels::BERNOULLI_MASK_WORDS );
+      NoiseKernels::bernoulli_masks( words, count, threshold, masks );
+
+      for ( SizeValueType m = 0; m < count; ++m )
+        {
+        const SizeValueType begin = batch + 64 * m;
+        const SizeValueType size = std::min( static_cast< SizeValueType >( 64 ), length - begin );
+
+        uint64_t mask = masks[m];
+        if ( size < 64 )
+          {
+          mask &= ( static_cast< uint64_t >( 1 ) << size ) - 1;
+          }
+        CountCorrupted< VVariant >( __builtin_popcountll(mask) );
+
+        Superclass::CopyRun( in + begin, out + begin, static_cast< IndexValueType >( size ) );
+
+        while ( mask )
+          {
+          const SizeValueType i = begin + __builtin_ctzll(mask);
+          mask &= mask - 1;
+
+          out[i] = this->GetFunctor().template Corrupt< VVariant >(in[i], engine);
+          if ( noise )
+            {
+            noise[i] = NoisePixelType(1);
+            }
+          }
+        }
+      }
+    }
+
+  double m_SkipAheadMaximumProbability;
+};
+
+} // End namespace itk
+
+#endif /* __itkSparseNoiseImageFilter */
@@ -0,0 +1,247 @@
+#ifndef __itkSparseSpeckleNoiseImageFilter
+#define __itkSparseSpeckleNoiseImageFilter
+
+#include "itkSparseNoiseImageFilter.h"
+#include <itkConceptChecking.h>
+
+namespace itk
+{
+namespace Functor
+{
+/** \class SparseSpeckleNoise
+ * \brief Randomly multiplies a pixel by gamma distributed speckle.
+ * The probability to alter a pixel is user-defined. The multiplier is the
+ * one of SpeckleNoise.
+ * \ingroup ITKImageIntensity
+ */
+template< class TInput, class TOutput, class TRealType = double >
+class SparseSpeckleNoise
+{
+public:
+  typedef TRealType RealType;
+
+  SparseSpeckleNoise()
+    {
+    m_Probability = 1.0;
+    this->SetLooks(1.0);
+    m_OutputMinimum = itk::NumericTraits< TOutput >::NonpositiveMin();
+    m_OutputMaximum = itk::NumericTraits< TOutput >::max();
+    }
+
+  ~SparseSpeckleNoise() {}
+
+  double GetProbability() const
+    { return m_Probability; }
+
+  void SetProbability(const double probability)
+    {
+    if(probability < 0.0 || probability > 1.0)
+      itkGenericExceptionMacro("probability must be between 0 and 1");
+
+    m_Probability = probability;
+    }
+
+  double GetLooks() const
+    { return m_Gamma.m_Shape; }
+
+  void SetLooks(const double looks)
+    {
+    if(looks <= 0.0)
+      itkGenericExceptionMacro("number of looks must be strictly positive");
+
+    m_Gamma = GammaParameters(looks);
+    m_InverseLooks = static_cast< RealType >( 1.0 / looks );
+    }
+
+  TOutput GetOutputMinimum() const
+    { return m_OutputMinimum; }
+
+  TOutput GetOutputMaximum() const
+    { return m_OutputMaximum; }
+
+  void SetOutputBounds( const TOutput min, const TOutput max)
+    {
+    if(max <= min)
+      itkGenericExceptionMacro("invalid bounds: [" << min << "; " << max << "]");
+
+    m_OutputMinimum = min;
+    m_OutputMaximum = max;
+    }
+
+  bool operator!=(const SparseSpeckleNoise &other) const
+    {
+    return m_Probability != other.m_Probability
+      || GetLooks() != other.GetLooks()
+      || m_OutputMaximum != other.m_OutputMaximum
+      || m_OutputMinimum != other.m_OutputMinimum;
+    }
+
+  bool operator==(const SparseSpeckleNoise & other) const
+    {
+    return !( *this != other );
+    }
+
+  /** Flags of the variant of Evaluate() and Corrupt() matching the parameters. */
+  unsigned int GetVariant() const
+    {
+    unsigned int variant = 0;
+    if ( !NoiseClampIsNeeded< TOutput, RealType >(m_OutputMinimum, m_OutputMaximum) )
+      {
+      variant |= NoiseVariantNoClamp;
+      }
+    return variant;
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine) const
+    {
+    float selected;
+    return Evaluate< VVariant >(A, engine, selected);
+    }
+
+  /** Noisy value of a pixel, and whether it was selected (1 or 0). */
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine, float & selected) const
+    {
+    if(UniformVariate(engine) <= m_Probability)
+      {
+      selected = 1.0f;
+      return Corrupt< VVariant >(A, engine);
+      }
+
+    selected = 0.0f;
+    return static_cast<TOutput>(A);
+    }
+
+  template< class TEngine >
+  inline TOutput operator()(const TInput & A, TEngine & engine) const
+    {
+    return Evaluate< 0 >(A, engine);
+    }
+
+  /** Noisy value of a selected pixel. */
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Corrupt(const TInput & A, TEngine & engine) const
+    {
+    const RealType v = static_cast< RealType >( A ) * ( GammaVariate< RealType >(engine, m_Gamma) * m_InverseLooks );
+    return NoiseClamp< VVariant >(v, m_OutputMinimum, m_OutputMaximum);
+    }
+
+private:
+  TOutput m_OutputMinimum;
+  TOutput m_OutputMaximum;
+  double m_Probability;
+  GammaParameters m_Gamma;
+  RealType m_InverseLooks;
+};
+} // End namespace Functor
+
+template< class TInputImage, class TOutputImage, class TEngine = Xoshiro256PlusPlusEngine,
+          class TRealType = double >
+class ITK_EXPORT SparseSpeckleNoiseImageFilter:
+  public
+  SparseNoiseImageFilter< TInputImage, TOutputImage,
+                          Functor::SparseSpeckleNoise<
+                            typename TInputImage::PixelType,
+                            typename TOutputImage::PixelType,
+                            TRealType >,
+                          TEngine >
+{
+public:
+  /** Standard class typedefs. */
+  typedef SparseSpeckleNoiseImageFilter Self;
+  typedef SparseNoiseImageFilter<
+    TInputImage, TOutputImage,
+    Functor::SparseSpeckleNoise< typename TInputImage::PixelType,
+                                  typename TOutputImage::PixelType,
+                                  TRealType >,
+    TEngine >  Superclass;
+
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  typedef typename TOutputImage::PixelType OutputPixelType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Macro that provides the GetNameOfClass() method */
+  itkTypeMacro(SparseSpeckleNoiseImageFilter, SparseNoiseImageFilter);
+
+  OutputPixelType GetOutputMinimum() const
+    {
+    return this->GetFunctor().GetOutputMinimum();
+    }
+
+  OutputPixelType GetOutputMaximum() const
+    {
+    return this->GetFunctor().GetOutputMaximum();
+    }
+
+  float GetProbability() const
+    { return this->GetFunctor().GetProbability(); }
+
+  double GetLooks() const
+    { return this->GetFunctor().GetLooks(); }
+
+  void SetOutputBounds(const OutputPixelType min, const OutputPixelType max)
+    {
+    if ( min == this->GetFunctor().GetOutputMinimum() && max == this->GetFunctor().GetOutputMaximum())
+      {
+      return;
+      }
+
+    this->GetFunctor().SetOutputBounds(min, max);
+    this->Modified();
+    }
+
+  void SetProbability(const double probability)
+    {
+    if ( probability == this->GetFunctor().GetProbability() )
+      {
+      return;
+      }
+    this->GetFunctor().SetProbability(probability);
+    this->Modified();
+    }
+
+  /** Number of looks: the shape of the gamma distribution. */
+  void SetLooks(const double looks)
+    {
+    if ( looks == this->GetFunctor().GetLooks() )
+      {
+      return;
+      }
+
+    this->GetFunctor().SetLooks(looks);
+    this->Modified();
+    }
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+    {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "Probability: " << static_cast<typename NumericTraits<double>::PrintType>(GetProbability()) << std::endl;
+    os << indent << "Looks: " << static_cast<typename NumericTraits<double>::PrintType>(GetLooks()) << std::endl;
+    os << indent << "OutputMinimum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMinimum()) << std::endl;
+    os << indent << "OutputMaximum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMaximum()) << std::endl;
+    }
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  itkConceptMacro( InputConvertibleToDoubleCheck,
+    ( Concept::Convertible< typename TInputImage::PixelType, double > ) );
+  itkConceptMacro( DoubleConvertibleToOutputCheck,
+    ( Concept::Convertible< double, OutputPixelType > ) );
+#endif
+
+protected:
+  SparseSpeckleNoiseImageFilter() {}
+  virtual ~SparseSpeckleNoiseImageFilter() {}
+
+private:
+  SparseSpeckleNoiseImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+};
+
+} // End namespace itk
+
+#endif /* __itkSparseSpeckleNoiseImageFilter */
@@ -0,0 +1,332 @@
+#ifndef __itkSpeckleNoiseImageFilter
+#define __itkSpeckleNoiseImageFilter
+
+#include "itkNoiseImageFilter.h"
+#include <itkConceptChecking.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+namespace Functor
+{
+/** \class SpeckleNoise
+ * \brief Multiplies a pixel by gamma distributed speckle.
+ * The multiplier follows a gamma distribution of shape L and scale 1/L,
+ * where L is the number of looks: its mean is 1 and its variance 1/L. One
+ * look gives the exponential speckle of a fully developed intensity image.
+ * Unlike multiplicative gaussian noise, the multiplier is never negative.
+ * \ingroup ITKImageIntensity
+ */
+template< class TInput, class TOutput, class TRealType = double >
+class SpeckleNoise
+{
+public:
+  typedef TRealType RealType;
+
+  SpeckleNoise()
+    {
+    this->SetLooks(1.0);
+    m_OutputMinimum = itk::NumericTraits< TOutput >::NonpositiveMin();
+    m_OutputMaximum = itk::NumericTraits< TOutput >::max();
+    }
+
+  ~SpeckleNoise() {}
+
+  double GetLooks() const
+    { return m_Gamma.m_Shape; }
+
+  void SetLooks(const double looks)
+    {
+    if(looks <= 0.0)
+      itkGenericExceptionMacro("number of looks must be strictly positive");
+
+    m_Gamma = GammaParameters(looks);
+    m_InverseLooks = static_cast< RealType >( 1.0 / looks );
+    }
+
+  const GammaParameters & GetGammaParameters() const
+    { return m_Gamma; }
+
+  TOutput GetOutputMinimum() const
+    { return m_OutputMinimum; }
+
+  TOutput GetOutputMaximum() const
+    { return m_OutputMaximum; }
+
+  void SetOutputBounds( const TOutput min, const TOutput max)
+    {
+    if(max <= min)
+      itkGenericExceptionMacro("invalid bounds: [" << min << "; " << max << "]");
+
+    m_OutputMinimum = min;
+    m_OutputMaximum = max;
+    }
+
+  bool operator!=(const SpeckleNoise &other) const
+    {
+    return GetLooks() != other.GetLooks()
+      || m_OutputMaximum != other.m_OutputMaximum
+      || m_OutputMinimum != other.m_OutputMinimum;
+    }
+
+  bool operator==(const SpeckleNoise & other) const
+    {
+    return !( *this != other );
+    }
+
+  /** Flags of the variant of Evaluate() matching the parameters. */
+  unsigned int GetVariant() const
+    {
+    unsigned int variant = 0;
+    if ( !NoiseClampIsNeeded< TOutput, RealType >(m_OutputMinimum, m_OutputMaximum) )
+      {
+      variant |= NoiseVariantNoClamp;
+      }
+    return variant;
+    }
+
+  /** Noisy value of a pixel, given a gamma variate of scale 1. */
+  template< unsigned int VVariant >
+  inline TOutput Apply(const TInput & A, const RealType gamma) const
+    {
+    float noise;
+    return Apply< VVariant >(A, gamma, noise);
+    }
+
+  /** Noisy value of a pixel, given a gamma variate of scale 1, and its
+   * difference to A before clamping. */
+  template< unsigned int VVariant >
+  inline TOutput Apply(const TInput & A, const RealType gamma, float & noise) const
+    {
+    const RealType v = static_cast< RealType >( A ) * ( gamma * m_InverseLooks );
+    noise = static_cast< float >( v - static_cast< RealType >( A ) );
+    return NoiseClamp< VVariant >(v, m_OutputMinimum, m_OutputMaximum);
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine) const
+    {
+    return Apply< VVariant >( A, GammaVariate< RealType >(engine, m_Gamma) );
+    }
+
+  template< unsigned int VVariant, class TEngine >
+  inline TOutput Evaluate(const TInput & A, TEngine & engine, float & noise) const
+    {
+    return Apply< VVariant >( A, GammaVariate< RealType >(engine, m_Gamma), noise );
+    }
+
+  template< class TEngine >
+  inline TOutput operator()(const TInput & A, TEngine & engine) const
+    {
+    return Evaluate< 0 >(A, engine);
+    }
+
+private:
+  TOutput m_OutputMinimum;
+  TOutput m_OutputMaximum;
+  GammaParameters m_Gamma;
+  RealType m_InverseLooks;
+};
+} // End namespace Functor
+
+/** \class SpeckleNoiseImageFilter
+ * \brief Multiplies the pixels by gamma distributed speckle.
+ * The runs are processed by blocks: the normal variates of the
+ * Marsaglia-Tsang trials are drawn in pairs, the trials of the whole block
+ * are evaluated together, and only the rare rejected pixels are sampled
+ * again one by one.
+ * \ingroup ITKImageIntensity
+ */
+template< class TInputImage, class TOutputImage, class TEngine = Xoshiro256PlusPlusEngine,
+          class TRealType = double >
+class ITK_EXPORT SpeckleNoiseImageFilter:
+  public
+  NoiseImageFilter< TInputImage, TOutputImage,
+                    Functor::SpeckleNoise<
+                      typename TInputImage::PixelType,
+                      typename TOutputImage::PixelType,
+                      TRealType >,
+                    TEngine >
+{
+public:
+  /** Standard class typedefs. */
+  typedef SpeckleNoiseImageFilter Self;
+  typedef NoiseImageFilter<
+    TInputImage, TOutputImage,
+    Functor::SpeckleNoise< typename TInputImage::PixelType,
+                           typename TOutputImage::PixelType,
+                           TRealType >,
+    TEngine >  Superclass;
+
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  typedef typename Superclass::InputImagePixelType  InputImagePixelType;
+  typedef typename Superclass::OutputImagePixelType OutputImagePixelType;
+  typedef typename Superclass::IndexType            IndexType;
+  typedef typename Superclass::NoisePixelType       NoisePixelType;
+  typedef typename Superclass::EngineType           EngineType;
+  typedef typename TOutputImage::PixelType          OutputPixelType;
+  typedef TRealType                                 RealType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Macro that provides the GetNameOfClass() method */
+  itkTypeMacro(SpeckleNoiseImageFilter, NoiseImageFilter);
+
+  OutputPixelType GetOutputMinimum() const
+    {
+    return this->GetFunctor().GetOutputMinimum();
+    }
+
+  OutputPixelType GetOutputMaximum() const
+    {
+    return this->GetFunctor().GetOutputMaximum();
+    }
+
+  double GetLooks() const
+    { return this->GetFunctor().GetLooks(); }
+
+  void SetOutputBounds(const OutputPixelType min, const OutputPixelType max)
+    {
+    if ( min == this->GetFunctor().GetOutputMinimum() && max == this->GetFunctor().GetOutputMaximum())
+      {
+      return;
+      }
+
+    this->GetFunctor().SetOutputBounds(min, max);
+    this->Modified();
+    }
+
+  /** Number of looks: the shape of the gamma distribution. */
+  void SetLooks(const double looks)
+    {
+    if ( looks == this->GetFunctor().GetLooks() )
+      {
+      return;
+      }
+
+    this->GetFunctor().SetLooks(looks);
+    this->Modified();
+    }
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+    {
+    Superclass::PrintSelf(os, indent);
+    os << indent << "Looks: " << static_cast<typename NumericTraits<double>::PrintType>(GetLooks()) << std::endl;
+    os << indent << "OutputMinimum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMinimum()) << std::endl;
+    os << indent << "OutputMaximum: " << static_cast<typename NumericTraits<double>::PrintType>(GetOutputMaximum()) << std::endl;
+    }
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  itkConceptMacro( InputConvertibleToDoubleCheck,
+    ( Concept::Convertible< typename TInputImage::PixelType, double > ) );
+  itkConceptMacro( DoubleConvertibleToOutputCheck,
+    ( Concept::Convertible< double, OutputPixelType > ) );
+#endif
+
+protected:
+  SpeckleNoiseImageFilter() {}
+  virtual ~SpeckleNoiseImageFilter() {}
+
+  void ProcessRun(const InputImagePixelType *in,
+                  OutputImagePixelType *out,
+                  NoisePixelType *noise,
+                  SizeValueType length,
+                  const IndexType & start) const
+    {
+    if ( this->GetFunctorVariant() & Functor::NoiseVariantNoClamp )
+      {
+      this->ProcessRunVariant< Functor::NoiseVariantNoClamp >(in, out, noise, length, start);
+      }
+    else if ( this->GetFunctorVariant() & Functor::NoiseVariantStatistics )
+      {
+      this->ProcessRunVariant< Functor::NoiseVariantStatistics >(in, out, noise, length, start);
+      }
+    else
+      {
+      this->ProcessRunVariant< 0 >(in, out, noise, length, start);
+      }
+    }
+
+private:
+  SpeckleNoiseImageFilter(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+
+  template< unsigned int VVariant >
+  void ProcessRunVariant(const InputImagePixelType *in,
+                         OutputImagePixelType *out,
+                         NoisePixelType *noise,
+                         SizeValueType length,
+                         const IndexType & start) const
+    {
+    const typename Superclass::FunctorType & functor = this->GetFunctor();
+    const GammaParameters & gamma = functor.GetGammaParameters();
+    const bool boost = gamma.m_Shape < 1.0;
+    const RealType inverseShape = static_cast< RealType >( gamma.m_InverseShape );
+
+    EngineType engine;
+    this->SeedRunEngine(engine, start);
+
+    // Pixels whose random numbers are drawn at once. Even, so that the
+    // pairs of normal variates fit.
+    const SizeValueType blockSize = 64;
+
+    RealType z[blockSize];
+    RealType u[blockSize];
+    RealType x[blockSize];
+
+    for ( SizeValueType offset = 0; offset < length; offset += blockSize )
+      {
+      const SizeValueType count = std::min(blockSize, length - offset);
+
+      for ( SizeValueType i = 0; i < count; i += 2 )
+        {
+        NormalVariatePair(engine, z[i], z[i + 1]);
+        }
+      for ( SizeValueType i = 0; i < count; ++i )
+        {
+        u[i] = UniformVariate< RealType >(engine);
+        }
+
+      for ( SizeValueType i = 0; i < count; ++i )
+        {
+        if ( !GammaTrial(gamma, z[i], u[i], x[i]) )
+          {
+          while ( !GammaTrial(gamma, NormalVariate< RealType >(engine), UniformVariate< RealType >(engine), x[i]) )
+            {
+            }
+          }
+        }
+
+      if ( boost )
+        {
+        for ( SizeValueType i = 0; i < count; ++i )
+          {
+          x[i] *= std::pow(UniformVariate< RealType >(engine), inverseShape);
+          }
+        }
+
+      if ( noise )
+        {
+        for ( SizeValueType i = 0; i < count; ++i )
+          {
+          out[offset + i] = functor.template Apply< VVariant >(in[offset + i], x[i], noise[offset + i]);
+          }
+        continue;
+        }
+
+      for ( SizeValueType i = 0; i < count; ++i )
+        {
+        out[offset + i] = functor.template Apply< VVariant >(in[offset + i], x[i]);
+        }
+      }
+    }
+};
+
+} // End namespace itk
+
+#endif /* __itkSpeckleNoiseImageFilter */
@@ -0,0 +1,141 @@
+#ifndef __itkVolumeImportImageContainer
+#define __itkVolumeImportImageContainer
+
+#include <itkImportImageContainer.h>
+#include <itkObjectFactoryBase.h>
+#include <itkVersion.h>
+
+#include <new>
+#include <typeinfo>
+
+#include "buffer_pool.h"
+
+namespace itk
+{
+/** \class VolumeImportImageContainer
+ * \brief Pixel container whose buffer is obtained from the BufferPool.
+ * New buffers are aligned on huge pages and first-touched in parallel
+ * according to the VolumeAllocator policy, released ones are kept by the
+ * pool for the next image of the same size. Buffers are handled as raw
+ * memory, so TElement must be a plain old data type.
+ * \ingroup ITKCommon
+ */
+template< typename TElementIdentifier, typename TElement >
+class VolumeImportImageContainer:
+  public ImportImageContainer< TElementIdentifier, TElement >
+{
+public:
+  /** Standard class typedefs. */
+  typedef VolumeImportImageContainer                           Self;
+  typedef ImportImageContainer< TElementIdentifier, TElement > Superclass;
+  typedef SmartPointer< Self >                                 Pointer;
+  typedef SmartPointer< const Self >                           ConstPointer;
+
+  typedef TElementIdentifier ElementIdentifier;
+  typedef TElement           Element;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Macro that provides the GetNameOfClass() method */
+  itkTypeMacro(VolumeImportImageContainer, ImportImageContainer);
+
+protected:
+  VolumeImportImageContainer() {}
+
+  /** The superclass destructor would call its own deallocation method. */
+  virtual ~VolumeImportImageContainer()
+    {
+    this->DeallocateManagedMemory();
+    }
+
+  virtual TElement * AllocateElements(ElementIdentifier size, bool UseDefaultConstructor = false) const
+    {
+    try
+      {
+      return static_cast< TElement * >(
+        BufferPool::acquire( size * sizeof( TElement ), typeid( TElement ).name(), UseDefaultConstructor ) );
+      }
+    catch ( std::bad_alloc & )
+      {
+      throw MemoryAllocationError(__FILE__, __LINE__,
+                                  "Failed to allocate memory for image.",
+                                  ITK_LOCATION);
+      }
+    }
+
+  virtual void DeallocateManagedMemory()
+    {
+    if ( this->GetImportPointer() && this->GetContainerManageMemory() )
+      {
+      BufferPool::release( this->GetImportPointer(),
+                           this->Capacity() * sizeof( TElement ),
+                           typeid( TElement ).name() );
+      }
+
+    this->SetImportPointer(ITK_NULLPTR);
+    this->SetCapacity(0);
+    this->SetSize(0);
+    }
+
+private:
+  VolumeImportImageContainer(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+};
+
+/** \class VolumeImportImageContainerFactory
+ * \brief Overrides the pixel container of the images of TElement pixels
+ * with a VolumeImportImageContainer.
+ * \ingroup ITKCommon
+ */
+template< typename TElementIdentifier, typename TElement >
+class VolumeImportImageContainerFactory:
+  public ObjectFactoryBase
+{
+public:
+  /** Standard class typedefs. */
+  typedef VolumeImportImageContainerFactory Self;
+  typedef ObjectFactoryBase                 Superclass;
+  typedef SmartPointer< Self >              Pointer;
+  typedef SmartPointer< const Self >        ConstPointer;
+
+  typedef ImportImageContainer< TElementIdentifier, TElement >       DefaultContainerType;
+  typedef VolumeImportImageContainer< TElementIdentifier, TElement > ContainerType;
+
+  virtual const char * GetITKSourceVersion() const
+    { return ITK_SOURCE_VERSION; }
+
+  virtual const char * GetDescription() const
+    { return "Volume allocator pixel container factory"; }
+
+  /** Method for class instantiation. */
+  itkFactorylessNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(VolumeImportImageContainerFactory, ObjectFactoryBase);
+
+  /** Register one factory of this type. */
+  static void RegisterOneFactory()
+    {
+    Pointer factory = Self::New();
+    ObjectFactoryBase::RegisterFactory(factory);
+    }
+
+protected:
+  VolumeImportImageContainerFactory()
+    {
+    this->RegisterOverride( typeid( DefaultContainerType ).name(),
+                            typeid( ContainerType ).name(),
+                            "Volume allocator pixel container",
+                            1,
+                            CreateObjectFunction< ContainerType >::New() );
+    }
+
+private:
+  VolumeImportImageContainerFactory(const Self &); //purposely not implemented
+  void operator=(const Self &);     //purposely not implemented
+};
+
+} // End namespace itk
+
+#endif /* __itkVolumeImportImageContainer */
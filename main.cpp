@@ -3,8 +3,15 @@
 
 #include "image_reader.h"
 #include "image_writer.h"
+#include "image_stream.h"
+#include "statistics_writer.h"
+#include "series_journal.h"
+#include "color_noise.h"
 
 #include "cli_parser.h"
+#include "volume_allocator.h"
+#include "buffer_pool.h"
+#include "noise_kernels.h"
 
 #include "log4cxx/logger.h"
 #include "log4cxx/consoleappender.h"
@@ -18,104 +25,834 @@
 #include "itkAdditiveUniformNoiseImageFilter.h"
 #include "itkSparseAdditiveUniformNoiseImageFilter.h"
 #include "itkImpulseNoiseImageFilter.h"
+#include "itkPoissonNoiseImageFilter.h"
+#include "itkRicianNoiseImageFilter.h"
+#include "itkCameraNoiseImageFilter.h"
+#include "itkSpeckleNoiseImageFilter.h"
+#include "itkSparseSpeckleNoiseImageFilter.h"
+#include "itkCorrelatedGaussianNoiseImageFilter.h"
+#include "itkKSpaceNoiseImageFilter.h"
+#include "itkAdditiveSimplexNoiseImageFilter.h"
+#include "itkNoiseImageSource.h"
+#include "itkNoiseLevelEstimationImageFilter.h"
+#include "itkVolumeImportImageContainer.h"
 
-typedef itk::AdditiveGaussianNoiseImageFilter< ImageType, ImageType > GaussianNoiseGenerator;
-typedef itk::SparseAdditiveGaussianNoiseImageFilter< ImageType, ImageType > SparseGaussianNoiseGenerator;
-typedef itk::AdditiveUniformNoiseImageFilter< ImageType, ImageType > UniformNoiseGenerator;
-typedef itk::SparseAdditiveUniformNoiseImageFilter< ImageType, ImageType > SparseUniformNoiseGenerator;
-typedef itk::ImpulseNoiseImageFilter< ImageType, ImageType > ImpulseNoiseGenerator;
-typedef itk::MultiplicativeGaussianNoiseImageFilter< ImageType, ImageType > MultiplicativeGaussianNoiseGenerator;
-typedef itk::SparseMultiplicativeGaussianNoiseImageFilter< ImageType, ImageType > SparseMultiplicativeGaussianNoiseGenerator;
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
 
-int main(int argc, char **argv)
+typedef itk::VolumeImportImageContainerFactory< ImageType::PixelContainer::ElementIdentifier, ImageType::PixelType > VolumeContainerFactory;
+
+typedef itk::ImageToImageFilter< ImageType, ImageType >::Pointer FilterPointer;
+typedef itk::ImageSource< ImageType >::Pointer SourcePointer;
+
+template< typename TFilter >
+void setupNoiseFilter(TFilter *filter, const CliParser &cli_parser, ImageType::Pointer image, ImageType::Pointer mask,
+                      const itk::NoiseStatistics **statistics)
 {
-	log4cxx::BasicConfigurator::configure(
-			log4cxx::AppenderPtr(new log4cxx::ConsoleAppender(
-					log4cxx::LayoutPtr(new log4cxx::PatternLayout("\%-5p - [%c] - \%m\%n")),
-					log4cxx::ConsoleAppender::getSystemErr()
-					)
-				)
-			);
+	filter->SetInput(image);
+	filter->SetSeed(cli_parser.get_seed());
+	filter->SetGenerateNoiseOutput(!cli_parser.get_noise_outputs().empty());
 
-	log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("main"));
+	filter->SetComputeStatistics(NULL != statistics);
+	if(NULL != statistics)
+		*statistics = &filter->GetStatistics();
 
-	CliParser cli_parser;
-	try {
-		if(cli_parser.parse_argv(argc, argv) != CliParser::CONTINUE)
-			exit(0);
-	} catch (CliException &err) {
-		LOG4CXX_FATAL(logger, err.what());
-		return -1;
+	if(mask.IsNotNull())
+		filter->SetMaskImage(mask);
+
+	const std::vector< int > roi = cli_parser.get_roi();
+	if(!roi.empty()) {
+		ImageType::IndexType index;
+		ImageType::SizeType size;
+		for(unsigned int d = 0; d < ImageType::ImageDimension; ++d) {
+			index[d] = roi[d];
+			size[d] = roi[ImageType::ImageDimension + d];
+		}
+		filter->SetRegionOfInterest(ImageType::RegionType(index, size));
 	}
+}
 
-	ImageType::Pointer input_image;
+/**
+ * Noise field of a noise filter (see NoiseImageFilter::GetNoiseOutput()), NULL
+ * when it does not generate it.
+ */
+NoiseImageType::Pointer getNoiseOutput(FilterPointer filter)
+{
+	const itk::ProcessObject::DataObjectPointerArray outputs = filter->GetIndexedOutputs();
+	if(outputs.size() < 2)
+		return NULL;
 
-	ImageType::Pointer image;
-	try {
-		image = ImageReader::read(cli_parser.get_input_image());
-	} catch (ImageReadingException & ex) {
-		LOG4CXX_FATAL(logger, "ITK is unable to read the image \"" << cli_parser.get_input_image() << "\" (" << ex.what() << ")");
-		exit(-1);
-	}
+	return dynamic_cast< NoiseImageType * >(outputs[1].GetPointer());
+}
+
+template< typename TSource >
+void setupNoiseSource(TSource *source, ImageType::Pointer reference)
+{
+	source->SetSize(reference->GetLargestPossibleRegion().GetSize());
+	source->SetSpacing(reference->GetSpacing());
+	source->SetOrigin(reference->GetOrigin());
+	source->SetDirection(reference->GetDirection());
+}
+
+/**
+ * Create in source, when it is not NULL, a source generating the noise of
+ * the filter without input image, with the geometry of reference.
+ */
+template< typename TFilter >
+void createNoiseSource(TFilter *filter, const CliParser &cli_parser, ImageType::Pointer reference, SourcePointer *source)
+{
+	if(NULL == source)
+		return;
+
+	typedef itk::NoiseImageSource< ImageType, typename TFilter::FunctorType, typename TFilter::EngineType > NoiseSource;
+
+	typename NoiseSource::Pointer ns = NoiseSource::New();
+	setupNoiseSource(ns.GetPointer(), reference);
+	ns->SetFunctor(filter->GetFunctor());
+	ns->SetSeed(filter->GetSeed());
+	ns->SetBackground(static_cast< ImageType::PixelType >(cli_parser.get_background()));
+	*source = SourcePointer(ns);
+}
+
+template< typename TEngine, typename TRealType >
+void createNoiseSource(itk::AdditiveSimplexNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > *filter,
+                       const CliParser &cli_parser, ImageType::Pointer reference, SourcePointer *source)
+{
+	if(NULL == source)
+		return;
+
+	typedef itk::SimplexNoiseImageSource< ImageType > SimplexSource;
+
+	itk::SimplexNoiseTexture texture = filter->GetFunctor().GetTexture();
+	texture.SetSeed(filter->GetSeed());
+
+	typename SimplexSource::Pointer ns = SimplexSource::New();
+	setupNoiseSource(ns.GetPointer(), reference);
+	ns->SetTexture(texture);
+	ns->SetMean(cli_parser.get_background());
+	ns->SetAmplitude(filter->GetAmplitude());
+	*source = SourcePointer(ns);
+}
+
+/**
+ * Create the noise filter of the command line. When source is not NULL, also
+ * create in it a source generating the same noise without input image, with
+ * the geometry of image (left NULL for the noises which are not pixel-wise).
+ * When statistics is not NULL, the filter computes its statistics, which are
+ * pointed by statistics.
+ */
+template< typename TEngine, typename TRealType >
+FilterPointer createNoiseFilter(const CliParser &cli_parser, ImageType::Pointer image, ImageType::Pointer mask,
+                                SourcePointer *source, const itk::NoiseStatistics **statistics)
+{
+	typedef itk::AdditiveGaussianNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > GaussianNoiseGenerator;
+	typedef itk::SparseAdditiveGaussianNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > SparseGaussianNoiseGenerator;
+	typedef itk::AdditiveUniformNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > UniformNoiseGenerator;
+	typedef itk::SparseAdditiveUniformNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > SparseUniformNoiseGenerator;
+	typedef itk::ImpulseNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > ImpulseNoiseGenerator;
+	typedef itk::MultiplicativeGaussianNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > MultiplicativeGaussianNoiseGenerator;
+	typedef itk::SparseMultiplicativeGaussianNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > SparseMultiplicativeGaussianNoiseGenerator;
+	typedef itk::PoissonNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > PoissonNoiseGenerator;
+	typedef itk::RicianNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > RicianNoiseGenerator;
+	typedef itk::CameraNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > CameraNoiseGenerator;
+	typedef itk::SpeckleNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > SpeckleNoiseGenerator;
+	typedef itk::SparseSpeckleNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > SparseSpeckleNoiseGenerator;
+	typedef itk::CorrelatedGaussianNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > CorrelatedGaussianNoiseGenerator;
+	typedef itk::KSpaceNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > KSpaceNoiseGenerator;
+	typedef itk::AdditiveSimplexNoiseImageFilter< ImageType, ImageType, TEngine, TRealType > SimplexNoiseGenerator;
 
 	const std::string noise_type = cli_parser.get_noise_type();
 
-	typedef itk::ImageToImageFilter< ImageType, ImageType >::Pointer FilterPointer;
 	FilterPointer noiseFilter;
 
 	if(0 == noise_type.compare("gaussian")) {
-		GaussianNoiseGenerator::Pointer ng = GaussianNoiseGenerator::New();
-		ng->SetInput(image);
+		typename GaussianNoiseGenerator::Pointer ng = GaussianNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
 		ng->SetMean(0.0);
 		ng->SetStandardDeviation(cli_parser.get_stddev());
+		createNoiseSource(ng.GetPointer(), cli_parser, image, source);
 		noiseFilter = FilterPointer(ng);
 	} else if(0 == noise_type.compare("sparse-gaussian")) {
-		SparseGaussianNoiseGenerator::Pointer ng = SparseGaussianNoiseGenerator::New();
-		ng->SetInput(image);
+		typename SparseGaussianNoiseGenerator::Pointer ng = SparseGaussianNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
 		ng->SetProbability(cli_parser.get_probability());
 		ng->SetMean(0.0);
 		ng->SetStandardDeviation(cli_parser.get_stddev());
+		createNoiseSource(ng.GetPointer(), cli_parser, image, source);
 		noiseFilter = FilterPointer(ng);
 	} else if(0 == noise_type.compare("uniform")) {
-		UniformNoiseGenerator::Pointer ng = UniformNoiseGenerator::New();
-		ng->SetInput(image);
+		typename UniformNoiseGenerator::Pointer ng = UniformNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
 		ng->SetMean(0.0);
 		ng->SetAmplitude(cli_parser.get_amplitude());
+		createNoiseSource(ng.GetPointer(), cli_parser, image, source);
 		noiseFilter = FilterPointer(ng);
 	} else if(0 == noise_type.compare("sparse-uniform")) {
-		SparseUniformNoiseGenerator::Pointer ng = SparseUniformNoiseGenerator::New();
-		ng->SetInput(image);
+		typename SparseUniformNoiseGenerator::Pointer ng = SparseUniformNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
 		ng->SetProbability(cli_parser.get_probability());
 		ng->SetMean(0.0);
 		ng->SetAmplitude(cli_parser.get_amplitude());
+		createNoiseSource(ng.GetPointer(), cli_parser, image, source);
 		noiseFilter = FilterPointer(ng);
 	} else if(0 == noise_type.compare("impulse")) {
-		ImpulseNoiseGenerator::Pointer ng = ImpulseNoiseGenerator::New();
-		ng->SetInput(image);
+		typename ImpulseNoiseGenerator::Pointer ng = ImpulseNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
 		ng->SetProbability(cli_parser.get_probability());
+		createNoiseSource(ng.GetPointer(), cli_parser, image, source);
 		noiseFilter = FilterPointer(ng);
 	} else if(0 == noise_type.compare("mult-gaussian")) {
-		MultiplicativeGaussianNoiseGenerator::Pointer ng = MultiplicativeGaussianNoiseGenerator::New();
-		ng->SetInput(image);
+		typename MultiplicativeGaussianNoiseGenerator::Pointer ng = MultiplicativeGaussianNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
 		ng->SetMean(1.0);
 		ng->SetStandardDeviation(cli_parser.get_stddev());
+		createNoiseSource(ng.GetPointer(), cli_parser, image, source);
 		noiseFilter = FilterPointer(ng);
 	} else if(0 == noise_type.compare("sparse-mult-gaussian")) {
-		SparseMultiplicativeGaussianNoiseGenerator::Pointer ng = SparseMultiplicativeGaussianNoiseGenerator::New();
-		ng->SetInput(image);
+		typename SparseMultiplicativeGaussianNoiseGenerator::Pointer ng = SparseMultiplicativeGaussianNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
 		ng->SetProbability(cli_parser.get_probability());
 		ng->SetMean(1.0);
 		ng->SetStandardDeviation(cli_parser.get_stddev());
+		createNoiseSource(ng.GetPointer(), cli_parser, image, source);
+		noiseFilter = FilterPointer(ng);
+	} else if(0 == noise_type.compare("poisson")) {
+		typename PoissonNoiseGenerator::Pointer ng = PoissonNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
+		ng->SetScale(cli_parser.get_scale());
+		createNoiseSource(ng.GetPointer(), cli_parser, image, source);
+		noiseFilter = FilterPointer(ng);
+	} else if(0 == noise_type.compare("rician")) {
+		typename RicianNoiseGenerator::Pointer ng = RicianNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
+		ng->SetStandardDeviation(cli_parser.get_stddev());
+		createNoiseSource(ng.GetPointer(), cli_parser, image, source);
+		noiseFilter = FilterPointer(ng);
+	} else if(0 == noise_type.compare("camera")) {
+		typename CameraNoiseGenerator::Pointer ng = CameraNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
+		ng->SetGain(cli_parser.get_gain());
+		ng->SetReadNoise(cli_parser.get_read_noise());
+		ng->SetDarkOffset(cli_parser.get_dark_offset());
+		createNoiseSource(ng.GetPointer(), cli_parser, image, source);
+		noiseFilter = FilterPointer(ng);
+	} else if(0 == noise_type.compare("speckle")) {
+		typename SpeckleNoiseGenerator::Pointer ng = SpeckleNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
+		ng->SetLooks(cli_parser.get_looks());
+		createNoiseSource(ng.GetPointer(), cli_parser, image, source);
+		noiseFilter = FilterPointer(ng);
+	} else if(0 == noise_type.compare("sparse-speckle")) {
+		typename SparseSpeckleNoiseGenerator::Pointer ng = SparseSpeckleNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
+		ng->SetProbability(cli_parser.get_probability());
+		ng->SetLooks(cli_parser.get_looks());
+		createNoiseSource(ng.GetPointer(), cli_parser, image, source);
+		noiseFilter = FilterPointer(ng);
+	} else if(0 == noise_type.compare("correlated-gaussian")) {
+		typename CorrelatedGaussianNoiseGenerator::Pointer ng = CorrelatedGaussianNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
+		ng->SetStandardDeviation(cli_parser.get_stddev());
+		ng->SetSigma(cli_parser.get_correlation_sigma());
+		noiseFilter = FilterPointer(ng);
+	} else if(0 == noise_type.compare("kspace")) {
+		typename KSpaceNoiseGenerator::Pointer ng = KSpaceNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
+		ng->SetStandardDeviation(cli_parser.get_stddev());
+		ng->SetAccelerationFactor(cli_parser.get_acceleration());
+		ng->SetCenterFraction(cli_parser.get_center_fraction());
 		noiseFilter = FilterPointer(ng);
-	} else {
-		LOG4CXX_FATAL(logger, "No \"" << noise_type << "\" noise found.");
+	} else if(0 == noise_type.compare("simplex")) {
+		typename SimplexNoiseGenerator::Pointer ng = SimplexNoiseGenerator::New();
+		setupNoiseFilter(ng.GetPointer(), cli_parser, image, mask, statistics);
+		ng->SetAmplitude(cli_parser.get_amplitude());
+		ng->SetFrequency(cli_parser.get_frequency());
+		ng->SetOctaves(cli_parser.get_octaves());
+		ng->SetPersistence(cli_parser.get_persistence());
+		ng->SetLacunarity(cli_parser.get_lacunarity());
+		createNoiseSource(ng.GetPointer(), cli_parser, image, source);
+		noiseFilter = FilterPointer(ng);
+	}
+
+	return noiseFilter;
+}
+
+template< typename TEngine >
+FilterPointer createNoiseFilter(const CliParser &cli_parser, ImageType::Pointer image, ImageType::Pointer mask,
+                                SourcePointer *source, const itk::NoiseStatistics **statistics)
+{
+	if(0 == cli_parser.get_precision().compare("float"))
+		return createNoiseFilter< TEngine, float >(cli_parser, image, mask, source, statistics);
+	else
+		return createNoiseFilter< TEngine, double >(cli_parser, image, mask, source, statistics);
+}
+
+const char * const rng_engines[] = { "xoshiro256pp", "pcg64", "philox4x32", "mt19937_64" };
+const size_t rng_engines_count = sizeof(rng_engines) / sizeof(rng_engines[0]);
+
+FilterPointer createNoiseFilter(const std::string &rng_engine, const CliParser &cli_parser, ImageType::Pointer image, ImageType::Pointer mask,
+                                SourcePointer *source = NULL, const itk::NoiseStatistics **statistics = NULL)
+{
+	if(0 == rng_engine.compare("xoshiro256pp"))
+		return createNoiseFilter< itk::Xoshiro256PlusPlusEngine >(cli_parser, image, mask, source, statistics);
+	else if(0 == rng_engine.compare("pcg64"))
+		return createNoiseFilter< itk::Pcg64Engine >(cli_parser, image, mask, source, statistics);
+	else if(0 == rng_engine.compare("philox4x32"))
+		return createNoiseFilter< itk::Philox4x32Engine >(cli_parser, image, mask, source, statistics);
+	else if(0 == rng_engine.compare("mt19937_64"))
+		return createNoiseFilter< itk::Mt19937_64Engine >(cli_parser, image, mask, source, statistics);
+
+	return FilterPointer();
+}
+
+/**
+ * Create an empty image with the geometry of the generated images: the one of
+ * the reference image, or the size, spacing and origin of the command line.
+ */
+ImageType::Pointer createGeometry(const CliParser &cli_parser)
+{
+	if(!cli_parser.get_reference_image().empty())
+		return ImageReader::read_information(cli_parser.get_reference_image());
+
+	const std::vector< int > size = cli_parser.get_size();
+	const std::vector< double > spacing = cli_parser.get_spacing();
+	const std::vector< double > origin = cli_parser.get_origin();
+
+	ImageType::SizeType imageSize;
+	ImageType::SpacingType imageSpacing;
+	ImageType::PointType imageOrigin;
+	for(unsigned int d = 0; d < __ImageDimension; ++d) {
+		imageSize[d] = size[d];
+		imageSpacing[d] = spacing[d];
+		imageOrigin[d] = origin[d];
+	}
+
+	ImageType::RegionType region;
+	region.SetSize(imageSize);
+
+	ImageType::Pointer image = ImageType::New();
+	image->SetRegions(region);
+	image->SetSpacing(imageSpacing);
+	image->SetOrigin(imageOrigin);
+	return image;
+}
+
+/**
+ * Read the geometry of the image of the standard input: the one of its
+ * MetaImage header, or the size, spacing and origin of the command line for
+ * raw pixels, whose bytes are in the order of this machine.
+ */
+ImageType::Pointer readStreamGeometry(const CliParser &cli_parser, bool &swap)
+{
+	swap = false;
+	if(!cli_parser.get_size().empty())
+		return createGeometry(cli_parser);
+
+	return ImageStream::read_header(std::cin, swap);
+}
+
+/**
+ * Read an input image from a file, only the slices of sliceRange when it is not
+ * empty, or from the standard input.
+ */
+ImageType::Pointer readInput(const std::string &filename, const CliParser &cli_parser, const std::vector< int > &sliceRange)
+{
+	if(!ImageStream::is_stream(filename) || cli_parser.get_size().empty())
+		return ImageReader::read(filename, sliceRange);
+
+	try {
+		bool swap;
+		ImageType::Pointer geometry = readStreamGeometry(cli_parser, swap);
+		ImageType::Pointer image = ImageStream::create_slab(geometry, 0, geometry->GetLargestPossibleRegion().GetSize(__ImageDimension - 1));
+		ImageStream::read_slab(std::cin, image, swap);
+		return image;
+	} catch (ImageStreamException & ex) {
+		throw ImageReadingException(ex.what());
+	}
+}
+
+/**
+ * The parameters of a job which change the slices it writes, on a single line
+ * recorded in the journals of its series.
+ * @param[in] cli_parser The command line.
+ * @param[in] input The input image of the job.
+ */
+std::string jobParameters(const CliParser &cli_parser, const std::string &input)
+{
+	std::stringstream parameters;
+	parameters << std::setprecision(17)
+	           << "input=" << input
+	           << " noise=" << cli_parser.get_noise_type()
+	           << " engine=" << cli_parser.get_rng_engine()
+	           << " seed=" << cli_parser.get_seed()
+	           << " precision=" << cli_parser.get_precision()
+	           << " stddev=" << cli_parser.get_stddev()
+	           << " amplitude=" << cli_parser.get_amplitude()
+	           << " probability=" << cli_parser.get_probability()
+	           << " scale=" << cli_parser.get_scale()
+	           << " gain=" << cli_parser.get_gain()
+	           << " read-noise=" << cli_parser.get_read_noise()
+	           << " dark-offset=" << cli_parser.get_dark_offset()
+	           << " looks=" << cli_parser.get_looks()
+	           << " frequency=" << cli_parser.get_frequency()
+	           << " octaves=" << cli_parser.get_octaves()
+	           << " persistence=" << cli_parser.get_persistence()
+	           << " lacunarity=" << cli_parser.get_lacunarity()
+	           << " color-noise=" << cli_parser.get_color_noise()
+	           << " mask=" << cli_parser.get_mask_image()
+	           << " roi=";
+
+	const std::vector< int > roi = cli_parser.get_roi();
+	for(size_t i = 0; i < roi.size(); ++i)
+		parameters << (i ? "," : "") << roi[i];
+
+	return parameters.str();
+}
+
+/**
+ * Restrict the slices of a job to the ones following the last slice recorded in
+ * all the journals of its outputs.
+ * @param[in] input The input image, whose slices are counted without range.
+ * @param[in] journals The journals, the empty names being ignored.
+ * @param[in,out] sliceRange The slices of the job, all of them when empty.
+ * @return false if all the slices are already written.
+ */
+bool resumeSliceRange(const std::string &input, const std::vector< std::string > &journals, std::vector< int > &sliceRange)
+{
+	if(sliceRange.empty()) {
+		ImageType::Pointer geometry = ImageReader::read_information(input);
+		sliceRange.push_back(0);
+		sliceRange.push_back(geometry->GetLargestPossibleRegion().GetSize(__ImageDimension - 1));
 	}
 
-	noiseFilter->Update();
+	int first = sliceRange[1];
+	for(size_t j = 0; j < journals.size(); ++j) {
+		if(journals[j].empty())
+			continue;
 
-	LOG4CXX_DEBUG(logger, "Noise generated");
+		const std::set< int > written = SeriesJournal::read(journals[j]);
 
-	ImageWriter::write(noiseFilter->GetOutput(), cli_parser.get_output_image());
+		int next = sliceRange[0];
+		while(next < sliceRange[1] && written.count(next))
+			++next;
+
+		first = std::min(first, next);
+	}
+
+	sliceRange[0] = first;
+	return first < sliceRange[1];
+}
+
+/**
+ * Whether a mask has the pixels of an image: the same index and size on
+ * every axis.
+ */
+bool maskMatches(ImageType::Pointer mask, ImageType::Pointer image)
+{
+	return mask->GetBufferedRegion() == image->GetBufferedRegion();
+}
+
+/**
+ * Whether a noise depends on the whole image, and not only on each pixel.
+ */
+bool needsWholeImage(const std::string &noise_type)
+{
+	return 0 == noise_type.compare("correlated-gaussian") || 0 == noise_type.compare("kspace");
+}
+
+/**
+ * Add noise to the image of the standard input and write it on the standard
+ * output, slab by slab as it is received, so that the memory used does not
+ * depend on the size of the image. A slab has the indices it has in the whole
+ * image, so the noise is the same as for the whole image. The noises
+ * depending on the whole image are applied to a single slab.
+ * @param[out] statistics When not NULL, receives the sum of the statistics of
+ * the slabs.
+ */
+void processStream(const CliParser &cli_parser, itk::NoiseStatistics *statistics)
+{
+	log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("main"));
+
+	bool swap;
+	ImageType::Pointer geometry = readStreamGeometry(cli_parser, swap);
+
+	const bool raw = !cli_parser.get_size().empty();
+	if(!raw)
+		ImageStream::write_header(std::cout, geometry);
+
+	const unsigned int slices = geometry->GetLargestPossibleRegion().GetSize(__ImageDimension - 1);
+	const unsigned int slabSlices = needsWholeImage(cli_parser.get_noise_type()) ? slices : cli_parser.get_slab_slices();
+
+	LOG4CXX_INFO(logger, "Piping an image of size " << geometry->GetLargestPossibleRegion().GetSize()
+	             << " from the standard input to the standard output, by " << std::min(slabSlices, slices) << " slices");
+
+	for(unsigned int first = 0; first < slices; first += slabSlices)
+	{
+		ImageType::Pointer slab = ImageStream::create_slab(geometry, first, std::min(slabSlices, slices - first));
+		ImageStream::read_slab(std::cin, slab, swap);
+
+		const itk::NoiseStatistics *slabStatistics = NULL;
+		FilterPointer noiseFilter = createNoiseFilter(cli_parser.get_rng_engine(), cli_parser, slab, ImageType::Pointer(), NULL,
+		                                              NULL == statistics ? NULL : &slabStatistics);
+		if(noiseFilter.IsNull()) {
+			LOG4CXX_FATAL(logger, "No \"" << cli_parser.get_noise_type() << "\" noise found.");
+			exit(-1);
+		}
+
+		noiseFilter->Update();
+
+		if(NULL != statistics)
+			*statistics += *slabStatistics;
+
+		ImageStream::write_slab(std::cout, noiseFilter->GetOutput(), slab->GetLargestPossibleRegion());
+	}
+
+	std::cout.flush();
+}
+
+int main(int argc, char **argv)
+{
+	log4cxx::BasicConfigurator::configure(
+			log4cxx::AppenderPtr(new log4cxx::ConsoleAppender(
+					log4cxx::LayoutPtr(new log4cxx::PatternLayout("\%-5p - [%c] - \%m\%n")),
+					log4cxx::ConsoleAppender::getSystemErr()
+					)
+				)
+			);
+
+	log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("main"));
+
+	CliParser cli_parser;
+	try {
+		if(cli_parser.parse_argv(argc, argv) != CliParser::CONTINUE)
+			exit(0);
+	} catch (CliException &err) {
+		LOG4CXX_FATAL(logger, err.what());
+		return -1;
+	}
+
+	if(cli_parser.get_huge_pages() || cli_parser.get_parallel_first_touch() || cli_parser.get_buffer_pool()) {
+		VolumeAllocator::configure(cli_parser.get_huge_pages(), cli_parser.get_parallel_first_touch());
+		BufferPool::set_enabled(cli_parser.get_buffer_pool());
+		VolumeContainerFactory::RegisterOneFactory();
+
+		LOG4CXX_INFO(logger, "Using volume allocator (huge pages: " << cli_parser.get_huge_pages()
+		             << ", parallel first touch: " << cli_parser.get_parallel_first_touch()
+		             << ", buffer pool: " << cli_parser.get_buffer_pool() << ")");
+	}
+
+	if(!NoiseKernels::select(cli_parser.get_kernel())) {
+		LOG4CXX_FATAL(logger, "The \"" << cli_parser.get_kernel() << "\" noise kernels are not available on this machine.");
+		return -1;
+	}
+
+	LOG4CXX_INFO(logger, "Using " << NoiseKernels::get_selected() << " noise kernels");
+
+	if(std::find(rng_engines, rng_engines + rng_engines_count, cli_parser.get_rng_engine()) == rng_engines + rng_engines_count) {
+		LOG4CXX_FATAL(logger, "No \"" << cli_parser.get_rng_engine() << "\" random number engine found.");
+		return -1;
+	}
+
+	LOG4CXX_INFO(logger, "Using " << cli_parser.get_rng_engine() << " random number engine (seed: " << cli_parser.get_seed() << ")");
+
+	const std::vector< std::string > input_images = cli_parser.get_input_images();
+	const std::vector< std::string > output_images = cli_parser.get_output_images();
+	const std::vector< std::string > noise_outputs = cli_parser.get_noise_outputs();
+
+	if(cli_parser.get_estimate_noise()) {
+		for(size_t job = 0; job < input_images.size(); ++job)
+		{
+			timestamp_t t0 = get_timestamp();
+
+			ImageType::Pointer image;
+			try {
+				image = readInput(input_images[job], cli_parser, cli_parser.get_slice_range());
+			} catch (ImageReadingException & ex) {
+				LOG4CXX_FATAL(logger, "ITK is unable to read the image \"" << input_images[job] << "\" (" << ex.what() << ")");
+				exit(-1);
+			}
+
+			timestamp_t t1 = get_timestamp();
+			LOG4CXX_INFO(logger, "Image read in " << elapsed_time(t0, t1) << "s");
+
+			typedef itk::NoiseLevelEstimationImageFilter< ImageType > EstimationFilterType;
+			EstimationFilterType::Pointer estimationFilter = EstimationFilterType::New();
+			estimationFilter->SetInput(image);
+			try {
+				estimationFilter->Update();
+			} catch (itk::ExceptionObject & ex) {
+				LOG4CXX_FATAL(logger, "Unable to estimate the noise of \"" << input_images[job] << "\" (" << ex.what() << ")");
+				exit(-1);
+			}
+
+			timestamp_t t2 = get_timestamp();
+			LOG4CXX_INFO(logger, "Noise estimated in " << elapsed_time(t1, t2) << "s from "
+			             << estimationFilter->GetPixels() << " pixels");
+
+			// The suggested options, on stdout so that scripts can use them.
+			std::cout << input_images[job]
+			          << " --stddev " << estimationFilter->GetStandardDeviation()
+			          << " --probability " << estimationFilter->GetImpulseProbability() << std::endl;
+		}
+
+		return 0;
+	}
+
+	if((!cli_parser.get_slice_range().empty() || cli_parser.get_resume()) && needsWholeImage(cli_parser.get_noise_type())) {
+		LOG4CXX_FATAL(logger, "The \"" << cli_parser.get_noise_type() << "\" noise depends on the whole image and cannot be applied to a slice range.");
+		return -1;
+	}
+
+	ImageType::Pointer mask;
+	if(!cli_parser.get_mask_image().empty()) {
+		try {
+			mask = ImageReader::read(cli_parser.get_mask_image(), cli_parser.get_slice_range());
+		} catch (ImageReadingException & ex) {
+			LOG4CXX_FATAL(logger, "ITK is unable to read the mask \"" << cli_parser.get_mask_image() << "\" (" << ex.what() << ")");
+			exit(-1);
+		}
+	}
+
+	if(input_images.empty()) {
+		ImageType::Pointer geometry;
+		try {
+			geometry = createGeometry(cli_parser);
+		} catch (ImageReadingException & ex) {
+			LOG4CXX_FATAL(logger, "ITK is unable to read the reference \"" << cli_parser.get_reference_image() << "\" (" << ex.what() << ")");
+			exit(-1);
+		}
+
+		LOG4CXX_INFO(logger, "Generating images of size " << geometry->GetLargestPossibleRegion().GetSize()
+		             << " without input image");
+
+		for(size_t job = 0; job < output_images.size(); ++job)
+		{
+			timestamp_t t0 = get_timestamp();
+
+			SourcePointer noiseSource;
+			FilterPointer noiseFilter = createNoiseFilter(cli_parser.get_rng_engine(), cli_parser, geometry, mask, &noiseSource);
+			if(noiseFilter.IsNull()) {
+				LOG4CXX_FATAL(logger, "No \"" << cli_parser.get_noise_type() << "\" noise found.");
+				exit(-1);
+			}
+			if(noiseSource.IsNull()) {
+				LOG4CXX_FATAL(logger, "The \"" << cli_parser.get_noise_type() << "\" noise is not available without an input image.");
+				exit(-1);
+			}
+
+			// The writer pulls the image from the source, piece by piece when
+			// it streams, so the whole image is never generated before.
+			noiseSource->UpdateOutputInformation();
+			ImageWriter::write(noiseSource->GetOutput(), output_images[job], cli_parser.get_stream_divisions());
+
+			timestamp_t t1 = get_timestamp();
+			LOG4CXX_INFO(logger, "Noise generated and written in " << elapsed_time(t0, t1) << "s");
+		}
+	}
+
+	std::vector< StatisticsWriter::Entry > statistics_entries;
+
+	for(size_t job = 0; job < input_images.size(); ++job)
+	{
+		timestamp_t t0 = get_timestamp();
+
+		if(ImageStream::is_stream(input_images[job]) && ImageStream::is_stream(output_images[job])) {
+			itk::NoiseStatistics statistics;
+			try {
+				processStream(cli_parser, cli_parser.get_stats_json().empty() ? NULL : &statistics);
+			} catch (ImageStreamException & ex) {
+				LOG4CXX_FATAL(logger, "Unable to pipe the standard input to the standard output (" << ex.what() << ")");
+				exit(-1);
+			}
+
+			if(!cli_parser.get_stats_json().empty()) {
+				StatisticsWriter::Entry entry;
+				entry.input = input_images[job];
+				entry.output = output_images[job];
+				entry.statistics = statistics;
+				statistics_entries.push_back(entry);
+			}
+
+			timestamp_t t1 = get_timestamp();
+			LOG4CXX_INFO(logger, "Image piped in " << elapsed_time(t0, t1) << "s");
+			continue;
+		}
+
+		bool color = false;
+		try {
+			color = ImageReader::is_color(input_images[job]);
+		} catch (ImageReadingException & ex) {
+			LOG4CXX_FATAL(logger, "ITK is unable to read the image \"" << input_images[job] << "\" (" << ex.what() << ")");
+			exit(-1);
+		}
+
+		// The independent noise of a color image is applied to its interleaved
+		// components, which have neither the geometry nor the neighbours of its
+		// pixels.
+		const bool luminance = 0 == cli_parser.get_color_noise().compare("luminance");
+		if(color && !luminance && (needsWholeImage(cli_parser.get_noise_type()) || !cli_parser.get_roi().empty() || !noise_outputs.empty())) {
+			LOG4CXX_FATAL(logger, "The noises depending on the whole image, the region of interest and the noise field of the color image \""
+			              << input_images[job] << "\" need --color-noise luminance.");
+			exit(-1);
+		}
+
+		if(color && ImageStream::is_stream(output_images[job])) {
+			LOG4CXX_FATAL(logger, "The color image \"" << input_images[job] << "\" cannot be written on the standard output.");
+			exit(-1);
+		}
+
+		// The series outputs record their written slices in a journal, so that a
+		// resumed job only processes the following ones. It needs all the
+		// outputs to be series, a single file being rewritten whole.
+		std::vector< int > sliceRange = cli_parser.get_slice_range();
+		std::vector< std::string > journals(2);
+		if(ImageWriter::is_serie(output_images[job]))
+			journals[0] = SeriesJournal::filename(output_images[job], sliceRange);
+		if(!noise_outputs.empty() && ImageWriter::is_serie(noise_outputs[job]))
+			journals[1] = SeriesJournal::filename(noise_outputs[job], sliceRange);
+
+		const bool resumable = !journals[0].empty() && (noise_outputs.empty() || !journals[1].empty());
+
+		const std::string parameters = jobParameters(cli_parser, input_images[job]);
+
+		try {
+			if(cli_parser.get_resume() && resumable) {
+				for(size_t j = 0; j < journals.size(); ++j) {
+					if(!journals[j].empty() && !SeriesJournal::resume(journals[j], parameters)) {
+						LOG4CXX_FATAL(logger, "The journal \"" << journals[j] << "\" was written with other parameters, \""
+						              << output_images[job] << "\" cannot be resumed.");
+						exit(-1);
+					}
+				}
+
+				if(!resumeSliceRange(input_images[job], journals, sliceRange)) {
+					LOG4CXX_INFO(logger, "All the slices of \"" << output_images[job] << "\" are already written");
+					continue;
+				}
+
+				LOG4CXX_INFO(logger, "Resuming \"" << output_images[job] << "\" at slice " << sliceRange[0]);
+			} else {
+				for(size_t j = 0; j < journals.size(); ++j)
+					if(!journals[j].empty())
+						SeriesJournal::clear(journals[j], parameters);
+			}
+		} catch (ImageReadingException & ex) {
+			LOG4CXX_FATAL(logger, "ITK is unable to read the image \"" << input_images[job] << "\" (" << ex.what() << ")");
+			exit(-1);
+		} catch (SeriesJournalException & ex) {
+			LOG4CXX_FATAL(logger, "Unable to create the journal of \"" << output_images[job] << "\" (" << ex.what() << ")");
+			exit(-1);
+		}
+
+		// The noise filters process the scalar image, which is the color image
+		// itself for the independent noise.
+		ColorImageType::Pointer colorImage;
+		ImageType::Pointer image;
+		try {
+			if(color) {
+				colorImage = ImageReader::read_color(input_images[job], sliceRange);
+				image = luminance ? ColorNoise::luminance(colorImage) : ColorNoise::components(colorImage);
+			} else {
+				image = readInput(input_images[job], cli_parser, sliceRange);
+			}
+		} catch (ImageReadingException & ex) {
+			LOG4CXX_FATAL(logger, "ITK is unable to read the image \"" << input_images[job] << "\" (" << ex.what() << ")");
+			exit(-1);
+		}
+
+		ImageType::Pointer jobMask = mask;
+		if(color && !luminance && mask.IsNotNull())
+			jobMask = ColorNoise::expand_mask(mask);
+
+		if(jobMask.IsNotNull() && !maskMatches(jobMask, image)) {
+			LOG4CXX_FATAL(logger, "The mask \"" << cli_parser.get_mask_image() << "\" (index " << jobMask->GetBufferedRegion().GetIndex()
+			              << ", size " << jobMask->GetBufferedRegion().GetSize() << ") does not match the image \"" << input_images[job]
+			              << "\" (index " << image->GetBufferedRegion().GetIndex() << ", size " << image->GetBufferedRegion().GetSize() << ")");
+			exit(-1);
+		}
+
+		timestamp_t t1 = get_timestamp();
+		LOG4CXX_INFO(logger, "Image read in " << elapsed_time(t0, t1) << "s");
+
+		if(cli_parser.get_benchmark_engines()) {
+			for(size_t e = 0; e < rng_engines_count; ++e) {
+				FilterPointer benchmarkFilter = createNoiseFilter(rng_engines[e], cli_parser, image, jobMask);
+				if(benchmarkFilter.IsNull())
+					break;
+
+				timestamp_t b0 = get_timestamp();
+				benchmarkFilter->Update();
+				timestamp_t b1 = get_timestamp();
+				LOG4CXX_INFO(logger, "Noise generated with " << rng_engines[e] << " in " << elapsed_time(b0, b1) << "s");
+			}
+
+			t1 = get_timestamp();
+		}
+
+		const itk::NoiseStatistics *statistics = NULL;
+		FilterPointer noiseFilter = createNoiseFilter(cli_parser.get_rng_engine(), cli_parser, image, jobMask, NULL,
+		                                              cli_parser.get_stats_json().empty() ? NULL : &statistics);
+		if(noiseFilter.IsNull()) {
+			LOG4CXX_FATAL(logger, "No \"" << cli_parser.get_noise_type() << "\" noise found.");
+			exit(-1);
+		}
+
+		noiseFilter->Update();
+
+		ColorImageType::Pointer colorOutput;
+		itk::NoiseStatistics colorStatistics;
+		if(color && luminance) {
+			// The statistics of the luminance noise are the ones of the channels, and
+			// not of the luminance, except the corrupted pixels, whose channels all are.
+			colorOutput = ColorNoise::apply_luminance(colorImage, image, noiseFilter->GetOutput(), statistics ? &colorStatistics : NULL);
+			if(NULL != statistics) {
+				colorStatistics.m_Corrupted = statistics->m_Corrupted * ColorNoise::COMPONENTS;
+				statistics = &colorStatistics;
+			}
+		} else if(color) {
+			colorOutput = ColorNoise::from_components(noiseFilter->GetOutput(), colorImage);
+		}
+
+		if(NULL != statistics) {
+			StatisticsWriter::Entry entry;
+			entry.input = input_images[job];
+			entry.output = output_images[job];
+			entry.statistics = *statistics;
+			statistics_entries.push_back(entry);
+		}
+
+		timestamp_t t2 = get_timestamp();
+		LOG4CXX_DEBUG(logger, "Noise generated");
+		LOG4CXX_INFO(logger, "Noise generated in " << elapsed_time(t1, t2) << "s");
+
+		if(color)
+			ImageWriter::write(colorOutput, output_images[job], journals[0]);
+		else
+			ImageWriter::write(noiseFilter->GetOutput(), output_images[job], 1, journals[0]);
+
+		if(!noise_outputs.empty())
+			ImageWriter::write(getNoiseOutput(noiseFilter), noise_outputs[job], journals[1]);
+
+		timestamp_t t3 = get_timestamp();
+		LOG4CXX_INFO(logger, "Image written in " << elapsed_time(t2, t3) << "s");
+	}
+
+	if(!cli_parser.get_stats_json().empty()) {
+		try {
+			StatisticsWriter::write(statistics_entries, itk::NumericTraits< ImageType::PixelType >::max(), cli_parser.get_stats_json());
+		} catch (StatisticsWritingException & ex) {
+			LOG4CXX_FATAL(logger, "Unable to write the statistics (" << ex.what() << ")");
+			exit(-1);
+		}
+	}
+
+	if(BufferPool::is_enabled()) {
+		LOG4CXX_INFO(logger, "Buffer pool: " << BufferPool::get_hits() << " reused buffers, "
+		             << BufferPool::get_misses() << " allocated buffers");
+		BufferPool::clear();
+	}
 
 	return 0;
 }
@@ -0,0 +1,167 @@
+#include "noise_kernels.h"
+
+#include <cmath>
+
+#include "itkNoiseRandomEngines.h"
+
+#define NOISE_KERNELS_DECLARE_VARIANT(variant) \
+	namespace variant { \
+	void additive_uniform_u8(const uint8_t *in, uint8_t *out, float *noise, const size_t length, \
+	                         const int low, const unsigned int range, \
+	                         const uint8_t min, const uint8_t max, \
+	                         const NoiseKernels::RandomSource &source); \
+	void impulse_u8(const uint8_t *in, uint8_t *out, float *noise, const size_t length, \
+	                const uint32_t threshold, \
+	                const uint8_t min, const uint8_t max, \
+	                const NoiseKernels::RandomSource &source); \
+	void bernoulli_masks(const uint64_t *words, const size_t count, \
+	                     const uint32_t threshold, uint64_t *masks); \
+	void simplex_row(float *out, const size_t length, const size_t first, \
+	                 const float x, const float dx, const float y, const float z, \
+	                 const float amplitude, const uint32_t seed); \
+	}
+
+NOISE_KERNELS_DECLARE_VARIANT(noise_kernels_scalar)
+#ifdef NOISE_KERNELS_X86
+NOISE_KERNELS_DECLARE_VARIANT(noise_kernels_sse2)
+NOISE_KERNELS_DECLARE_VARIANT(noise_kernels_avx2)
+NOISE_KERNELS_DECLARE_VARIANT(noise_kernels_avx512)
+#endif
+
+namespace {
+
+bool always_supported()
+{
+	return true;
+}
+
+#ifdef NOISE_KERNELS_X86
+bool sse2_supported()
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2");
+}
+
+bool avx2_supported()
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+
+bool avx512_supported()
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx512f")
+	    && __builtin_cpu_supports("avx512bw")
+	    && __builtin_cpu_supports("avx512vl");
+}
+#endif
+
+// From the fastest to the slowest.
+const NoiseKernels::Variant variants[] = {
+#ifdef NOISE_KERNELS_X86
+	{ "avx512", avx512_supported, noise_kernels_avx512::additive_uniform_u8, noise_kernels_avx512::impulse_u8, noise_kernels_avx512::bernoulli_masks, noise_kernels_avx512::simplex_row },
+	{ "avx2",   avx2_supported,   noise_kernels_avx2::additive_uniform_u8,   noise_kernels_avx2::impulse_u8,   noise_kernels_avx2::bernoulli_masks,   noise_kernels_avx2::simplex_row },
+	{ "sse2",   sse2_supported,   noise_kernels_sse2::additive_uniform_u8,   noise_kernels_sse2::impulse_u8,   noise_kernels_sse2::bernoulli_masks,   noise_kernels_sse2::simplex_row },
+#endif
+	{ "scalar", always_supported, noise_kernels_scalar::additive_uniform_u8, noise_kernels_scalar::impulse_u8, noise_kernels_scalar::bernoulli_masks, noise_kernels_scalar::simplex_row },
+};
+
+const size_t variants_count = sizeof(variants) / sizeof(variants[0]);
+
+const NoiseKernels::Variant * find_variant(const std::string &name)
+{
+	for(size_t i = 0; i < variants_count; ++i)
+	{
+		if((name == "auto" || name == variants[i].name) && variants[i].supported())
+			return &variants[i];
+	}
+
+	return NULL;
+}
+
+void fill_words(void *engine, uint64_t *words, const size_t count)
+{
+	static_cast< NoiseKernels::EngineType * >(engine)->Fill(words, count);
+}
+
+NoiseKernels::RandomSource random_source(NoiseKernels::EngineType &engine)
+{
+	NoiseKernels::RandomSource source = { fill_words, &engine };
+	return source;
+}
+
+} // anonymous namespace
+
+const NoiseKernels::Variant *& NoiseKernels::selected()
+{
+	// The initialization of a local static is thread-safe, and the scalar
+	// variant is always supported.
+	static const Variant *variant = find_variant("auto");
+	return variant;
+}
+
+bool NoiseKernels::select(const std::string &name)
+{
+	const Variant *variant = find_variant(name);
+	if(NULL == variant)
+		return false;
+
+	selected() = variant;
+	return true;
+}
+
+const char * NoiseKernels::get_selected()
+{
+	return selected()->name;
+}
+
+std::vector< std::string > NoiseKernels::get_variants()
+{
+	std::vector< std::string > names;
+	for(size_t i = 0; i < variants_count; ++i)
+		names.push_back(variants[i].name);
+
+	return names;
+}
+
+void NoiseKernels::additive_uniform_u8(const uint8_t *in, uint8_t *out, float *noise, const size_t length,
+                                       const int low, const unsigned int range,
+                                       const uint8_t min, const uint8_t max,
+                                       EngineType &engine)
+{
+	selected()->additive_uniform_u8(in, out, noise, length, low, range, min, max, random_source(engine));
+}
+
+void NoiseKernels::impulse_u8(const uint8_t *in, uint8_t *out, float *noise, const size_t length,
+                              const uint32_t threshold,
+                              const uint8_t min, const uint8_t max,
+                              EngineType &engine)
+{
+	selected()->impulse_u8(in, out, noise, length, threshold, min, max, random_source(engine));
+}
+
+void NoiseKernels::bernoulli_masks(const uint64_t *words, const size_t count,
+                                   const uint32_t threshold, uint64_t *masks)
+{
+	selected()->bernoulli_masks(words, count, threshold, masks);
+}
+
+void NoiseKernels::simplex_row(float *out, const size_t length, const size_t first,
+                               const float x, const float dx, const float y, const float z,
+                               const float amplitude, const uint32_t seed)
+{
+	selected()->simplex_row(out, length, first, x, dx, y, z, amplitude, seed);
+}
+
+uint32_t NoiseKernels::impulse_threshold(const double probability)
+{
+	// P(r <= threshold) = (threshold + 1) / 2^32
+	double count = std::ceil(probability * 4294967296.0);
+	if(count < 1.0)
+		count = 1.0;
+	if(count > 4294967296.0)
+		count = 4294967296.0;
+
+	return static_cast< uint32_t >(count - 1.0);
+}
@@ -0,0 +1,150 @@
+#ifndef NOISE_KERNELS_H
+#define NOISE_KERNELS_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace itk
+{
+class Xoshiro256PlusPlusEngine;
+}
+
+/**
+ * Integer kernels for the noise of unsigned char images.
+ * They work on blocks of BLOCK_SIZE voxels, drawing the random words of a
+ * whole block at once, so that the SIMD and scalar implementations consume
+ * them identically and produce the same image.
+ *
+ * The simplex noise kernel evaluates as many points per iteration as its
+ * float registers hold. Its variants perform the same operations in the
+ * same order, and are compiled without contraction into fused
+ * multiply-adds, so they produce the same values too.
+ *
+ * The kernels are compiled for several instruction sets, the variant used
+ * is selected at run time according to the features of the CPU. The
+ * variants draw their random words through a RandomSource: the inline code
+ * of the engine is only compiled with the base flags, never in the files of
+ * an instruction set, whose copy could be the one kept by the linker.
+ */
+class NoiseKernels
+{
+public:
+	typedef itk::Xoshiro256PlusPlusEngine EngineType;
+
+	static const size_t BLOCK_SIZE = 16;
+
+	/**
+	 * Random words of a variant: fill(engine, words, count) draws count words
+	 * from the engine.
+	 */
+	struct RandomSource
+	{
+		void (*fill)(void *engine, uint64_t *words, const size_t count);
+		void *engine;
+	};
+
+	/**
+	 * Add uniform integer noise in [low; low + range[ and clamp to [min; max].
+	 * Matches AdditiveUniformNoise when its noise range bounds are integers,
+	 * since then floor(A + u) = A + floor(u).
+	 * @param[in] range The number of possible offsets, in [1; MAX_UNIFORM_RANGE].
+	 * @param[in] low The smallest offset, in [-MAX_UNIFORM_RANGE; MAX_UNIFORM_RANGE].
+	 * @param[out] noise When not NULL, receives the offset added to each
+	 * voxel, before clamping. The image is the same either way.
+	 */
+	static void additive_uniform_u8(const uint8_t *in, uint8_t *out, float *noise, const size_t length,
+	                                const int low, const unsigned int range,
+	                                const uint8_t min, const uint8_t max,
+	                                EngineType &engine);
+
+	/**
+	 * Replace voxels by min or max (with equal probability) with probability
+	 * (threshold + 1) / 2^32.
+	 * @param[out] noise When not NULL, receives 1 for the replaced voxels and
+	 * 0 for the others. The image is the same either way.
+	 */
+	static void impulse_u8(const uint8_t *in, uint8_t *out, float *noise, const size_t length,
+	                       const uint32_t threshold,
+	                       const uint8_t min, const uint8_t max,
+	                       EngineType &engine);
+
+	/**
+	 * Impulse threshold corresponding to a probability in ]0; 1].
+	 */
+	static uint32_t impulse_threshold(const double probability);
+
+	/**
+	 * Number of random words of a Bernoulli mask: 64 lanes of 32 bits.
+	 */
+	static const size_t BERNOULLI_MASK_WORDS = 32;
+
+	/**
+	 * Build count masks of 64 Bernoulli trials from count * BERNOULLI_MASK_WORDS
+	 * random words: bit i of a mask is set when its i-th 32 bit lane is lower
+	 * than threshold, that is with probability threshold / 2^32.
+	 */
+	static void bernoulli_masks(const uint64_t *words, const size_t count,
+	                            const uint32_t threshold, uint64_t *masks);
+
+	static const int MAX_UNIFORM_RANGE = 16384;
+
+	/**
+	 * Add amplitude times 3D simplex noise, evaluated at the points
+	 * (x + (first + i) * dx, y, z) for i in [0; length[, to out.
+	 * The noise is in [-1; 1]. The gradients of its lattice are hashed from
+	 * the lattice coordinates and seed, so any point can be evaluated
+	 * independently, and the value of a point only depends on first + i.
+	 * @param[in] first The index of the first point, lower than 2^31 - length.
+	 */
+	static void simplex_row(float *out, const size_t length, const size_t first,
+	                        const float x, const float dx, const float y, const float z,
+	                        const float amplitude, const uint32_t seed);
+
+	/**
+	 * Select the kernels variant.
+	 * @param[in] name "auto" for the fastest variant supported by the CPU, or one of get_variants().
+	 * @return false if the variant does not exist or is not supported by the CPU.
+	 */
+	static bool select(const std::string &name);
+
+	/**
+	 * Name of the selected variant, the fastest one supported by the CPU
+	 * unless select() was called.
+	 */
+	static const char * get_selected();
+
+	/**
+	 * Names of the compiled variants, from the fastest to the slowest.
+	 */
+	static std::vector< std::string > get_variants();
+
+	struct Variant
+	{
+		const char *name;
+		bool (*supported)();
+		void (*additive_uniform_u8)(const uint8_t *, uint8_t *, float *, const size_t,
+		                            const int, const unsigned int,
+		                            const uint8_t, const uint8_t,
+		                            const RandomSource &);
+		void (*impulse_u8)(const uint8_t *, uint8_t *, float *, const size_t,
+		                   const uint32_t,
+		                   const uint8_t, const uint8_t,
+		                   const RandomSource &);
+		void (*bernoulli_masks)(const uint64_t *, const size_t,
+		                        const uint32_t, uint64_t *);
+		void (*simplex_row)(float *, const size_t, const size_t,
+		                    const float, const float, const float, const float,
+		                    const float, const uint32_t);
+	};
+
+private:
+	/**
+	 * The selected variant. Selected once, at the first call, so that the
+	 * threads calling the kernels never select it concurrently.
+	 */
+	static const Variant *& selected();
+};
+
+#endif /* NOISE_KERNELS_H */
@@ -0,0 +1,5 @@
+// AVX2 variant of the noise kernels.
+#define NOISE_KERNELS_VARIANT noise_kernels_avx2
+#define NOISE_KERNELS_SIMD NOISE_KERNELS_AVX2
+
+#include "noise_kernels_impl.h"
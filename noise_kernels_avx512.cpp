@@ -0,0 +1,5 @@
+// AVX-512 (F, BW and VL) variant of the noise kernels.
+#define NOISE_KERNELS_VARIANT noise_kernels_avx512
+#define NOISE_KERNELS_SIMD NOISE_KERNELS_AVX512
+
+#include "noise_kernels_impl.h"
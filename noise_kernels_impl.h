@@ -0,0 +1,858 @@
+#ifndef NOISE_KERNELS_IMPL_H
+#define NOISE_KERNELS_IMPL_H
+
+/**
+ * Implementation of the noise kernels, compiled once per instruction set.
+ * Each variant source file defines NOISE_KERNELS_VARIANT (the namespace of
+ * its entry points) and NOISE_KERNELS_SIMD (the widest instruction set it
+ * may use) before including this file, and is compiled with the matching
+ * flags. Everything but the entry points has internal linkage, and no
+ * inline function of another header is used (the random words come from a
+ * NoiseKernels::RandomSource, floorf is the C function), so the variants
+ * never share code compiled for another instruction set.
+ *
+ * Whatever the instruction set, the random words of a block are consumed
+ * identically, so all the variants produce the same image.
+ */
+
+#include "noise_kernels.h"
+
+#include <cstring>
+#include <math.h>
+
+#define NOISE_KERNELS_SCALAR 0
+#define NOISE_KERNELS_SSE2   1
+#define NOISE_KERNELS_AVX2   2
+#define NOISE_KERNELS_AVX512 3
+
+#if NOISE_KERNELS_SIMD >= NOISE_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+#if NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX2
+#include <immintrin.h>
+#endif
+
+// The AVX-512 intrinsics of GCC start from _mm512_undefined_*(), which
+// initialize a register with itself and are reported as maybe uninitialized
+// once inlined.
+#if NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX512 && defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace {
+
+typedef NoiseKernels::RandomSource RandomSource;
+
+const size_t BLOCK_SIZE = NoiseKernels::BLOCK_SIZE;
+
+// 16 offsets of 16 bits.
+const size_t UNIFORM_WORDS = 4;
+
+// 16 thresholds of 32 bits, then 16 coins of 8 bits.
+const size_t IMPULSE_WORDS = 10;
+
+inline uint8_t clamp_u8(const int v, const int min, const int max)
+{
+	return static_cast< uint8_t >(v < min ? min : (v > max ? max : v));
+}
+
+/**
+ * One random word.
+ */
+inline uint64_t draw(const RandomSource &source)
+{
+	uint64_t word;
+	source.fill(source.engine, &word, 1);
+	return word;
+}
+
+/**
+ * Unbiased integer in [0; range[ (Lemire's multiply-shift with rejection).
+ */
+inline uint32_t bounded_draw(const uint32_t range, const RandomSource &source)
+{
+	uint64_t m = (draw(source) >> 32) * range;
+	uint32_t l = static_cast< uint32_t >(m);
+	if(l < range)
+	{
+		const uint32_t t = (0u - range) % range;
+		while(l < t)
+		{
+			m = (draw(source) >> 32) * range;
+			l = static_cast< uint32_t >(m);
+		}
+	}
+	return static_cast< uint32_t >(m >> 32);
+}
+
+/**
+ * Draw the offsets of a block from 16 bit random numbers. When one of them
+ * falls in the rejection zone of the multiply-shift, the whole block is
+ * drawn again with bounded_draw(), which keeps every offset unbiased.
+ */
+inline void uniform_block_scalar(const uint8_t *in, uint8_t *out, float *noise, const size_t count,
+                                 const uint64_t *words, const int low, const unsigned int range,
+                                 const unsigned int reject, const int min, const int max,
+                                 const RandomSource &source)
+{
+	uint32_t offsets[BLOCK_SIZE];
+	bool accepted = true;
+
+	for(size_t i = 0; i < BLOCK_SIZE; ++i)
+	{
+		const uint32_t m = static_cast< uint32_t >((words[i >> 2] >> (16 * (i & 3))) & 0xFFFF) * range;
+		offsets[i] = m >> 16;
+		accepted &= (m & 0xFFFF) >= reject;
+	}
+
+	if(!accepted)
+	{
+		for(size_t i = 0; i < BLOCK_SIZE; ++i)
+			offsets[i] = bounded_draw(range, source);
+	}
+
+	for(size_t i = 0; i < count; ++i)
+		out[i] = clamp_u8(in[i] + low + static_cast< int >(offsets[i]), min, max);
+
+	if(noise)
+	{
+		for(size_t i = 0; i < count; ++i)
+			noise[i] = static_cast< float >(low + static_cast< int >(offsets[i]));
+	}
+}
+
+/**
+ * Noise of a block of the SIMD variants whose offsets were all accepted.
+ */
+inline void uniform_block_noise(float *noise, const uint64_t *words, const int low, const unsigned int range)
+{
+	for(size_t i = 0; i < BLOCK_SIZE; ++i)
+	{
+		const uint32_t m = static_cast< uint32_t >((words[i >> 2] >> (16 * (i & 3))) & 0xFFFF) * range;
+		noise[i] = static_cast< float >(low + static_cast< int >(m >> 16));
+	}
+}
+
+/**
+ * Selection of the voxels of an impulse block: 1 for the replaced ones.
+ */
+inline void impulse_block_noise(float *noise, const size_t count, const uint64_t *words, const uint32_t threshold)
+{
+	for(size_t i = 0; i < count; ++i)
+	{
+		const uint32_t r = static_cast< uint32_t >(words[i >> 1] >> (32 * (i & 1)));
+		noise[i] = r <= threshold ? 1.0f : 0.0f;
+	}
+}
+
+inline void impulse_block_scalar(const uint8_t *in, uint8_t *out, const size_t count,
+                                 const uint64_t *words, const uint32_t threshold,
+                                 const uint8_t min, const uint8_t max)
+{
+	for(size_t i = 0; i < count; ++i)
+	{
+		const uint32_t r = static_cast< uint32_t >(words[i >> 1] >> (32 * (i & 1)));
+		const uint8_t coin = static_cast< uint8_t >(words[8 + (i >> 3)] >> (8 * (i & 7)));
+
+		out[i] = r <= threshold ? ((coin & 0x80) ? max : min) : in[i];
+	}
+}
+
+inline uint64_t bernoulli_mask_scalar(const uint64_t *words, const uint32_t threshold)
+{
+	uint64_t mask = 0;
+	for(size_t i = 0; i < 64; ++i)
+	{
+		const uint32_t r = static_cast< uint32_t >(words[i >> 1] >> (32 * (i & 1)));
+		mask |= static_cast< uint64_t >(r < threshold) << i;
+	}
+	return mask;
+}
+
+#if NOISE_KERNELS_SIMD >= NOISE_KERNELS_SSE2
+inline void uniform_block_sse2(const uint8_t *in, uint8_t *out, float *noise,
+                               const uint64_t *words, const int low, const unsigned int range,
+                               const unsigned int reject, const int min, const int max,
+                               const RandomSource &source)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i vrange = _mm_set1_epi16(static_cast< short >(range));
+	const __m128i vreject = _mm_set1_epi16(static_cast< short >(reject));
+
+	const __m128i r0 = _mm_loadu_si128(reinterpret_cast< const __m128i * >(words));
+	const __m128i r1 = _mm_loadu_si128(reinterpret_cast< const __m128i * >(words + 2));
+
+	// Low halves of the products below the rejection threshold
+	// (unsigned compare through saturated subtraction).
+	const __m128i rejected = _mm_or_si128(_mm_subs_epu16(vreject, _mm_mullo_epi16(r0, vrange)),
+	                                      _mm_subs_epu16(vreject, _mm_mullo_epi16(r1, vrange)));
+	if(_mm_movemask_epi8(_mm_cmpeq_epi16(rejected, zero)) != 0xFFFF)
+	{
+		uniform_block_scalar(in, out, noise, BLOCK_SIZE, words, low, range, reject, min, max, source);
+		return;
+	}
+
+	const __m128i vlow = _mm_set1_epi16(static_cast< short >(low));
+	const __m128i vmin = _mm_set1_epi16(static_cast< short >(min));
+	const __m128i vmax = _mm_set1_epi16(static_cast< short >(max));
+
+	const __m128i v = _mm_loadu_si128(reinterpret_cast< const __m128i * >(in));
+
+	// low + offset is in [-MAX_UNIFORM_RANGE; 2 MAX_UNIFORM_RANGE[, adding the
+	// voxel may exceed 32767: saturate, the clamp gives max anyway.
+	__m128i lo = _mm_adds_epi16(_mm_unpacklo_epi8(v, zero), _mm_add_epi16(_mm_mulhi_epu16(r0, vrange), vlow));
+	__m128i hi = _mm_adds_epi16(_mm_unpackhi_epi8(v, zero), _mm_add_epi16(_mm_mulhi_epu16(r1, vrange), vlow));
+
+	lo = _mm_min_epi16(_mm_max_epi16(lo, vmin), vmax);
+	hi = _mm_min_epi16(_mm_max_epi16(hi, vmin), vmax);
+
+	_mm_storeu_si128(reinterpret_cast< __m128i * >(out), _mm_packus_epi16(lo, hi));
+
+	if(noise)
+		uniform_block_noise(noise, words, low, range);
+}
+
+inline void impulse_block_sse2(const uint8_t *in, uint8_t *out,
+                               const uint64_t *words, const uint32_t threshold,
+                               const uint8_t min, const uint8_t max)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i sign = _mm_set1_epi32(static_cast< int >(0x80000000u));
+	const __m128i vthreshold = _mm_xor_si128(_mm_set1_epi32(static_cast< int >(threshold)), sign);
+
+	// Unsigned r > threshold through signed compares of biased values.
+	const __m128i k0 = _mm_cmpgt_epi32(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast< const __m128i * >(words)), sign), vthreshold);
+	const __m128i k1 = _mm_cmpgt_epi32(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast< const __m128i * >(words + 2)), sign), vthreshold);
+	const __m128i k2 = _mm_cmpgt_epi32(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast< const __m128i * >(words + 4)), sign), vthreshold);
+	const __m128i k3 = _mm_cmpgt_epi32(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast< const __m128i * >(words + 6)), sign), vthreshold);
+	const __m128i keep = _mm_packs_epi16(_mm_packs_epi32(k0, k1), _mm_packs_epi32(k2, k3));
+
+	const __m128i coins = _mm_loadu_si128(reinterpret_cast< const __m128i * >(words + 8));
+	const __m128i up = _mm_cmplt_epi8(coins, zero);
+	const __m128i impulse = _mm_or_si128(_mm_and_si128(up, _mm_set1_epi8(static_cast< char >(max))),
+	                                     _mm_andnot_si128(up, _mm_set1_epi8(static_cast< char >(min))));
+
+	const __m128i v = _mm_loadu_si128(reinterpret_cast< const __m128i * >(in));
+
+	_mm_storeu_si128(reinterpret_cast< __m128i * >(out),
+	                 _mm_or_si128(_mm_and_si128(keep, v), _mm_andnot_si128(keep, impulse)));
+}
+
+inline uint64_t bernoulli_mask_sse2(const uint64_t *words, const uint32_t threshold)
+{
+	const __m128i sign = _mm_set1_epi32(static_cast< int >(0x80000000u));
+	const __m128i vthreshold = _mm_xor_si128(_mm_set1_epi32(static_cast< int >(threshold)), sign);
+
+	uint64_t mask = 0;
+	for(size_t i = 0; i < 16; ++i)
+	{
+		const __m128i r = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast< const __m128i * >(words + 2 * i)), sign);
+		const int bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(vthreshold, r)));
+		mask |= static_cast< uint64_t >(bits) << (4 * i);
+	}
+	return mask;
+}
+#endif
+
+#if NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX2
+inline void uniform_block_avx2(const uint8_t *in, uint8_t *out, float *noise,
+                               const uint64_t *words, const int low, const unsigned int range,
+                               const unsigned int reject, const int min, const int max,
+                               const RandomSource &source)
+{
+	// The 16 offsets of the block fit in a single register.
+	const __m256i r = _mm256_loadu_si256(reinterpret_cast< const __m256i * >(words));
+	const __m256i vrange = _mm256_set1_epi16(static_cast< short >(range));
+
+	const __m256i rejected = _mm256_subs_epu16(_mm256_set1_epi16(static_cast< short >(reject)),
+	                                           _mm256_mullo_epi16(r, vrange));
+	if(!_mm256_testz_si256(rejected, rejected))
+	{
+		uniform_block_scalar(in, out, noise, BLOCK_SIZE, words, low, range, reject, min, max, source);
+		return;
+	}
+
+	__m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast< const __m128i * >(in)));
+	v = _mm256_adds_epi16(v, _mm256_add_epi16(_mm256_mulhi_epu16(r, vrange),
+	                                          _mm256_set1_epi16(static_cast< short >(low))));
+	v = _mm256_min_epi16(_mm256_max_epi16(v, _mm256_set1_epi16(static_cast< short >(min))),
+	                     _mm256_set1_epi16(static_cast< short >(max)));
+
+	_mm_storeu_si128(reinterpret_cast< __m128i * >(out),
+	                 _mm_packus_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+
+	if(noise)
+		uniform_block_noise(noise, words, low, range);
+}
+
+inline void impulse_block_avx2(const uint8_t *in, uint8_t *out,
+                               const uint64_t *words, const uint32_t threshold,
+                               const uint8_t min, const uint8_t max)
+{
+	const __m256i sign = _mm256_set1_epi32(static_cast< int >(0x80000000u));
+	const __m256i vthreshold = _mm256_xor_si256(_mm256_set1_epi32(static_cast< int >(threshold)), sign);
+
+	const __m256i k0 = _mm256_cmpgt_epi32(_mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast< const __m256i * >(words)), sign), vthreshold);
+	const __m256i k1 = _mm256_cmpgt_epi32(_mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast< const __m256i * >(words + 4)), sign), vthreshold);
+
+	// packs works within 128 bit lanes: restore the voxel order.
+	const __m256i k = _mm256_permute4x64_epi64(_mm256_packs_epi32(k0, k1), 0xD8);
+	const __m128i keep = _mm_packs_epi16(_mm256_castsi256_si128(k), _mm256_extracti128_si256(k, 1));
+
+	const __m128i coins = _mm_loadu_si128(reinterpret_cast< const __m128i * >(words + 8));
+	const __m128i up = _mm_cmplt_epi8(coins, _mm_setzero_si128());
+	const __m128i impulse = _mm_or_si128(_mm_and_si128(up, _mm_set1_epi8(static_cast< char >(max))),
+	                                     _mm_andnot_si128(up, _mm_set1_epi8(static_cast< char >(min))));
+
+	const __m128i v = _mm_loadu_si128(reinterpret_cast< const __m128i * >(in));
+
+	_mm_storeu_si128(reinterpret_cast< __m128i * >(out),
+	                 _mm_or_si128(_mm_and_si128(keep, v), _mm_andnot_si128(keep, impulse)));
+}
+
+inline uint64_t bernoulli_mask_avx2(const uint64_t *words, const uint32_t threshold)
+{
+	const __m256i sign = _mm256_set1_epi32(static_cast< int >(0x80000000u));
+	const __m256i vthreshold = _mm256_xor_si256(_mm256_set1_epi32(static_cast< int >(threshold)), sign);
+
+	uint64_t mask = 0;
+	for(size_t i = 0; i < 8; ++i)
+	{
+		const __m256i r = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast< const __m256i * >(words + 4 * i)), sign);
+		const int bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(vthreshold, r)));
+		mask |= static_cast< uint64_t >(bits) << (8 * i);
+	}
+	return mask;
+}
+#endif
+
+#if NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX512
+inline void uniform_block_avx512(const uint8_t *in, uint8_t *out, float *noise,
+                                 const uint64_t *words, const int low, const unsigned int range,
+                                 const unsigned int reject, const int min, const int max,
+                                 const RandomSource &source)
+{
+	const __m256i r = _mm256_loadu_si256(reinterpret_cast< const __m256i * >(words));
+	const __m256i vrange = _mm256_set1_epi16(static_cast< short >(range));
+
+	if(_mm256_cmplt_epu16_mask(_mm256_mullo_epi16(r, vrange), _mm256_set1_epi16(static_cast< short >(reject))))
+	{
+		uniform_block_scalar(in, out, noise, BLOCK_SIZE, words, low, range, reject, min, max, source);
+		return;
+	}
+
+	__m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast< const __m128i * >(in)));
+	v = _mm256_adds_epi16(v, _mm256_add_epi16(_mm256_mulhi_epu16(r, vrange),
+	                                          _mm256_set1_epi16(static_cast< short >(low))));
+	v = _mm256_min_epi16(_mm256_max_epi16(v, _mm256_set1_epi16(static_cast< short >(min))),
+	                     _mm256_set1_epi16(static_cast< short >(max)));
+
+	_mm_storeu_si128(reinterpret_cast< __m128i * >(out),
+	                 _mm_packus_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+
+	if(noise)
+		uniform_block_noise(noise, words, low, range);
+}
+
+inline void impulse_block_avx512(const uint8_t *in, uint8_t *out,
+                                 const uint64_t *words, const uint32_t threshold,
+                                 const uint8_t min, const uint8_t max)
+{
+	const __mmask16 hit = _mm512_cmple_epu32_mask(_mm512_loadu_si512(words),
+	                                              _mm512_set1_epi32(static_cast< int >(threshold)));
+	const __mmask16 up = _mm_movepi8_mask(_mm_loadu_si128(reinterpret_cast< const __m128i * >(words + 8)));
+
+	const __m128i impulse = _mm_mask_blend_epi8(up, _mm_set1_epi8(static_cast< char >(min)),
+	                                            _mm_set1_epi8(static_cast< char >(max)));
+	const __m128i v = _mm_loadu_si128(reinterpret_cast< const __m128i * >(in));
+
+	_mm_storeu_si128(reinterpret_cast< __m128i * >(out), _mm_mask_blend_epi8(hit, v, impulse));
+}
+
+inline uint64_t bernoulli_mask_avx512(const uint64_t *words, const uint32_t threshold)
+{
+	const __m512i vthreshold = _mm512_set1_epi32(static_cast< int >(threshold));
+
+	uint64_t mask = 0;
+	for(size_t i = 0; i < 4; ++i)
+		mask |= static_cast< uint64_t >(_mm512_cmplt_epu32_mask(_mm512_loadu_si512(words + 8 * i), vthreshold)) << (16 * i);
+	return mask;
+}
+#endif
+
+inline void uniform_block(const uint8_t *in, uint8_t *out, float *noise,
+                          const uint64_t *words, const int low, const unsigned int range,
+                          const unsigned int reject, const int min, const int max,
+                          const RandomSource &source)
+{
+#if NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX512
+	uniform_block_avx512(in, out, noise, words, low, range, reject, min, max, source);
+#elif NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX2
+	uniform_block_avx2(in, out, noise, words, low, range, reject, min, max, source);
+#elif NOISE_KERNELS_SIMD >= NOISE_KERNELS_SSE2
+	uniform_block_sse2(in, out, noise, words, low, range, reject, min, max, source);
+#else
+	uniform_block_scalar(in, out, noise, BLOCK_SIZE, words, low, range, reject, min, max, source);
+#endif
+}
+
+inline void impulse_block(const uint8_t *in, uint8_t *out,
+                          const uint64_t *words, const uint32_t threshold,
+                          const uint8_t min, const uint8_t max)
+{
+#if NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX512
+	impulse_block_avx512(in, out, words, threshold, min, max);
+#elif NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX2
+	impulse_block_avx2(in, out, words, threshold, min, max);
+#elif NOISE_KERNELS_SIMD >= NOISE_KERNELS_SSE2
+	impulse_block_sse2(in, out, words, threshold, min, max);
+#else
+	impulse_block_scalar(in, out, BLOCK_SIZE, words, threshold, min, max);
+#endif
+}
+
+inline uint64_t bernoulli_mask(const uint64_t *words, const uint32_t threshold)
+{
+#if NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX512
+	return bernoulli_mask_avx512(words, threshold);
+#elif NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX2
+	return bernoulli_mask_avx2(words, threshold);
+#elif NOISE_KERNELS_SIMD >= NOISE_KERNELS_SSE2
+	return bernoulli_mask_sse2(words, threshold);
+#else
+	return bernoulli_mask_scalar(words, threshold);
+#endif
+}
+
+/**
+ * Lanes of the simplex noise kernel: the operations it needs on vectors of
+ * floats, of 32 bit integers, and of comparison results. The kernel is
+ * written once for all the instruction sets on top of them.
+ */
+struct SimplexScalar
+{
+	static const size_t WIDTH = 1;
+
+	typedef float    Float;
+	typedef uint32_t Int;
+	typedef bool     Mask;
+
+	static Float set1(const float v) { return v; }
+	static Float iota(const size_t first) { return static_cast< float >(static_cast< int32_t >(first)); }
+	static Float load(const float *p) { return *p; }
+	static void store(float *p, const Float v) { *p = v; }
+	static Float add(const Float a, const Float b) { return a + b; }
+	static Float sub(const Float a, const Float b) { return a - b; }
+	static Float mul(const Float a, const Float b) { return a * b; }
+	static Float max(const Float a, const Float b) { return a > b ? a : b; }
+	static Float floor(const Float a) { return floorf(a); }
+	static Float select(const Mask m, const Float a, const Float b) { return m ? a : b; }
+	static Float flip_sign(const Float a, const Int sign)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &a, sizeof(bits));
+		bits ^= sign & 0x80000000u;
+		Float r;
+		std::memcpy(&r, &bits, sizeof(r));
+		return r;
+	}
+
+	static Int to_int(const Float a) { return static_cast< uint32_t >(static_cast< int32_t >(a)); }
+	static Int iset1(const uint32_t v) { return v; }
+	static Int iadd(const Int a, const Int b) { return a + b; }
+	static Int imul(const Int a, const Int b) { return a * b; }
+	static Int ixor(const Int a, const Int b) { return a ^ b; }
+	static Int iand(const Int a, const Int b) { return a & b; }
+	template< int N > static Int srl(const Int a) { return a >> N; }
+	template< int N > static Int sll(const Int a) { return a << N; }
+	static Int masked(const Mask m, const Int a) { return m ? a : 0; }
+
+	static Mask ge(const Float a, const Float b) { return a >= b; }
+	static Mask ieq(const Int a, const Int b) { return a == b; }
+	static Mask m_and(const Mask a, const Mask b) { return a && b; }
+	static Mask m_or(const Mask a, const Mask b) { return a || b; }
+	static Mask m_not(const Mask a) { return !a; }
+};
+
+#if NOISE_KERNELS_SIMD >= NOISE_KERNELS_SSE2
+struct SimplexSse2
+{
+	static const size_t WIDTH = 4;
+
+	typedef __m128  Float;
+	typedef __m128i Int;
+	typedef __m128  Mask;
+
+	static Float set1(const float v) { return _mm_set1_ps(v); }
+	static Float iota(const size_t first)
+	{
+		return _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(static_cast< int >(first)), _mm_setr_epi32(0, 1, 2, 3)));
+	}
+	static Float load(const float *p) { return _mm_loadu_ps(p); }
+	static void store(float *p, const Float v) { _mm_storeu_ps(p, v); }
+	static Float add(const Float a, const Float b) { return _mm_add_ps(a, b); }
+	static Float sub(const Float a, const Float b) { return _mm_sub_ps(a, b); }
+	static Float mul(const Float a, const Float b) { return _mm_mul_ps(a, b); }
+	static Float max(const Float a, const Float b) { return _mm_max_ps(a, b); }
+	static Float floor(const Float a)
+	{
+		// Truncate, then step down where that rounded up.
+		const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+		return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+	}
+	static Float select(const Mask m, const Float a, const Float b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+	static Float flip_sign(const Float a, const Int sign)
+	{
+		return _mm_xor_ps(a, _mm_castsi128_ps(_mm_and_si128(sign, _mm_set1_epi32(static_cast< int >(0x80000000u)))));
+	}
+
+	static Int to_int(const Float a) { return _mm_cvttps_epi32(a); }
+	static Int iset1(const uint32_t v) { return _mm_set1_epi32(static_cast< int >(v)); }
+	static Int iadd(const Int a, const Int b) { return _mm_add_epi32(a, b); }
+	static Int imul(const Int a, const Int b)
+	{
+		// No 32 bit multiplication before SSE4.1: multiply the even and
+		// odd lanes to 64 bits and gather the low halves.
+		const __m128i even = _mm_mul_epu32(a, b);
+		const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+		                          _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+	static Int ixor(const Int a, const Int b) { return _mm_xor_si128(a, b); }
+	static Int iand(const Int a, const Int b) { return _mm_and_si128(a, b); }
+	template< int N > static Int srl(const Int a) { return _mm_srli_epi32(a, N); }
+	template< int N > static Int sll(const Int a) { return _mm_slli_epi32(a, N); }
+	static Int masked(const Mask m, const Int a) { return _mm_and_si128(_mm_castps_si128(m), a); }
+
+	static Mask ge(const Float a, const Float b) { return _mm_cmpge_ps(a, b); }
+	static Mask ieq(const Int a, const Int b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+	static Mask m_and(const Mask a, const Mask b) { return _mm_and_ps(a, b); }
+	static Mask m_or(const Mask a, const Mask b) { return _mm_or_ps(a, b); }
+	static Mask m_not(const Mask a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+};
+#endif
+
+#if NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX2
+struct SimplexAvx2
+{
+	static const size_t WIDTH = 8;
+
+	typedef __m256  Float;
+	typedef __m256i Int;
+	typedef __m256  Mask;
+
+	static Float set1(const float v) { return _mm256_set1_ps(v); }
+	static Float iota(const size_t first)
+	{
+		return _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(static_cast< int >(first)),
+		                                           _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+	}
+	static Float load(const float *p) { return _mm256_loadu_ps(p); }
+	static void store(float *p, const Float v) { _mm256_storeu_ps(p, v); }
+	static Float add(const Float a, const Float b) { return _mm256_add_ps(a, b); }
+	static Float sub(const Float a, const Float b) { return _mm256_sub_ps(a, b); }
+	static Float mul(const Float a, const Float b) { return _mm256_mul_ps(a, b); }
+	static Float max(const Float a, const Float b) { return _mm256_max_ps(a, b); }
+	static Float floor(const Float a) { return _mm256_floor_ps(a); }
+	static Float select(const Mask m, const Float a, const Float b) { return _mm256_blendv_ps(b, a, m); }
+	static Float flip_sign(const Float a, const Int sign)
+	{
+		return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_and_si256(sign, _mm256_set1_epi32(static_cast< int >(0x80000000u)))));
+	}
+
+	static Int to_int(const Float a) { return _mm256_cvttps_epi32(a); }
+	static Int iset1(const uint32_t v) { return _mm256_set1_epi32(static_cast< int >(v)); }
+	static Int iadd(const Int a, const Int b) { return _mm256_add_epi32(a, b); }
+	static Int imul(const Int a, const Int b) { return _mm256_mullo_epi32(a, b); }
+	static Int ixor(const Int a, const Int b) { return _mm256_xor_si256(a, b); }
+	static Int iand(const Int a, const Int b) { return _mm256_and_si256(a, b); }
+	template< int N > static Int srl(const Int a) { return _mm256_srli_epi32(a, N); }
+	template< int N > static Int sll(const Int a) { return _mm256_slli_epi32(a, N); }
+	static Int masked(const Mask m, const Int a) { return _mm256_and_si256(_mm256_castps_si256(m), a); }
+
+	static Mask ge(const Float a, const Float b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static Mask ieq(const Int a, const Int b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+	static Mask m_and(const Mask a, const Mask b) { return _mm256_and_ps(a, b); }
+	static Mask m_or(const Mask a, const Mask b) { return _mm256_or_ps(a, b); }
+	static Mask m_not(const Mask a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+};
+#endif
+
+#if NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX512
+struct SimplexAvx512
+{
+	static const size_t WIDTH = 16;
+
+	typedef __m512    Float;
+	typedef __m512i   Int;
+	typedef __mmask16 Mask;
+
+	static Float set1(const float v) { return _mm512_set1_ps(v); }
+	static Float iota(const size_t first)
+	{
+		return _mm512_cvtepi32_ps(_mm512_add_epi32(_mm512_set1_epi32(static_cast< int >(first)),
+		                                           _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)));
+	}
+	static Float load(const float *p) { return _mm512_loadu_ps(p); }
+	static void store(float *p, const Float v) { _mm512_storeu_ps(p, v); }
+	static Float add(const Float a, const Float b) { return _mm512_add_ps(a, b); }
+	static Float sub(const Float a, const Float b) { return _mm512_sub_ps(a, b); }
+	static Float mul(const Float a, const Float b) { return _mm512_mul_ps(a, b); }
+	static Float max(const Float a, const Float b) { return _mm512_max_ps(a, b); }
+	static Float floor(const Float a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+	static Float select(const Mask m, const Float a, const Float b) { return _mm512_mask_blend_ps(m, b, a); }
+	static Float flip_sign(const Float a, const Int sign)
+	{
+		// The float logical instructions need AVX512DQ.
+		return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a),
+		                                            _mm512_and_si512(sign, _mm512_set1_epi32(static_cast< int >(0x80000000u)))));
+	}
+
+	static Int to_int(const Float a) { return _mm512_cvttps_epi32(a); }
+	static Int iset1(const uint32_t v) { return _mm512_set1_epi32(static_cast< int >(v)); }
+	static Int iadd(const Int a, const Int b) { return _mm512_add_epi32(a, b); }
+	static Int imul(const Int a, const Int b) { return _mm512_mullo_epi32(a, b); }
+	static Int ixor(const Int a, const Int b) { return _mm512_xor_si512(a, b); }
+	static Int iand(const Int a, const Int b) { return _mm512_and_si512(a, b); }
+	template< int N > static Int srl(const Int a) { return _mm512_srli_epi32(a, N); }
+	template< int N > static Int sll(const Int a) { return _mm512_slli_epi32(a, N); }
+	static Int masked(const Mask m, const Int a) { return _mm512_maskz_mov_epi32(m, a); }
+
+	static Mask ge(const Float a, const Float b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+	static Mask ieq(const Int a, const Int b) { return _mm512_cmpeq_epi32_mask(a, b); }
+	static Mask m_and(const Mask a, const Mask b) { return static_cast< Mask >(a & b); }
+	static Mask m_or(const Mask a, const Mask b) { return static_cast< Mask >(a | b); }
+	static Mask m_not(const Mask a) { return static_cast< Mask >(~a); }
+};
+#endif
+
+#if NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX512
+typedef SimplexAvx512 SimplexLanes;
+#elif NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX2
+typedef SimplexAvx2 SimplexLanes;
+#elif NOISE_KERNELS_SIMD >= NOISE_KERNELS_SSE2
+typedef SimplexSse2 SimplexLanes;
+#else
+typedef SimplexScalar SimplexLanes;
+#endif
+
+/**
+ * Hash of a lattice point, from the xor of its coordinates multiplied by
+ * odd constants and the seed (finalizer of lowbias32).
+ */
+template< class L >
+inline typename L::Int simplex_hash(typename L::Int h)
+{
+	h = L::ixor(h, L::template srl< 16 >(h));
+	h = L::imul(h, L::iset1(0x7feb352du));
+	h = L::ixor(h, L::template srl< 15 >(h));
+	h = L::imul(h, L::iset1(0x846ca68bu));
+	return L::ixor(h, L::template srl< 16 >(h));
+}
+
+/**
+ * Contribution of a corner of the simplex, at offset (x, y, z) from the
+ * point, whose gradient is one of the 12 edge gradients of Perlin's
+ * improved noise (4 of them twice), chosen by the low bits of hash.
+ */
+template< class L >
+inline typename L::Float simplex_corner(const typename L::Float x, const typename L::Float y,
+                                        const typename L::Float z, const typename L::Int hash)
+{
+	typedef typename L::Float Float;
+	typedef typename L::Int Int;
+
+	Float t = L::sub(L::sub(L::sub(L::set1(0.6f), L::mul(x, x)), L::mul(y, y)), L::mul(z, z));
+	t = L::max(t, L::set1(0.0f));
+	t = L::mul(t, t);
+	t = L::mul(t, t);
+
+	const Int zero = L::iset1(0);
+	const Float u = L::select(L::ieq(L::iand(hash, L::iset1(8)), zero), x, y);
+	const Float v = L::select(L::ieq(L::iand(hash, L::iset1(12)), zero), y,
+	                          L::select(L::ieq(L::iand(hash, L::iset1(13)), L::iset1(12)), x, z));
+	const Float g = L::add(L::flip_sign(u, L::template sll< 31 >(hash)),
+	                       L::flip_sign(v, L::template sll< 30 >(hash)));
+	return L::mul(t, g);
+}
+
+/**
+ * Simplex noise of L::WIDTH consecutive points, added to out
+ * (Gustavson's formulation, with the simplex order found without branches).
+ */
+template< class L >
+inline void simplex_lanes(float *out, const size_t first,
+                          const float x, const float dx, const float y, const float z,
+                          const float amplitude, const uint32_t seed)
+{
+	typedef typename L::Float Float;
+	typedef typename L::Int Int;
+	typedef typename L::Mask Mask;
+
+	const float F3 = 1.0f / 3.0f;
+	const float G3 = 1.0f / 6.0f;
+
+	const Float px = L::add(L::set1(x), L::mul(L::iota(first), L::set1(dx)));
+	const Float py = L::set1(y);
+	const Float pz = L::set1(z);
+
+	// Skew to the cubic lattice, and unskew the cell origin.
+	const Float s = L::mul(L::add(L::add(px, py), pz), L::set1(F3));
+	const Float fi = L::floor(L::add(px, s));
+	const Float fj = L::floor(L::add(py, s));
+	const Float fk = L::floor(L::add(pz, s));
+	const Float t = L::mul(L::add(L::add(fi, fj), fk), L::set1(G3));
+
+	const Float x0 = L::sub(px, L::sub(fi, t));
+	const Float y0 = L::sub(py, L::sub(fj, t));
+	const Float z0 = L::sub(pz, L::sub(fk, t));
+
+	// Second and third corners, from the order of the coordinates.
+	const Mask xy = L::ge(x0, y0);
+	const Mask yz = L::ge(y0, z0);
+	const Mask xz = L::ge(x0, z0);
+
+	const Mask i1 = L::m_and(xy, xz);
+	const Mask j1 = L::m_and(L::m_not(xy), yz);
+	const Mask k1 = L::m_not(L::m_or(xz, yz));
+	const Mask i2 = L::m_or(xy, xz);
+	const Mask j2 = L::m_or(L::m_not(xy), yz);
+	const Mask k2 = L::m_not(L::m_and(xz, yz));
+
+	const Float one = L::set1(1.0f);
+	const Float zero = L::set1(0.0f);
+
+	const Float x1 = L::add(L::sub(x0, L::select(i1, one, zero)), L::set1(G3));
+	const Float y1 = L::add(L::sub(y0, L::select(j1, one, zero)), L::set1(G3));
+	const Float z1 = L::add(L::sub(z0, L::select(k1, one, zero)), L::set1(G3));
+	const Float x2 = L::add(L::sub(x0, L::select(i2, one, zero)), L::set1(2.0f * G3));
+	const Float y2 = L::add(L::sub(y0, L::select(j2, one, zero)), L::set1(2.0f * G3));
+	const Float z2 = L::add(L::sub(z0, L::select(k2, one, zero)), L::set1(2.0f * G3));
+	const Float x3 = L::add(L::sub(x0, one), L::set1(3.0f * G3));
+	const Float y3 = L::add(L::sub(y0, one), L::set1(3.0f * G3));
+	const Float z3 = L::add(L::sub(z0, one), L::set1(3.0f * G3));
+
+	// Hashes of the corners: (i + a) * P = i * P + (a ? P : 0).
+	const Int ph = L::iset1(0x8da6b343u);
+	const Int pj = L::iset1(0xd8163841u);
+	const Int pk = L::iset1(0xcb1ab31fu);
+	const Int vseed = L::iset1(seed);
+
+	const Int hi = L::imul(L::to_int(fi), ph);
+	const Int hj = L::imul(L::to_int(fj), pj);
+	const Int hk = L::imul(L::to_int(fk), pk);
+
+	const Int h0 = L::ixor(L::ixor(hi, hj), L::ixor(hk, vseed));
+	const Int h1 = L::ixor(L::ixor(L::iadd(hi, L::masked(i1, ph)), L::iadd(hj, L::masked(j1, pj))),
+	                       L::ixor(L::iadd(hk, L::masked(k1, pk)), vseed));
+	const Int h2 = L::ixor(L::ixor(L::iadd(hi, L::masked(i2, ph)), L::iadd(hj, L::masked(j2, pj))),
+	                       L::ixor(L::iadd(hk, L::masked(k2, pk)), vseed));
+	const Int h3 = L::ixor(L::ixor(L::iadd(hi, ph), L::iadd(hj, pj)),
+	                       L::ixor(L::iadd(hk, pk), vseed));
+
+	const Float n = L::add(L::add(simplex_corner< L >(x0, y0, z0, simplex_hash< L >(h0)),
+	                              simplex_corner< L >(x1, y1, z1, simplex_hash< L >(h1))),
+	                       L::add(simplex_corner< L >(x2, y2, z2, simplex_hash< L >(h2)),
+	                              simplex_corner< L >(x3, y3, z3, simplex_hash< L >(h3))));
+
+	// 32 scales the sum to [-1; 1].
+	L::store(out, L::add(L::load(out), L::mul(L::set1(amplitude), L::mul(n, L::set1(32.0f)))));
+}
+
+// Impulse blocks never redraw, so the words of several blocks can be drawn
+// at once: 32 voxels per iteration, 64 with AVX-512.
+#if NOISE_KERNELS_SIMD >= NOISE_KERNELS_AVX512
+const size_t IMPULSE_BLOCKS = 4;
+#elif NOISE_KERNELS_SIMD >= NOISE_KERNELS_SSE2
+const size_t IMPULSE_BLOCKS = 2;
+#else
+const size_t IMPULSE_BLOCKS = 1;
+#endif
+
+} // anonymous namespace
+
+namespace NOISE_KERNELS_VARIANT {
+
+void additive_uniform_u8(const uint8_t *in, uint8_t *out, float *noise, const size_t length,
+                         const int low, const unsigned int range,
+                         const uint8_t min, const uint8_t max,
+                         const RandomSource &source)
+{
+	const unsigned int reject = 65536u % range;
+
+	uint64_t words[UNIFORM_WORDS];
+
+	// Uniform blocks may redraw, hence one block at a time to keep the
+	// order of the random words.
+	size_t i = 0;
+	for(; i + BLOCK_SIZE <= length; i += BLOCK_SIZE)
+	{
+		source.fill(source.engine, words, UNIFORM_WORDS);
+		uniform_block(in + i, out + i, noise ? noise + i : NULL, words, low, range, reject, min, max, source);
+	}
+
+	if(i < length)
+	{
+		source.fill(source.engine, words, UNIFORM_WORDS);
+		uniform_block_scalar(in + i, out + i, noise ? noise + i : NULL, length - i, words, low, range, reject, min, max, source);
+	}
+}
+
+void impulse_u8(const uint8_t *in, uint8_t *out, float *noise, const size_t length,
+                const uint32_t threshold,
+                const uint8_t min, const uint8_t max,
+                const RandomSource &source)
+{
+	uint64_t words[IMPULSE_BLOCKS * IMPULSE_WORDS];
+
+	size_t i = 0;
+	for(; i + IMPULSE_BLOCKS * BLOCK_SIZE <= length; i += IMPULSE_BLOCKS * BLOCK_SIZE)
+	{
+		source.fill(source.engine, words, IMPULSE_BLOCKS * IMPULSE_WORDS);
+		for(size_t b = 0; b < IMPULSE_BLOCKS; ++b)
+			impulse_block(in + i + b * BLOCK_SIZE, out + i + b * BLOCK_SIZE, words + b * IMPULSE_WORDS, threshold, min, max);
+
+		if(noise)
+		{
+			for(size_t b = 0; b < IMPULSE_BLOCKS; ++b)
+				impulse_block_noise(noise + i + b * BLOCK_SIZE, BLOCK_SIZE, words + b * IMPULSE_WORDS, threshold);
+		}
+	}
+
+	for(; i < length; i += BLOCK_SIZE)
+	{
+		const size_t count = i + BLOCK_SIZE <= length ? BLOCK_SIZE : length - i;
+
+		source.fill(source.engine, words, IMPULSE_WORDS);
+		if(BLOCK_SIZE == count)
+			impulse_block(in + i, out + i, words, threshold, min, max);
+		else
+			impulse_block_scalar(in + i, out + i, count, words, threshold, min, max);
+
+		if(noise)
+			impulse_block_noise(noise + i, count, words, threshold);
+	}
+}
+
+void bernoulli_masks(const uint64_t *words, const size_t count,
+                     const uint32_t threshold, uint64_t *masks)
+{
+	for(size_t i = 0; i < count; ++i)
+		masks[i] = bernoulli_mask(words + i * NoiseKernels::BERNOULLI_MASK_WORDS, threshold);
+}
+
+void simplex_row(float *out, const size_t length, const size_t first,
+                 const float x, const float dx, const float y, const float z,
+                 const float amplitude, const uint32_t seed)
+{
+	size_t i = 0;
+	for(; i + SimplexLanes::WIDTH <= length; i += SimplexLanes::WIDTH)
+		simplex_lanes< SimplexLanes >(out + i, first + i, x, dx, y, z, amplitude, seed);
+
+	for(; i < length; ++i)
+		simplex_lanes< SimplexScalar >(out + i, first + i, x, dx, y, z, amplitude, seed);
+}
+
+} // namespace NOISE_KERNELS_VARIANT
+
+#endif /* NOISE_KERNELS_IMPL_H */
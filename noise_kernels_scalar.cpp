@@ -0,0 +1,5 @@
+// Portable variant of the noise kernels.
+#define NOISE_KERNELS_VARIANT noise_kernels_scalar
+#define NOISE_KERNELS_SIMD NOISE_KERNELS_SCALAR
+
+#include "noise_kernels_impl.h"
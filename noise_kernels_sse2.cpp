@@ -0,0 +1,5 @@
+// SSE2 variant of the noise kernels.
+#define NOISE_KERNELS_VARIANT noise_kernels_sse2
+#define NOISE_KERNELS_SIMD NOISE_KERNELS_SSE2
+
+#include "noise_kernels_impl.h"
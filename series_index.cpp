@@ -0,0 +1,318 @@
+#include "series_index.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+
+#include <sys/stat.h>
+
+#include <boost/filesystem.hpp>
+
+#include "log4cxx/logger.h"
+
+const char * const SeriesIndex::INDEX_FILE = ".series_index";
+
+namespace {
+
+const char * const INDEX_VERSION = "series-index 2";
+
+bool entry_less(const SeriesIndex::Entry &a, const SeriesIndex::Entry &b)
+{
+	return SeriesIndex::natural_less(a.name, b.name);
+}
+
+/**
+ * Modification time of a file or directory, in nanoseconds since the epoch:
+ * the seconds of last_write_time() miss the changes within a second.
+ */
+boost::int64_t modification_time(const boost::filesystem::path &path, boost::system::error_code &error)
+{
+	struct stat status;
+	if(::stat(path.string().c_str(), &status) != 0) {
+		error = boost::system::error_code(errno, boost::system::system_category());
+		return 0;
+	}
+
+	error.clear();
+	return static_cast< boost::int64_t >(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+}
+
+/**
+ * Number of entries of a directory, listed without reading their status.
+ */
+boost::uintmax_t count_entries(const boost::filesystem::path &directory, boost::system::error_code &error)
+{
+	boost::uintmax_t count = 0;
+
+	boost::filesystem::directory_iterator end_iter;
+	for(boost::filesystem::directory_iterator dir_iter(directory, error); !error && dir_iter != end_iter; dir_iter.increment(error))
+		++count;
+
+	return count;
+}
+
+/**
+ * Whether an image of the index is unchanged.
+ */
+bool is_unchanged(const boost::filesystem::path &directory, const SeriesIndex::Entry &entry)
+{
+	const boost::filesystem::path path = directory / entry.name;
+
+	boost::system::error_code error;
+	const boost::uintmax_t size = boost::filesystem::file_size(path, error);
+	if(error)
+		return false;
+
+	const boost::int64_t modified = modification_time(path, error);
+	return !error && size == entry.size && modified == entry.modified;
+}
+
+}
+
+std::vector< SeriesIndex::Entry > SeriesIndex::load(const std::string directory, ImageType::Pointer &geometry)
+{
+	log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("main"));
+
+	std::vector< Entry > entries;
+	if(read(directory, entries, geometry)) {
+		LOG4CXX_DEBUG(logger, "Using the index of the " << entries.size() << " images of \"" << directory << "\"");
+		return entries;
+	}
+
+	LOG4CXX_DEBUG(logger, "Indexing the images of \"" << directory << "\"");
+
+	entries = scan(directory);
+	geometry = ImageType::Pointer();
+	write(directory, entries, NULL);
+
+	return entries;
+}
+
+void SeriesIndex::store_geometry(const std::string directory, const std::vector< Entry > &entries, const itk::ImageBase< __ImageDimension > *image)
+{
+	write(directory, entries, image);
+}
+
+bool SeriesIndex::natural_less(const std::string &a, const std::string &b)
+{
+	size_t i = 0, j = 0;
+	while(i < a.size() && j < b.size())
+	{
+		if(std::isdigit(static_cast< unsigned char >(a[i])) && std::isdigit(static_cast< unsigned char >(b[j]))) {
+			// Compare the numbers without their leading zeros: the longer one is
+			// the greater, else the first different digit decides.
+			while(i < a.size() && a[i] == '0')
+				++i;
+			while(j < b.size() && b[j] == '0')
+				++j;
+
+			size_t ei = i, ej = j;
+			while(ei < a.size() && std::isdigit(static_cast< unsigned char >(a[ei])))
+				++ei;
+			while(ej < b.size() && std::isdigit(static_cast< unsigned char >(b[ej])))
+				++ej;
+
+			if(ei - i != ej - j)
+				return ei - i < ej - j;
+
+			const int c = a.compare(i, ei - i, b, j, ej - j);
+			if(c != 0)
+				return c < 0;
+
+			i = ei;
+			j = ej;
+		} else {
+			if(a[i] != b[j])
+				return a[i] < b[j];
+
+			++i;
+			++j;
+		}
+	}
+
+	if(a.size() - i != b.size() - j)
+		return a.size() - i < b.size() - j;
+
+	return a < b;
+}
+
+bool SeriesIndex::is_image(const std::string &filename)
+{
+	const size_t dot = filename.rfind('.');
+	if(std::string::npos == dot)
+		return false;
+
+	std::string extension = filename.substr(dot + 1);
+	if(extension.size() < 3 || extension.size() > 4)
+		return false;
+
+	for(size_t c = 0; c < extension.size(); ++c)
+		extension[c] = std::tolower(static_cast< unsigned char >(extension[c]));
+
+	return extension == "png" || extension == "bmp" || extension == "jpg" || extension == "jpeg";
+}
+
+std::vector< SeriesIndex::Entry > SeriesIndex::scan(const std::string directory)
+{
+	std::vector< Entry > entries;
+
+	boost::filesystem::directory_iterator end_iter;
+	for(boost::filesystem::directory_iterator dir_iter(directory); dir_iter != end_iter; ++dir_iter)
+	{
+		const std::string name = dir_iter->path().filename().string();
+		if(!is_image(name))
+			continue;
+
+		Entry entry;
+		entry.name = name;
+		entry.size = boost::filesystem::file_size(dir_iter->path());
+
+		boost::system::error_code error;
+		entry.modified = modification_time(dir_iter->path(), error);
+		if(error)
+			throw boost::filesystem::filesystem_error("Cannot read the modification time", dir_iter->path(), error);
+
+		entries.push_back(entry);
+	}
+
+	std::sort(entries.begin(), entries.end(), entry_less);
+
+	return entries;
+}
+
+bool SeriesIndex::read(const std::string directory, std::vector< Entry > &entries, ImageType::Pointer &geometry)
+{
+	const boost::filesystem::path path(directory);
+
+	std::ifstream file((path / INDEX_FILE).string().c_str());
+	if(!file)
+		return false;
+
+	std::string line;
+	if(!std::getline(file, line) || line != INDEX_VERSION)
+		return false;
+
+	boost::system::error_code error;
+	const boost::int64_t modified = modification_time(path, error);
+	if(error)
+		return false;
+
+	const boost::uintmax_t count = count_entries(path, error);
+	if(error)
+		return false;
+
+	entries.clear();
+	geometry = ImageType::Pointer();
+
+	bool complete = false;
+	while(!complete && std::getline(file, line))
+	{
+		std::istringstream ss(line);
+		std::string record;
+		ss >> record;
+
+		if(record == "directory") {
+			boost::int64_t indexed;
+			boost::uintmax_t indexedCount;
+			if(!(ss >> indexed >> indexedCount) || indexed != modified || indexedCount != count)
+				return false;
+		} else if(record == "geometry") {
+			ImageType::SizeType size;
+			ImageType::SpacingType spacing;
+			ImageType::PointType origin;
+			for(unsigned int d = 0; d < __ImageDimension; ++d)
+				ss >> size[d];
+			for(unsigned int d = 0; d < __ImageDimension; ++d)
+				ss >> spacing[d];
+			for(unsigned int d = 0; d < __ImageDimension; ++d)
+				ss >> origin[d];
+			if(!ss)
+				return false;
+
+			ImageType::RegionType region;
+			region.SetSize(size);
+
+			geometry = ImageType::New();
+			geometry->SetRegions(region);
+			geometry->SetSpacing(spacing);
+			geometry->SetOrigin(origin);
+		} else if(record == "file") {
+			// The name is the end of the line, and may contain spaces.
+			Entry entry;
+			if(!(ss >> entry.size >> entry.modified))
+				return false;
+			ss.get();
+			std::getline(ss, entry.name);
+			entries.push_back(entry);
+		} else if(record == "end") {
+			complete = true;
+		} else {
+			return false;
+		}
+	}
+
+	if(!complete)
+		return false;
+
+	// The files of the directory were not added, removed or renamed; check that
+	// the first and last images were not rewritten either.
+	if(!entries.empty() && (!is_unchanged(path, entries.front()) || !is_unchanged(path, entries.back())))
+		return false;
+
+	return true;
+}
+
+void SeriesIndex::write(const std::string directory, const std::vector< Entry > &entries, const itk::ImageBase< __ImageDimension > *geometry)
+{
+	log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("main"));
+
+	const boost::filesystem::path path(directory);
+	const std::string filename = (path / INDEX_FILE).string();
+
+	// Creating the file modifies the directory, so it is created before the
+	// modification time and the entries of the directory are read, then
+	// rewritten in place.
+	{
+		std::ofstream file(filename.c_str(), std::ios::out | std::ios::app);
+		if(!file) {
+			LOG4CXX_DEBUG(logger, "Unable to cache the index of \"" << directory << "\"");
+			return;
+		}
+	}
+
+	boost::system::error_code error;
+	const boost::int64_t modified = modification_time(path, error);
+	if(error)
+		return;
+
+	const boost::uintmax_t count = count_entries(path, error);
+	if(error)
+		return;
+
+	std::ofstream file(filename.c_str(), std::ios::out | std::ios::trunc);
+	file << INDEX_VERSION << std::endl;
+	file << "directory " << modified << " " << count << std::endl;
+
+	if(NULL != geometry) {
+		const ImageType::SizeType size = geometry->GetLargestPossibleRegion().GetSize();
+		file.precision(17);
+		file << "geometry";
+		for(unsigned int d = 0; d < __ImageDimension; ++d)
+			file << " " << size[d];
+		for(unsigned int d = 0; d < __ImageDimension; ++d)
+			file << " " << geometry->GetSpacing()[d];
+		for(unsigned int d = 0; d < __ImageDimension; ++d)
+			file << " " << geometry->GetOrigin()[d];
+		file << std::endl;
+	}
+
+	for(size_t e = 0; e < entries.size(); ++e)
+		file << "file " << entries[e].size << " " << entries[e].modified << " " << entries[e].name << std::endl;
+
+	file << "end" << std::endl;
+
+	if(!file)
+		LOG4CXX_DEBUG(logger, "Unable to cache the index of \"" << directory << "\"");
+}
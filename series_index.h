@@ -0,0 +1,86 @@
+#ifndef SERIES_INDEX_H
+#define SERIES_INDEX_H
+
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "common.h"
+
+/**
+ * Index of the images of a serie in a directory, sorted in natural order
+ * ("slice2" before "slice10"), with the geometry of the serie once read.
+ *
+ * Scanning a directory of tens of thousands of files is slow on network file
+ * systems, so the index is cached in the directory (INDEX_FILE) and reused as
+ * long as the directory and its first and last images have not been modified
+ * since. Adding, removing or renaming a file modifies the directory, whose
+ * modification time is compared to the nanosecond with its number of entries,
+ * so that the changes within the second of the index are detected too.
+ */
+class SeriesIndex
+{
+public:
+	struct Entry
+	{
+		std::string      name;
+		boost::uintmax_t size;
+		// Modification time, in nanoseconds since the epoch.
+		boost::int64_t   modified;
+	};
+
+	/**
+	 * Name of the cache file in the directory.
+	 */
+	static const char * const INDEX_FILE;
+
+	/**
+	 * Get the index of a directory, from its cache when it is valid, by
+	 * scanning the directory and caching the result otherwise.
+	 * @param[in] directory The directory of the serie.
+	 * @param[out] geometry The cached geometry of the serie, an empty pointer
+	 * when it is unknown.
+	 * @return The images of the serie, in natural order.
+	 */
+	static std::vector< Entry > load(const std::string directory, ImageType::Pointer &geometry);
+
+	/**
+	 * Cache the geometry of a serie, read from its images, with its index.
+	 * @param[in] directory The directory of the serie.
+	 * @param[in] entries The index given by load().
+	 * @param[in] image The serie, of any pixel type, whose pixels are not
+	 * needed.
+	 */
+	static void store_geometry(const std::string directory, const std::vector< Entry > &entries, const itk::ImageBase< __ImageDimension > *image);
+
+	/**
+	 * Compare two file names, the runs of digits by their numeric value.
+	 */
+	static bool natural_less(const std::string &a, const std::string &b);
+
+private:
+	/**
+	 * Whether a file name has the extension of a supported image format.
+	 */
+	static bool is_image(const std::string &filename);
+
+	/**
+	 * List the images of a directory.
+	 */
+	static std::vector< Entry > scan(const std::string directory);
+
+	/**
+	 * Read a cache file.
+	 * @return false if it is missing, incomplete or outdated.
+	 */
+	static bool read(const std::string directory, std::vector< Entry > &entries, ImageType::Pointer &geometry);
+
+	/**
+	 * Write a cache file. Failures are ignored, the cache being optional (e.g.
+	 * in a read-only directory).
+	 */
+	static void write(const std::string directory, const std::vector< Entry > &entries, const itk::ImageBase< __ImageDimension > *geometry);
+};
+
+#endif /* SERIES_INDEX_H */
@@ -0,0 +1,82 @@
+#include "series_journal.h"
+
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ParseUtils.h"
+
+const char *SeriesJournal::PARAMETERS = "parameters ";
+
+std::string SeriesJournal::filename(const std::string serie, const std::vector< int > &sliceRange)
+{
+	std::stringstream journal;
+	journal << serie;
+	if(!sliceRange.empty())
+		journal << "." << sliceRange[0] << "-" << sliceRange[1];
+	journal << ".journal";
+
+	return journal.str();
+}
+
+std::set< int > SeriesJournal::read(const std::string journal)
+{
+	std::set< int > indices;
+
+	std::ifstream file(journal.c_str());
+	std::string line;
+	while(std::getline(file, line))
+	{
+		// A line cut by a crash has no end of line, and is ignored.
+		if(file.eof())
+			break;
+
+		int index;
+		if(ParseUtils::ParseInt(index, line.c_str(), 10))
+			indices.insert(index);
+	}
+
+	return indices;
+}
+
+void SeriesJournal::clear(const std::string journal, const std::string parameters)
+{
+	std::ofstream file(journal.c_str(), std::ios::out | std::ios::trunc);
+	file << PARAMETERS << parameters << std::endl;
+	if(!file)
+		throw SeriesJournalException("Cannot create " + journal);
+}
+
+bool SeriesJournal::resume(const std::string journal, const std::string parameters)
+{
+	std::ifstream file(journal.c_str());
+	if(!file) {
+		clear(journal, parameters);
+		return true;
+	}
+
+	// The journals without parameters are never resumed.
+	std::string line;
+	std::getline(file, line);
+	return !file.eof() && 0 == line.compare(PARAMETERS + parameters);
+}
+
+void SeriesJournal::append(const std::string journal, const int index, const std::string filename)
+{
+	// The file is written by ITK, and has to be reopened to be synchronized.
+	const int descriptor = ::open(filename.c_str(), O_RDONLY);
+	if(descriptor < 0)
+		throw SeriesJournalException("Cannot open " + filename);
+
+	const int synchronized = ::fsync(descriptor);
+	::close(descriptor);
+	if(synchronized != 0)
+		throw SeriesJournalException("Cannot synchronize " + filename);
+
+	std::ofstream file(journal.c_str(), std::ios::out | std::ios::app);
+	file << index << std::endl;
+	if(!file)
+		throw SeriesJournalException("Cannot write in " + journal);
+}
@@ -0,0 +1,75 @@
+#ifndef SERIES_JOURNAL_H
+#define SERIES_JOURNAL_H
+
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class SeriesJournalException : public std::runtime_error
+{
+public:
+	SeriesJournalException ( const std::string &err ) : std::runtime_error (err) {}
+};
+
+
+/**
+ * Records the slices of a serie of files already written, one index per line,
+ * so that an interrupted job can be resumed after the last written slice.
+ * A line is appended and flushed once its file is written and synchronized to
+ * the disk, so a crash leaves at worst the last slice unrecorded, and written
+ * again.
+ *
+ * The first line records the parameters of the job, so that a serie is not
+ * resumed with other parameters than the ones of its first slices.
+ */
+class SeriesJournal
+{
+public:
+	/**
+	 * File name of the journal of a serie.
+	 * @param[in] serie The file name with placeholder of the serie.
+	 * @param[in] sliceRange The slices written by the job, all of them when
+	 * empty: each shard of a volume has its own journal.
+	 */
+	static std::string filename(const std::string serie, const std::vector< int > &sliceRange);
+
+	/**
+	 * Read the indices recorded in a journal, none if it does not exist.
+	 */
+	static std::set< int > read(const std::string journal);
+
+	/**
+	 * Empty a journal, before writing a serie from its start.
+	 * @param[in] journal The file name of the journal.
+	 * @param[in] parameters The parameters of the job, on a single line.
+	 */
+	static void clear(const std::string journal, const std::string parameters);
+
+	/**
+	 * Prepare a journal to resume its serie, creating it when it does not
+	 * exist.
+	 * @param[in] journal The file name of the journal.
+	 * @param[in] parameters The parameters of the job, on a single line.
+	 * @return false if the journal records other parameters, in which case it
+	 * is left untouched.
+	 */
+	static bool resume(const std::string journal, const std::string parameters);
+
+	/**
+	 * Record that a slice was written, once its file is on the disk.
+	 * @param[in] journal The file name of the journal.
+	 * @param[in] index The index of the slice.
+	 * @param[in] filename The file of the slice, synchronized to the disk
+	 * before it is recorded.
+	 */
+	static void append(const std::string journal, const int index, const std::string filename);
+
+private:
+	/**
+	 * Prefix of the first line of a journal, followed by the parameters.
+	 */
+	static const char *PARAMETERS;
+};
+
+#endif /* SERIES_JOURNAL_H */
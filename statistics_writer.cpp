@@ -0,0 +1,78 @@
+#include "statistics_writer.h"
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include "log4cxx/logger.h"
+
+void StatisticsWriter::write(const std::vector< Entry > &entries, const double peak, const std::string filename)
+{
+	log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("main"));
+
+	LOG4CXX_DEBUG(logger, "Writing statistics in \"" << filename << "\"");
+
+	std::ofstream file(filename.c_str());
+	if(!file)
+		throw StatisticsWritingException("Cannot open " + filename);
+
+	file << "[" << std::endl;
+	for(size_t e = 0; e < entries.size(); ++e) {
+		const itk::NoiseStatistics &statistics = entries[e].statistics;
+
+		const double pixels = static_cast< double >(statistics.m_Pixels);
+		const double mse = pixels > 0 ? statistics.m_SquaredError / pixels : 0.0;
+		const double psnr = 10.0 * std::log10(peak * peak / mse);
+		const double snr = 10.0 * std::log10(statistics.m_SignalEnergy / statistics.m_SquaredError);
+
+		file << "\t{" << std::endl
+		     << "\t\t\"input\": " << quote(entries[e].input) << "," << std::endl
+		     << "\t\t\"output\": " << quote(entries[e].output) << "," << std::endl
+		     << "\t\t\"pixels\": " << statistics.m_Pixels << "," << std::endl
+		     << "\t\t\"squared_error\": " << number(statistics.m_SquaredError) << "," << std::endl
+		     << "\t\t\"signal_energy\": " << number(statistics.m_SignalEnergy) << "," << std::endl
+		     << "\t\t\"mse\": " << number(mse) << "," << std::endl
+		     << "\t\t\"psnr\": " << number(psnr) << "," << std::endl
+		     << "\t\t\"snr\": " << number(snr) << "," << std::endl
+		     << "\t\t\"saturated_minimum\": " << statistics.m_AtMinimum << "," << std::endl
+		     << "\t\t\"saturated_maximum\": " << statistics.m_AtMaximum << "," << std::endl
+		     << "\t\t\"corrupted\": " << statistics.m_Corrupted << std::endl
+		     << "\t}" << (e + 1 < entries.size() ? "," : "") << std::endl;
+	}
+	file << "]" << std::endl;
+
+	if(!file)
+		throw StatisticsWritingException("Cannot write " + filename);
+}
+
+std::string StatisticsWriter::quote(const std::string &s)
+{
+	std::string quoted = "\"";
+	for(size_t i = 0; i < s.size(); ++i) {
+		const unsigned char c = s[i];
+		if(c == '"' || c == '\\') {
+			quoted += '\\';
+			quoted += c;
+		} else if(c < 0x20) {
+			std::ostringstream escaped;
+			escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast< unsigned int >(c);
+			quoted += escaped.str();
+		} else {
+			quoted += c;
+		}
+	}
+	return quoted + "\"";
+}
+
+std::string StatisticsWriter::number(const double value)
+{
+	if(value != value || value == std::numeric_limits< double >::infinity() || value == -std::numeric_limits< double >::infinity())
+		return "null";
+
+	std::ostringstream ss;
+	ss.precision(std::numeric_limits< double >::digits10 + 2);
+	ss << value;
+	return ss.str();
+}
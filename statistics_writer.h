@@ -0,0 +1,51 @@
+#ifndef STATISTICS_WRITER_H
+#define STATISTICS_WRITER_H
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "itkNoiseStatistics.h"
+
+class StatisticsWritingException : public std::runtime_error
+{
+public:
+	StatisticsWritingException ( const std::string &err ) : std::runtime_error (err) {}
+};
+
+
+class StatisticsWriter
+{
+public:
+	/**
+	 * Statistics of a processed image.
+	 */
+	struct Entry
+	{
+		std::string input;
+		std::string output;
+		itk::NoiseStatistics statistics;
+	};
+
+	/**
+	 * Write the statistics of the processed images as a JSON array, with the
+	 * MSE, PSNR and SNR (in dB) derived from the sums.
+	 * @param[in] entries The statistics of the images.
+	 * @param[in] peak The peak signal value used for the PSNR.
+	 * @param[in] filename The file in which to write the statistics.
+	 */
+	static void write(const std::vector< Entry > &entries, const double peak, const std::string filename);
+
+private:
+	/**
+	 * Quote and escape a string for JSON.
+	 */
+	static std::string quote(const std::string &s);
+
+	/**
+	 * Format a number for JSON, null if it is not finite.
+	 */
+	static std::string number(const double value);
+};
+
+#endif /* STATISTICS_WRITER_H */
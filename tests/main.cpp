@@ -0,0 +1,3 @@
+// Entry point of the unit tests, the test cases are in the other files.
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
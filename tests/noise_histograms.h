@@ -0,0 +1,69 @@
+#ifndef NOISE_HISTOGRAMS_H
+#define NOISE_HISTOGRAMS_H
+
+#include <cmath>
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Histograms of unsigned char images, and their comparison by a chi-square
+ * test, to check that two ways of generating a noise draw it from the same
+ * distribution.
+ */
+class NoiseHistograms
+{
+public:
+	typedef std::vector< size_t > Histogram;
+
+	static Histogram histogram(const std::vector< uint8_t > &image)
+	{
+		Histogram h(256, 0);
+		for(size_t i = 0; i < image.size(); ++i)
+			++h[image[i]];
+
+		return h;
+	}
+
+	/**
+	 * Two samples chi-square statistic of histograms with the same number of
+	 * values. The bins empty in both are not counted in the degrees of
+	 * freedom.
+	 */
+	static double chi_square(const Histogram &a, const Histogram &b, unsigned int &degrees)
+	{
+		double chi2 = 0.0;
+		unsigned int bins = 0;
+		for(size_t i = 0; i < a.size(); ++i)
+		{
+			const double n = static_cast< double >(a[i]) + static_cast< double >(b[i]);
+			if(n == 0.0)
+				continue;
+
+			const double d = static_cast< double >(a[i]) - static_cast< double >(b[i]);
+			chi2 += d * d / n;
+			++bins;
+		}
+
+		degrees = bins > 1 ? bins - 1 : 0;
+		return chi2;
+	}
+
+	/**
+	 * Whether histograms agree: their chi-square statistic is below its mean
+	 * plus 5 standard deviations. The seeds of the tests are fixed, so this
+	 * only fails when the distributions differ.
+	 */
+	static bool agree(const Histogram &a, const Histogram &b)
+	{
+		unsigned int degrees;
+		const double chi2 = chi_square(a, b, degrees);
+
+		if(0 == degrees)
+			return a == b;
+
+		return chi2 <= degrees + 5.0 * std::sqrt(2.0 * degrees);
+	}
+};
+
+#endif /* NOISE_HISTOGRAMS_H */
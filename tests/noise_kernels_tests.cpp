@@ -0,0 +1,294 @@
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+#include "itkAdditiveUniformNoiseImageFilter.h"
+#include "itkImpulseNoiseImageFilter.h"
+#include "noise_kernels.h"
+
+#include "noise_histograms.h"
+
+namespace {
+
+const uint64_t SEED = 1234;
+
+// Not a multiple of the blocks, so that the scalar tails run too.
+const size_t LENGTH = 4099;
+
+// Number of voxels of the histograms.
+const size_t SAMPLES = 200000;
+
+struct UniformCase
+{
+	double mean;
+	double amplitude;
+	uint8_t min;
+	uint8_t max;
+};
+
+// The last ones are at the limits of the ranges accepted by the kernel.
+const UniformCase UNIFORM_CASES[] = {
+	{ 0.0, 5.0, 0, 255 },
+	{ 0.5, 0.5, 0, 255 },
+	{ 3.0, 40.0, 20, 230 },
+	{ 0.0, 200.0, 0, 255 },
+	{ 0.0, NoiseKernels::MAX_UNIFORM_RANGE / 2, 0, 255 },
+	{ NoiseKernels::MAX_UNIFORM_RANGE / 2, NoiseKernels::MAX_UNIFORM_RANGE / 2, 0, 255 },
+	{ -NoiseKernels::MAX_UNIFORM_RANGE / 2, NoiseKernels::MAX_UNIFORM_RANGE / 2, 0, 255 },
+	{ NoiseKernels::MAX_UNIFORM_RANGE * 1.5, NoiseKernels::MAX_UNIFORM_RANGE / 2, 0, 255 },
+	{ NoiseKernels::MAX_UNIFORM_RANGE - 0.5, 0.5, 0, 255 },
+	{ -NoiseKernels::MAX_UNIFORM_RANGE + 0.5, 0.5, 0, 255 },
+};
+
+const double IMPULSE_PROBABILITIES[] = { 1e-3, 0.05, 0.5, 0.999, 1.0 };
+
+std::vector< uint8_t > ramp(const size_t length)
+{
+	std::vector< uint8_t > image(length);
+	for(size_t i = 0; i < length; ++i)
+		image[i] = static_cast< uint8_t >(i * 37);
+
+	return image;
+}
+
+std::vector< uint8_t > uniform_kernel(const std::vector< uint8_t > &in, const UniformCase &c, std::vector< float > *noise = NULL)
+{
+	NoiseKernels::EngineType engine;
+	engine.Seed(SEED, 0);
+
+	if(noise)
+		noise->assign(in.size(), 0.0f);
+
+	std::vector< uint8_t > out(in.size());
+	NoiseKernels::additive_uniform_u8(&in[0], &out[0], noise ? &(*noise)[0] : NULL, in.size(),
+	                                  static_cast< int >(c.mean - c.amplitude), static_cast< unsigned int >(2.0 * c.amplitude),
+	                                  c.min, c.max, engine);
+	return out;
+}
+
+std::vector< uint8_t > uniform_functor(const std::vector< uint8_t > &in, const UniformCase &c)
+{
+	itk::Functor::AdditiveUniformNoise< uint8_t, uint8_t > functor;
+	functor.SetMean(c.mean);
+	functor.SetAmplitude(c.amplitude);
+	functor.SetOutputBounds(c.min, c.max);
+
+	NoiseKernels::EngineType engine;
+	engine.Seed(SEED, 1);
+
+	std::vector< uint8_t > out(in.size());
+	for(size_t i = 0; i < in.size(); ++i)
+		out[i] = functor.Evaluate< 0 >(in[i], engine);
+
+	return out;
+}
+
+std::vector< uint8_t > impulse_kernel(const std::vector< uint8_t > &in, const double probability, const uint8_t min, const uint8_t max,
+                                      std::vector< float > *noise = NULL)
+{
+	NoiseKernels::EngineType engine;
+	engine.Seed(SEED, 0);
+
+	if(noise)
+		noise->assign(in.size(), 0.0f);
+
+	std::vector< uint8_t > out(in.size());
+	NoiseKernels::impulse_u8(&in[0], &out[0], noise ? &(*noise)[0] : NULL, in.size(),
+	                         NoiseKernels::impulse_threshold(probability), min, max, engine);
+
+	return out;
+}
+
+std::vector< uint8_t > impulse_functor(const std::vector< uint8_t > &in, const double probability, const uint8_t min, const uint8_t max)
+{
+	itk::Functor::ImpulseNoise< uint8_t, uint8_t > functor;
+	functor.SetProbability(probability);
+	functor.SetOutputBounds(min, max);
+
+	NoiseKernels::EngineType engine;
+	engine.Seed(SEED, 1);
+
+	std::vector< uint8_t > out(in.size());
+	for(size_t i = 0; i < in.size(); ++i)
+		out[i] = functor.Evaluate< 0 >(in[i], engine);
+
+	return out;
+}
+
+/**
+ * Number of voxels which differ between images of the same size.
+ */
+size_t differences(const std::vector< uint8_t > &a, const std::vector< uint8_t > &b)
+{
+	size_t count = 0;
+	for(size_t i = 0; i < a.size(); ++i)
+		count += a[i] != b[i];
+
+	return count;
+}
+
+/**
+ * The variants supported by the CPU running the tests. The other ones are
+ * reported and skipped.
+ */
+std::vector< std::string > supported_variants()
+{
+	const std::vector< std::string > variants = NoiseKernels::get_variants();
+
+	std::vector< std::string > supported;
+	for(size_t v = 0; v < variants.size(); ++v)
+	{
+		if(NoiseKernels::select(variants[v]))
+			supported.push_back(variants[v]);
+		else
+			WARN("The " << variants[v] << " kernels are not supported by this CPU");
+	}
+
+	NoiseKernels::select("auto");
+	return supported;
+}
+
+} // anonymous namespace
+
+TEST_CASE("uniform kernels give the same image in every variant", "[kernels]")
+{
+	const std::vector< uint8_t > in = ramp(LENGTH);
+	const std::vector< std::string > variants = supported_variants();
+
+	for(size_t c = 0; c < sizeof(UNIFORM_CASES) / sizeof(UNIFORM_CASES[0]); ++c)
+	{
+		INFO("mean " << UNIFORM_CASES[c].mean << ", amplitude " << UNIFORM_CASES[c].amplitude);
+
+		REQUIRE(NoiseKernels::select("scalar"));
+		const std::vector< uint8_t > reference = uniform_kernel(in, UNIFORM_CASES[c]);
+
+		for(size_t v = 0; v < variants.size(); ++v)
+		{
+			INFO("variant " << variants[v]);
+			REQUIRE(NoiseKernels::select(variants[v]));
+			CHECK(differences(uniform_kernel(in, UNIFORM_CASES[c]), reference) == 0);
+		}
+	}
+
+	NoiseKernels::select("auto");
+}
+
+TEST_CASE("impulse kernels give the same image in every variant", "[kernels]")
+{
+	const std::vector< uint8_t > in = ramp(LENGTH);
+	const std::vector< std::string > variants = supported_variants();
+
+	for(size_t p = 0; p < sizeof(IMPULSE_PROBABILITIES) / sizeof(IMPULSE_PROBABILITIES[0]); ++p)
+	{
+		INFO("probability " << IMPULSE_PROBABILITIES[p]);
+
+		REQUIRE(NoiseKernels::select("scalar"));
+		const std::vector< uint8_t > reference = impulse_kernel(in, IMPULSE_PROBABILITIES[p], 10, 200);
+
+		for(size_t v = 0; v < variants.size(); ++v)
+		{
+			INFO("variant " << variants[v]);
+			REQUIRE(NoiseKernels::select(variants[v]));
+			CHECK(differences(impulse_kernel(in, IMPULSE_PROBABILITIES[p], 10, 200), reference) == 0);
+		}
+	}
+
+	NoiseKernels::select("auto");
+}
+
+TEST_CASE("uniform kernels give the same image with the noise field", "[kernels]")
+{
+	const std::vector< uint8_t > in = ramp(LENGTH);
+	const std::vector< std::string > variants = supported_variants();
+
+	for(size_t c = 0; c < sizeof(UNIFORM_CASES) / sizeof(UNIFORM_CASES[0]); ++c)
+	{
+		const UniformCase &uniform = UNIFORM_CASES[c];
+		const int low = static_cast< int >(uniform.mean - uniform.amplitude);
+
+		for(size_t v = 0; v < variants.size(); ++v)
+		{
+			INFO("mean " << uniform.mean << ", amplitude " << uniform.amplitude << ", variant " << variants[v]);
+			REQUIRE(NoiseKernels::select(variants[v]));
+
+			std::vector< float > noise;
+			const std::vector< uint8_t > out = uniform_kernel(in, uniform, &noise);
+			CHECK(differences(out, uniform_kernel(in, uniform)) == 0);
+
+			// The noise is the offset added before clamping.
+			size_t wrong = 0;
+			for(size_t i = 0; i < in.size(); ++i)
+			{
+				const int value = in[i] + static_cast< int >(noise[i]);
+				wrong += noise[i] < low || noise[i] >= low + 2.0 * uniform.amplitude
+				      || out[i] != (value < uniform.min ? uniform.min : (value > uniform.max ? uniform.max : value));
+			}
+			CHECK(wrong == 0);
+		}
+	}
+
+	NoiseKernels::select("auto");
+}
+
+TEST_CASE("impulse kernels give the same image with the selection", "[kernels]")
+{
+	const std::vector< uint8_t > in = ramp(LENGTH);
+	const std::vector< std::string > variants = supported_variants();
+
+	for(size_t p = 0; p < sizeof(IMPULSE_PROBABILITIES) / sizeof(IMPULSE_PROBABILITIES[0]); ++p)
+	{
+		for(size_t v = 0; v < variants.size(); ++v)
+		{
+			INFO("probability " << IMPULSE_PROBABILITIES[p] << ", variant " << variants[v]);
+			REQUIRE(NoiseKernels::select(variants[v]));
+
+			std::vector< float > selection;
+			const std::vector< uint8_t > out = impulse_kernel(in, IMPULSE_PROBABILITIES[p], 10, 200, &selection);
+			CHECK(differences(out, impulse_kernel(in, IMPULSE_PROBABILITIES[p], 10, 200)) == 0);
+
+			// The selected voxels are replaced, the other ones are kept.
+			size_t wrong = 0;
+			for(size_t i = 0; i < in.size(); ++i)
+			{
+				if(selection[i] == 1.0f)
+					wrong += out[i] != 10 && out[i] != 200;
+				else
+					wrong += selection[i] != 0.0f || out[i] != in[i];
+			}
+			CHECK(wrong == 0);
+		}
+	}
+
+	NoiseKernels::select("auto");
+}
+
+TEST_CASE("uniform kernels draw the distribution of the functor", "[kernels]")
+{
+	const uint8_t values[] = { 0, 128, 255 };
+
+	for(size_t c = 0; c < sizeof(UNIFORM_CASES) / sizeof(UNIFORM_CASES[0]); ++c)
+	{
+		for(size_t v = 0; v < sizeof(values) / sizeof(values[0]); ++v)
+		{
+			INFO("mean " << UNIFORM_CASES[c].mean << ", amplitude " << UNIFORM_CASES[c].amplitude << ", voxels " << int(values[v]));
+
+			const std::vector< uint8_t > in(SAMPLES, values[v]);
+			CHECK(NoiseHistograms::agree(NoiseHistograms::histogram(uniform_kernel(in, UNIFORM_CASES[c])),
+			                             NoiseHistograms::histogram(uniform_functor(in, UNIFORM_CASES[c]))));
+		}
+	}
+}
+
+TEST_CASE("impulse kernels draw the distribution of the functor", "[kernels]")
+{
+	const std::vector< uint8_t > in = ramp(SAMPLES);
+
+	for(size_t p = 0; p < sizeof(IMPULSE_PROBABILITIES) / sizeof(IMPULSE_PROBABILITIES[0]); ++p)
+	{
+		INFO("probability " << IMPULSE_PROBABILITIES[p]);
+
+		CHECK(NoiseHistograms::agree(NoiseHistograms::histogram(impulse_kernel(in, IMPULSE_PROBABILITIES[p], 0, 255)),
+		                             NoiseHistograms::histogram(impulse_functor(in, IMPULSE_PROBABILITIES[p], 0, 255))));
+	}
+}
@@ -0,0 +1,166 @@
+#include <catch2/catch.hpp>
+
+#include <vector>
+
+#include "itkAdditiveGaussianNoiseImageFilter.h"
+#include "itkAdditiveUniformNoiseImageFilter.h"
+#include "itkCameraNoiseImageFilter.h"
+#include "itkImpulseNoiseImageFilter.h"
+#include "itkMultiplicativeGaussianNoiseImageFilter.h"
+#include "itkPoissonNoiseImageFilter.h"
+#include "itkRicianNoiseImageFilter.h"
+#include "itkSparseAdditiveGaussianNoiseImageFilter.h"
+#include "itkSparseAdditiveUniformNoiseImageFilter.h"
+#include "itkSparseMultiplicativeGaussianNoiseImageFilter.h"
+#include "itkSparseSpeckleNoiseImageFilter.h"
+#include "itkSpeckleNoiseImageFilter.h"
+
+#include "noise_histograms.h"
+
+namespace {
+
+const uint64_t SEED = 4321;
+
+// Number of voxels of the histograms, for each input value.
+const size_t SAMPLES = 1000000;
+
+// Parameters of the tested functors. The functors with tables compute
+// them once the parameters are set.
+template< class TRealType >
+void setup(itk::Functor::AdditiveGaussianNoise< uint8_t, uint8_t, TRealType > &functor)
+{
+	functor.SetMean(0.0);
+	functor.SetStandardDeviation(20.0);
+}
+
+template< class TRealType >
+void setup(itk::Functor::SparseAdditiveGaussianNoise< uint8_t, uint8_t, TRealType > &functor)
+{
+	functor.SetProbability(0.2);
+	functor.SetMean(0.0);
+	functor.SetStandardDeviation(20.0);
+}
+
+template< class TRealType >
+void setup(itk::Functor::AdditiveUniformNoise< uint8_t, uint8_t, TRealType > &functor)
+{
+	functor.SetMean(0.0);
+	functor.SetAmplitude(30.5);
+}
+
+template< class TRealType >
+void setup(itk::Functor::SparseAdditiveUniformNoise< uint8_t, uint8_t, TRealType > &functor)
+{
+	functor.SetProbability(0.2);
+	functor.SetMean(0.0);
+	functor.SetAmplitude(30.5);
+}
+
+template< class TRealType >
+void setup(itk::Functor::ImpulseNoise< uint8_t, uint8_t, TRealType > &functor)
+{
+	functor.SetProbability(0.1);
+}
+
+template< class TRealType >
+void setup(itk::Functor::MultiplicativeGaussianNoise< uint8_t, uint8_t, TRealType > &functor)
+{
+	functor.SetMean(1.0);
+	functor.SetStandardDeviation(0.2);
+}
+
+template< class TRealType >
+void setup(itk::Functor::SparseMultiplicativeGaussianNoise< uint8_t, uint8_t, TRealType > &functor)
+{
+	functor.SetProbability(0.2);
+	functor.SetMean(1.0);
+	functor.SetStandardDeviation(0.2);
+}
+
+template< class TRealType >
+void setup(itk::Functor::PoissonNoise< uint8_t, uint8_t, TRealType > &functor)
+{
+	functor.SetScale(0.5);
+	functor.Initialize();
+}
+
+template< class TRealType >
+void setup(itk::Functor::RicianNoise< uint8_t, uint8_t, TRealType > &functor)
+{
+	functor.SetStandardDeviation(20.0);
+}
+
+template< class TRealType >
+void setup(itk::Functor::CameraNoise< uint8_t, uint8_t, TRealType > &functor)
+{
+	functor.SetGain(2.0);
+	functor.SetReadNoise(3.0);
+	functor.SetDarkOffset(10.0);
+	functor.Initialize();
+}
+
+template< class TRealType >
+void setup(itk::Functor::SpeckleNoise< uint8_t, uint8_t, TRealType > &functor)
+{
+	functor.SetLooks(4.0);
+}
+
+template< class TRealType >
+void setup(itk::Functor::SparseSpeckleNoise< uint8_t, uint8_t, TRealType > &functor)
+{
+	functor.SetProbability(0.2);
+	functor.SetLooks(4.0);
+}
+
+template< class TFunctor >
+NoiseHistograms::Histogram noise_histogram(const uint8_t value, const uint64_t stream)
+{
+	TFunctor functor;
+	setup(functor);
+
+	itk::Xoshiro256PlusPlusEngine engine;
+	engine.Seed(SEED, stream);
+
+	std::vector< uint8_t > out(SAMPLES);
+	for(size_t i = 0; i < SAMPLES; ++i)
+		out[i] = functor.template Evaluate< 0 >(value, engine);
+
+	return NoiseHistograms::histogram(out);
+}
+
+/**
+ * Whether a functor draws the same unsigned char histograms in single and
+ * double precision, for dark, mid and bright voxels. The two precisions use
+ * different streams, so that the test compares the distributions and not
+ * the rounding of the same draws.
+ */
+template< template< class, class, class > class TFunctor >
+void check_precisions()
+{
+	const uint8_t values[] = { 10, 128, 245 };
+
+	for(size_t v = 0; v < sizeof(values) / sizeof(values[0]); ++v)
+	{
+		INFO("voxels " << int(values[v]));
+		CHECK(NoiseHistograms::agree(noise_histogram< TFunctor< uint8_t, uint8_t, float > >(values[v], 0),
+		                             noise_histogram< TFunctor< uint8_t, uint8_t, double > >(values[v], 1)));
+	}
+}
+
+} // anonymous namespace
+
+TEST_CASE("float functors draw the distributions of the double ones", "[precision]")
+{
+	SECTION("gaussian") { check_precisions< itk::Functor::AdditiveGaussianNoise >(); }
+	SECTION("sparse-gaussian") { check_precisions< itk::Functor::SparseAdditiveGaussianNoise >(); }
+	SECTION("uniform") { check_precisions< itk::Functor::AdditiveUniformNoise >(); }
+	SECTION("sparse-uniform") { check_precisions< itk::Functor::SparseAdditiveUniformNoise >(); }
+	SECTION("impulse") { check_precisions< itk::Functor::ImpulseNoise >(); }
+	SECTION("mult-gaussian") { check_precisions< itk::Functor::MultiplicativeGaussianNoise >(); }
+	SECTION("sparse-mult-gaussian") { check_precisions< itk::Functor::SparseMultiplicativeGaussianNoise >(); }
+	SECTION("poisson") { check_precisions< itk::Functor::PoissonNoise >(); }
+	SECTION("rician") { check_precisions< itk::Functor::RicianNoise >(); }
+	SECTION("camera") { check_precisions< itk::Functor::CameraNoise >(); }
+	SECTION("speckle") { check_precisions< itk::Functor::SpeckleNoise >(); }
+	SECTION("sparse-speckle") { check_precisions< itk::Functor::SparseSpeckleNoise >(); }
+}
@@ -0,0 +1,101 @@
+#include "volume_allocator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+
+#include "itkMultiThreader.h"
+
+namespace {
+
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+const size_t CACHE_LINE_SIZE = 64;
+
+struct FirstTouchData
+{
+	char   *buffer;
+	size_t bytes;
+};
+
+ITK_THREAD_RETURN_TYPE first_touch_callback(void *arg)
+{
+	itk::MultiThreader::ThreadInfoStruct *info = static_cast< itk::MultiThreader::ThreadInfoStruct * >(arg);
+	const FirstTouchData *data = static_cast< const FirstTouchData * >(info->UserData);
+
+	// Same partitioning as the slow dimension splitter of the filters:
+	// contiguous chunks of (almost) equal size, one per thread.
+	const size_t chunk = (data->bytes + info->NumberOfThreads - 1) / info->NumberOfThreads;
+	const size_t begin = info->ThreadID * chunk;
+
+	if(begin < data->bytes)
+	{
+		const size_t end = std::min(begin + chunk, data->bytes);
+		std::memset(data->buffer + begin, 0, end - begin);
+	}
+
+	return ITK_THREAD_RETURN_VALUE;
+}
+
+} // anonymous namespace
+
+bool VolumeAllocator::huge_pages = false;
+bool VolumeAllocator::parallel_first_touch = false;
+
+void VolumeAllocator::configure(const bool hugePages, const bool parallelFirstTouch)
+{
+	huge_pages = hugePages;
+	parallel_first_touch = parallelFirstTouch;
+}
+
+bool VolumeAllocator::use_huge_pages()
+{
+	return huge_pages;
+}
+
+bool VolumeAllocator::use_parallel_first_touch()
+{
+	return parallel_first_touch;
+}
+
+void * VolumeAllocator::allocate(const size_t bytes)
+{
+	const bool large = bytes >= HUGE_PAGE_SIZE;
+
+	void *buffer = NULL;
+	if(0 != posix_memalign(&buffer, (large && huge_pages) ? HUGE_PAGE_SIZE : CACHE_LINE_SIZE, bytes > 0 ? bytes : 1))
+		throw std::bad_alloc();
+
+#ifdef MADV_HUGEPAGE
+	// Must be done before the first touch, otherwise the pages are already
+	// backed by 4KB frames.
+	if(large && huge_pages)
+		madvise(buffer, bytes, MADV_HUGEPAGE);
+#endif
+
+	if(large && parallel_first_touch)
+		first_touch(buffer, bytes);
+	else
+		std::memset(buffer, 0, bytes);
+
+	return buffer;
+}
+
+void VolumeAllocator::release(void *buffer)
+{
+	free(buffer);
+}
+
+void VolumeAllocator::first_touch(void *buffer, const size_t bytes)
+{
+	FirstTouchData data;
+	data.buffer = static_cast< char * >(buffer);
+	data.bytes = bytes;
+
+	itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+	threader->SetNumberOfThreads(itk::MultiThreader::GetGlobalDefaultNumberOfThreads());
+	threader->SetSingleMethod(first_touch_callback, &data);
+	threader->SingleMethodExecute();
+}
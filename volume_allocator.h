@@ -0,0 +1,48 @@
+#ifndef VOLUME_ALLOCATOR_H
+#define VOLUME_ALLOCATOR_H
+
+#include <cstddef>
+
+/**
+ * Allocates the pixel buffers of the processed volumes.
+ * Large buffers can be aligned on huge pages (and advised as such to the
+ * kernel) and first-touched in parallel, so that on NUMA machines each
+ * thread of the noise filters mostly works on memory local to its node.
+ */
+class VolumeAllocator
+{
+public:
+	/**
+	 * Set the allocation policy.
+	 * @param[in] hugePages Align large buffers on 2MB and madvise() them as huge pages.
+	 * @param[in] parallelFirstTouch Zero large buffers with one thread per slab.
+	 */
+	static void configure(const bool hugePages, const bool parallelFirstTouch);
+
+	static bool use_huge_pages();
+	static bool use_parallel_first_touch();
+
+	/**
+	 * Allocate a zero-initialized buffer.
+	 * @param[in] bytes The size of the buffer.
+	 * @return The buffer, to be freed with release(). Throws std::bad_alloc on failure.
+	 */
+	static void * allocate(const size_t bytes);
+
+	/**
+	 * Free a buffer obtained from allocate().
+	 */
+	static void release(void *buffer);
+
+private:
+	/**
+	 * Zero a buffer with as many threads as the filters use, each thread
+	 * touching the contiguous chunk it is the most likely to process.
+	 */
+	static void first_touch(void *buffer, const size_t bytes);
+
+	static bool huge_pages;
+	static bool parallel_first_touch;
+};
+
+#endif /* VOLUME_ALLOCATOR_H */